@@ -0,0 +1,37 @@
+// Host-side stand-in for Adafruit_MCP4728. Only the calls made by
+// ../src/drivers/MCP4728.cpp are provided; they go over the simulated Wire.
+#ifndef SIM_ADAFRUIT_MCP4728_H
+#define SIM_ADAFRUIT_MCP4728_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#define MCP4728_I2CADDR_DEFAULT 0x60
+#define MCP4728_MULTI_IR_CMD 0x40
+
+typedef enum { MCP4728_CHANNEL_A, MCP4728_CHANNEL_B, MCP4728_CHANNEL_C, MCP4728_CHANNEL_D } MCP4728_channel_t;
+typedef enum { MCP4728_VREF_VDD, MCP4728_VREF_INTERNAL } MCP4728_vref_t;
+typedef enum { MCP4728_GAIN_1X, MCP4728_GAIN_2X } MCP4728_gain_t;
+typedef enum {
+    MCP4728_PD_MODE_NORMAL,
+    MCP4728_PD_MODE_GND_1K,
+    MCP4728_PD_MODE_GND_100K,
+    MCP4728_PD_MODE_GND_500K
+} MCP4728_pd_mode_t;
+
+class Adafruit_MCP4728 {
+public:
+    bool begin(uint8_t i2c_address = MCP4728_I2CADDR_DEFAULT, TwoWire* wire = &Wire);
+    bool setChannelValue(MCP4728_channel_t channel, uint16_t new_value,
+                         MCP4728_vref_t new_vref = MCP4728_VREF_VDD,
+                         MCP4728_gain_t new_gain = MCP4728_GAIN_1X,
+                         MCP4728_pd_mode_t new_pd_mode = MCP4728_PD_MODE_NORMAL,
+                         bool udac = false);
+    uint16_t getChannelValue(MCP4728_channel_t channel);
+
+private:
+    uint8_t _address = MCP4728_I2CADDR_DEFAULT;
+    TwoWire* _wire = &Wire;
+};
+
+#endif // SIM_ADAFRUIT_MCP4728_H
@@ -0,0 +1,118 @@
+// Host-side stand-in for the Arduino core, just large enough for the
+// firmware in ../src and the sketches to compile and run on Linux.
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <string>
+
+#define HEX 16
+#define DEC 10
+#define OCT 8
+#define BIN 2
+
+#define F(str) (str)
+#define PROGMEM
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// Simulated clock. Time only advances through delay(), bus traffic and
+// the sim main loop, so every run is deterministic.
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+namespace sim {
+void advanceMicros(uint64_t us);
+uint64_t nowMicros();
+}
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int value, unsigned char base = DEC) : _s(toBase((long)value, base)) {}
+    String(unsigned int value, unsigned char base = DEC) : _s(toBaseU(value, base)) {}
+    String(long value, unsigned char base = DEC) : _s(toBase(value, base)) {}
+    String(unsigned long value, unsigned char base = DEC) : _s(toBaseU(value, base)) {}
+    String(float value, unsigned char decimals = 2) : _s(toFixed(value, decimals)) {}
+    String(double value, unsigned char decimals = 2) : _s(toFixed(value, decimals)) {}
+
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    const char* c_str() const { return _s.c_str(); }
+    char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    void toUpperCase();
+    void replace(const String& from, const String& to);
+
+    String& operator+=(const String& rhs) { _s += rhs._s; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a) + b._s); }
+    friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+    bool operator==(const String& rhs) const { return _s == rhs._s; }
+
+private:
+    std::string _s;
+    static std::string toBase(long value, unsigned char base);
+    static std::string toBaseU(unsigned long value, unsigned char base);
+    static std::string toFixed(double value, unsigned char decimals);
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(double v, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Serial backed by an in-memory input queue and stdout.
+class SimSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    // Sim-only: queue host input for the sketch to consume.
+    void feed(const char* data, size_t len);
+    size_t pendingInput() const;
+};
+
+extern SimSerial Serial;
+
+#endif // SIM_ARDUINO_H
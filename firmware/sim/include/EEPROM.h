@@ -0,0 +1,37 @@
+// Host-side stand-in for the AVR EEPROM library: 4 KB held in RAM, erased
+// (0xFF) at start, so what a run stores lasts until the process exits.
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+#include "Arduino.h"
+
+#define E2END 0xFFF
+
+class EEPROMClass {
+public:
+    EEPROMClass() { memset(_bytes, 0xFF, sizeof(_bytes)); }
+
+    uint8_t read(int address) { return _bytes[address]; }
+    void write(int address, uint8_t value) { _bytes[address] = value; }
+    void update(int address, uint8_t value) { _bytes[address] = value; }
+    uint16_t length() { return E2END + 1; }
+
+    template <typename T>
+    T& get(int address, T& value) {
+        memcpy(&value, _bytes + address, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value) {
+        memcpy(_bytes + address, &value, sizeof(T));
+        return value;
+    }
+
+private:
+    uint8_t _bytes[E2END + 1];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // SIM_EEPROM_H
@@ -0,0 +1,77 @@
+// Simulated I2C tree: a root segment, LTC4302 hubs that connect downstream
+// segments, and the leaf devices used by the TES/LNA cards.
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace sim {
+
+class Segment;
+
+class Device {
+public:
+    explicit Device(uint8_t address) : _address(address) {}
+    virtual ~Device() {}
+    uint8_t address() const { return _address; }
+
+    // Master write of `len` bytes. `stop` is false when a repeated start
+    // follows. Returning false NACKs the data phase.
+    virtual bool onWrite(const uint8_t* data, size_t len, bool stop) = 0;
+    // Master read; fill up to `len` bytes and return how many were sent.
+    virtual size_t onRead(uint8_t* data, size_t len) = 0;
+    // Hubs expose their downstream segment while connected.
+    virtual Segment* downstream() { return nullptr; }
+
+private:
+    uint8_t _address;
+};
+
+class Segment {
+public:
+    void attach(Device* device) { _devices.push_back(device); }
+    const std::vector<Device*>& devices() const { return _devices; }
+
+private:
+    std::vector<Device*> _devices;
+};
+
+struct BusStats {
+    uint64_t transactions = 0;
+    uint64_t bytes = 0;
+    uint64_t busMicros = 0;
+    uint64_t nacks = 0;
+    uint64_t collisions = 0;
+};
+
+class Bus {
+public:
+    Segment& root() { return _root; }
+    // Resolve an address through every connected hub. Reports how many
+    // devices answered so overlapping routes show up as collisions.
+    Device* resolve(uint8_t address, size_t& responders);
+
+    void setClock(uint32_t hz) { _clockHz = hz; }
+    // Account for one transaction of `bytes` payload bytes (address byte
+    // and start/stop bits are added here) and advance the sim clock.
+    void account(size_t bytes, bool acked);
+    void noteCollision() { _stats.collisions++; }
+
+    const BusStats& stats() const { return _stats; }
+    void resetStats() { _stats = BusStats(); }
+
+private:
+    void collect(Segment& segment, uint8_t address, Device*& first, size_t& count, int depth);
+
+    Segment _root;
+    uint32_t _clockHz = 100000;
+    BusStats _stats;
+};
+
+Bus& bus();
+
+} // namespace sim
+
+#endif // SIM_BUS_H
@@ -0,0 +1,44 @@
+// Builds a simulated crate (base hub, TES cards, LNA cards) on the sim bus
+// and runs a sketch's setup()/loop() against commands read from stdin.
+#ifndef SIM_CRATE_H
+#define SIM_CRATE_H
+
+#include "SimDevices.h"
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace sim {
+
+class Crate {
+public:
+    // Addresses listed here are left unpopulated (simulated empty slots).
+    void setAbsent(const std::set<uint8_t>& absent) { _absent = absent; }
+
+    void addBaseHub(uint8_t hubAddress, uint8_t dacAddress);
+    // TES card: LTC4302 hub with a TCA6424 at 0x22 and an INA219 at 0x40.
+    // The bias current falls from full scale as the 20 TCA bits are set.
+    void addTesCard(uint8_t hubAddress);
+    // LNA card: LTC4302 hub with an MCP4728 at 0x60 and INA219s at 0x40
+    // (drain) and 0x41 (gate), each following its DAC channel.
+    void addLnaCard(uint8_t hubAddress);
+
+    LTC4302Model* hub(uint8_t address);
+
+private:
+    template <typename T, typename... A> T* make(A&&... args);
+
+    Segment* _cardBus = nullptr;
+    std::vector<std::unique_ptr<Device>> _devices;
+    std::vector<LTC4302Model*> _hubs;
+    std::set<uint8_t> _absent;
+};
+
+// Parse sim options, populate the crate through `build`, run setup(), then
+// feed stdin to the sketch one line at a time and report the bus traffic of
+// each command on stderr.
+int run(int argc, char** argv, void (*build)(Crate&), void (*setupFn)(), void (*loopFn)());
+
+} // namespace sim
+
+#endif // SIM_CRATE_H
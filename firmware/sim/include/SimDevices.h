@@ -0,0 +1,94 @@
+// Behavioural models of the parts on the TES/LNA cards. They implement the
+// register-level protocol the drivers in ../src use, not the full datasheets.
+#ifndef SIM_DEVICES_H
+#define SIM_DEVICES_H
+
+#include "SimBus.h"
+#include <functional>
+
+namespace sim {
+
+// LTC4302 bus repeater. A single-byte write with STOP sets the control
+// register (bit 7 connects downstream, bits 5/6 drive GPIO1/GPIO2); a
+// single-byte write followed by a repeated start is a register pointer.
+class LTC4302Model : public Device {
+public:
+    explicit LTC4302Model(uint8_t address) : Device(address) {}
+    bool onWrite(const uint8_t* data, size_t len, bool stop) override;
+    size_t onRead(uint8_t* data, size_t len) override;
+    Segment* downstream() override { return connected() ? &_downstream : nullptr; }
+
+    Segment& bus() { return _downstream; }
+    bool connected() const { return (_control & 0x80) != 0; }
+    bool gpio(uint8_t pin) const { return (_control & (pin == 1 ? 0x20 : 0x40)) != 0; }
+    uint8_t control() const { return _control; }
+    // Simulate a brown-out/external reset of the part.
+    void reset() { _control = 0x60; }
+
+private:
+    Segment _downstream;
+    uint8_t _control = 0x60;
+};
+
+// TCA6424 24-bit I/O expander. Bit 7 of the command byte enables
+// auto-increment, which wraps within each 3-register bank.
+class TCA6424Model : public Device {
+public:
+    explicit TCA6424Model(uint8_t address) : Device(address) {}
+    bool onWrite(const uint8_t* data, size_t len, bool stop) override;
+    size_t onRead(uint8_t* data, size_t len) override;
+
+    uint32_t outputs() const {
+        return (uint32_t)_regs[4] | ((uint32_t)_regs[5] << 8) | ((uint32_t)_regs[6] << 16);
+    }
+
+private:
+    void advance();
+
+    uint8_t _regs[16] = {0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0};
+    uint8_t _pointer = 0;
+    bool _autoIncrement = false;
+};
+
+// INA219 current/power monitor. The load callback returns the current
+// through the shunt in amps and the bus voltage in volts.
+class INA219Model : public Device {
+public:
+    typedef std::function<void(double& amps, double& volts)> Load;
+
+    INA219Model(uint8_t address, double shuntOhms, Load load)
+        : Device(address), _shuntOhms(shuntOhms), _load(load) {}
+    bool onWrite(const uint8_t* data, size_t len, bool stop) override;
+    size_t onRead(uint8_t* data, size_t len) override;
+
+private:
+    uint16_t registerValue(uint8_t reg);
+    uint32_t conversionMicros() const;
+    bool triggered() const { return (_config & 0x07) >= 1 && (_config & 0x07) <= 3; }
+
+    double _shuntOhms;
+    Load _load;
+    uint16_t _config = 0x399F;
+    uint16_t _calibration = 0;
+    uint8_t _pointer = 0;
+    uint64_t _conversionStart = 0;
+    bool _conversionRead = false;
+};
+
+// MCP4728 quad DAC: multi-write commands and the 24-byte status read.
+class MCP4728Model : public Device {
+public:
+    explicit MCP4728Model(uint8_t address) : Device(address) {}
+    bool onWrite(const uint8_t* data, size_t len, bool stop) override;
+    size_t onRead(uint8_t* data, size_t len) override;
+
+    uint16_t value(uint8_t channel) const { return _value[channel & 3]; }
+
+private:
+    uint16_t _value[4] = {0, 0, 0, 0};
+    uint8_t _config[4] = {0, 0, 0, 0};
+};
+
+} // namespace sim
+
+#endif // SIM_DEVICES_H
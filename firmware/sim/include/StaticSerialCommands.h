@@ -0,0 +1,118 @@
+// Host-side stand-in for the StaticSerialCommands library: the same
+// COMMAND/ARG table syntax, a whitespace tokenizer, nested subcommands and
+// argument range checks, so the sketch command tables build unchanged.
+#ifndef SIM_STATIC_SERIAL_COMMANDS_H
+#define SIM_STATIC_SERIAL_COMMANDS_H
+
+#include "Arduino.h"
+#include <utility>
+
+#define SIM_COMMAND_MAX_ARGS 4
+#define SIM_ARGS_MAX 8
+
+enum class ArgType { Null, Int, Float, String };
+
+struct CommandArg {
+    ArgType type;
+    float min;
+    float max;
+    const char* name;
+    constexpr CommandArg() : type(ArgType::Null), min(0), max(0), name(nullptr) {}
+    constexpr CommandArg(ArgType t, const char* n) : type(t), min(0), max(0), name(n) {}
+    constexpr CommandArg(ArgType t, float lo, float hi, const char* n) : type(t), min(lo), max(hi), name(n) {}
+};
+
+#define ARG(...) CommandArg(__VA_ARGS__)
+
+class Arg {
+public:
+    long getInt() const { return _int; }
+    float getFloat() const { return _float; }
+    const char* getString() const { return _string; }
+
+private:
+    friend class SerialCommands;
+    long _int = 0;
+    float _float = 0;
+    const char* _string = "";
+};
+
+class Args {
+public:
+    Arg& operator[](size_t i) { return _args[i < SIM_ARGS_MAX ? i : SIM_ARGS_MAX - 1]; }
+    size_t size() const { return _count; }
+
+private:
+    friend class SerialCommands;
+    Arg _args[SIM_ARGS_MAX];
+    size_t _count = 0;
+};
+
+class SerialCommands;
+
+struct Command {
+    void (*callback)(SerialCommands&, Args&) = nullptr;
+    const char* name = nullptr;
+    CommandArg args[SIM_COMMAND_MAX_ARGS];
+    uint8_t argCount = 0;
+    const Command* subCommands = nullptr;
+    uint16_t subCommandCount = 0;
+    const char* description = nullptr;
+};
+
+namespace sim {
+inline void collectCommand(Command& c, std::nullptr_t, const char* description) {
+    c.description = description;
+}
+template <size_t N>
+inline void collectCommand(Command& c, Command (&subCommands)[N], const char* description) {
+    c.subCommands = subCommands;
+    c.subCommandCount = N;
+    c.description = description;
+}
+template <typename... Rest>
+inline void collectCommand(Command& c, const CommandArg& arg, Rest&&... rest) {
+    if (c.argCount < SIM_COMMAND_MAX_ARGS) c.args[c.argCount++] = arg;
+    collectCommand(c, std::forward<Rest>(rest)...);
+}
+template <typename... Rest>
+inline Command makeCommand(void (*callback)(SerialCommands&, Args&), const char* name, Rest&&... rest) {
+    Command c;
+    c.callback = callback;
+    c.name = name;
+    collectCommand(c, std::forward<Rest>(rest)...);
+    return c;
+}
+} // namespace sim
+
+#define COMMAND(callback, name, ...) sim::makeCommand(callback, name, __VA_ARGS__)
+
+class SerialCommands {
+public:
+    SerialCommands(Stream& serial, Command* commands, uint16_t commandCount,
+                   char* buffer = nullptr, uint16_t bufferSize = 0,
+                   char delimiter = ' ', char terminator = '\n');
+
+    void readSerial();
+    Stream& getSerial() { return _serial; }
+    void listCommands() { listAllCommands(_commands, _commandCount); }
+    void listAllCommands(Command* commands, uint16_t commandCount);
+
+private:
+    void execute(char* line);
+    void listLevel(const Command* commands, uint16_t count, int depth);
+    bool parseArg(const CommandArg& spec, char* token, Arg& out);
+
+    Stream& _serial;
+    Command* _commands;
+    uint16_t _commandCount;
+    char _ownBuffer[64];
+    char* _buffer;
+    uint16_t _bufferSize;
+    uint16_t _length = 0;
+    bool _overflow = false;
+    char _delimiter;
+    char _terminator;
+};
+
+#endif // SIM_STATIC_SERIAL_COMMANDS_H
@@ -0,0 +1,47 @@
+// Host-side stand-in for the Arduino Wire library. Transactions are routed
+// to the behavioural device models in SimBus.h.
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include "Arduino.h"
+
+#define SIM_WIRE_BUFFER_LENGTH 32
+
+class TwoWire : public Stream {
+public:
+    void begin() {}
+    void setClock(uint32_t hz);
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t endTransmission(uint8_t sendStop) { return endTransmission(sendStop != 0); }
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = 1);
+    uint8_t requestFrom(uint8_t address, size_t quantity, bool sendStop = true) {
+        return requestFrom(address, (uint8_t)quantity, (uint8_t)sendStop);
+    }
+    uint8_t requestFrom(int address, int quantity, int sendStop = 1) {
+        return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop);
+    }
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* data, size_t quantity) override;
+    using Print::write;
+    int available() override { return (int)(_rxLength - _rxIndex); }
+    int read() override { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1; }
+    int peek() override { return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1; }
+
+private:
+    uint8_t _txAddress = 0;
+    uint8_t _txBuffer[SIM_WIRE_BUFFER_LENGTH];
+    size_t _txLength = 0;
+    bool _txOverflow = false;
+    uint8_t _rxBuffer[SIM_WIRE_BUFFER_LENGTH];
+    size_t _rxLength = 0;
+    size_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,15 @@
+// Host build of LNA_Controller.ino against the simulated crate.
+#include "Arduino.h"
+#include "SimCrate.h"
+#include <StaticSerialCommands.h>
+
+#include "../../LNA_Controller/LNA_Controller.ino"
+
+static void buildCrate(sim::Crate& crate) {
+    crate.addBaseHub(BASE_HUB_LTC4302_ADDR, BASE_HUB_MCP4728_ADDR);
+    for (int i = 0; i < NUM_LNA; ++i) crate.addLnaCard(lnaCards[i].hub);
+}
+
+int main(int argc, char** argv) {
+    return sim::run(argc, argv, buildCrate, setup, loop);
+}
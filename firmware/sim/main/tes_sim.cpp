@@ -0,0 +1,16 @@
+// Host build of TES_Controller.ino against the simulated crate.
+#include "Arduino.h"
+#include "SimCrate.h"
+#include <StaticSerialCommands.h>
+
+#include "../../TES_Controller/TES_Controller.ino"
+
+static void buildCrate(sim::Crate& crate) {
+    crate.addBaseHub(BASE_HUB_LTC4302_ADDR, BASE_HUB_MCP4728_ADDR);
+    for (int i = 0; i < NUM_TES; ++i) crate.addTesCard(tesCards[i].hub);
+    for (int i = 0; i < NUM_LNA; ++i) crate.addLnaCard(lnaCards[i].hub);
+}
+
+int main(int argc, char** argv) {
+    return sim::run(argc, argv, buildCrate, setup, loop);
+}
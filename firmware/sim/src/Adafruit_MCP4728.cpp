@@ -0,0 +1,31 @@
+#include "Adafruit_MCP4728.h"
+
+bool Adafruit_MCP4728::begin(uint8_t i2c_address, TwoWire* wire) {
+    _address = i2c_address;
+    _wire = wire;
+    _wire->beginTransmission(_address);
+    return _wire->endTransmission() == 0;
+}
+
+bool Adafruit_MCP4728::setChannelValue(MCP4728_channel_t channel, uint16_t new_value,
+                                       MCP4728_vref_t new_vref, MCP4728_gain_t new_gain,
+                                       MCP4728_pd_mode_t new_pd_mode, bool udac) {
+    uint8_t buffer[3];
+    buffer[0] = MCP4728_MULTI_IR_CMD | ((uint8_t)channel << 1) | (udac ? 1 : 0);
+    buffer[1] = (uint8_t)(((uint8_t)new_vref << 7) | ((uint8_t)new_pd_mode << 5) |
+                          ((uint8_t)new_gain << 4) | ((new_value >> 8) & 0x0F));
+    buffer[2] = (uint8_t)(new_value & 0xFF);
+    _wire->beginTransmission(_address);
+    _wire->write(buffer, 3);
+    return _wire->endTransmission() == 0;
+}
+
+uint16_t Adafruit_MCP4728::getChannelValue(MCP4728_channel_t channel) {
+    // The device streams 6 bytes per channel: 3 for the input register,
+    // 3 for its EEPROM copy.
+    uint8_t buffer[24];
+    if (_wire->requestFrom(_address, (uint8_t)24) != 24) return 0;
+    for (uint8_t i = 0; i < 24; ++i) buffer[i] = (uint8_t)_wire->read();
+    uint8_t offset = (uint8_t)channel * 6;
+    return (uint16_t)(((buffer[offset + 1] & 0x0F) << 8) | buffer[offset + 2]);
+}
@@ -0,0 +1,113 @@
+#include "Arduino.h"
+#include "EEPROM.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <deque>
+
+SimSerial Serial;
+EEPROMClass EEPROM;
+
+namespace {
+uint64_t g_micros = 0;
+std::deque<uint8_t> g_serialInput;
+}
+
+namespace sim {
+void advanceMicros(uint64_t us) { g_micros += us; }
+uint64_t nowMicros() { return g_micros; }
+}
+
+unsigned long millis() { return (unsigned long)(g_micros / 1000u); }
+unsigned long micros() { return (unsigned long)g_micros; }
+void delay(unsigned long ms) { g_micros += (uint64_t)ms * 1000u; }
+void delayMicroseconds(unsigned int us) { g_micros += us; }
+
+// ---- String -----------------------------------------------------------------
+
+std::string String::toBase(long value, unsigned char base) {
+    if (base == DEC) return std::to_string(value);
+    return toBaseU((unsigned long)value, base);
+}
+
+std::string String::toBaseU(unsigned long value, unsigned char base) {
+    if (base < 2) base = DEC;
+    if (value == 0) return "0";
+    std::string out;
+    while (value) {
+        unsigned digit = value % base;
+        out.push_back((char)(digit < 10 ? '0' + digit : 'a' + digit - 10));
+        value /= base;
+    }
+    std::reverse(out.begin(), out.end());
+    return out;
+}
+
+std::string String::toFixed(double value, unsigned char decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    return buf;
+}
+
+void String::toUpperCase() {
+    for (size_t i = 0; i < _s.size(); ++i) {
+        if (_s[i] >= 'a' && _s[i] <= 'z') _s[i] = (char)(_s[i] - 'a' + 'A');
+    }
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from._s.empty()) return;
+    size_t pos = 0;
+    while ((pos = _s.find(from._s, pos)) != std::string::npos) {
+        _s.replace(pos, from._s.size(), to._s);
+        pos += to._s.size();
+    }
+}
+
+// ---- Print ------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::print(long v, int base) {
+    return print(String(v, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long v, int base) {
+    return print(String(v, (unsigned char)base));
+}
+
+size_t Print::print(double v, int digits) {
+    return print(String(v, (unsigned char)digits));
+}
+
+// ---- Serial -----------------------------------------------------------------
+
+int SimSerial::available() { return (int)g_serialInput.size(); }
+
+int SimSerial::read() {
+    if (g_serialInput.empty()) return -1;
+    int c = g_serialInput.front();
+    g_serialInput.pop_front();
+    return c;
+}
+
+int SimSerial::peek() { return g_serialInput.empty() ? -1 : g_serialInput.front(); }
+
+size_t SimSerial::write(uint8_t c) {
+    fputc(c, stdout);
+    return 1;
+}
+
+size_t SimSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void SimSerial::feed(const char* data, size_t len) {
+    g_serialInput.insert(g_serialInput.end(), data, data + len);
+}
+
+size_t SimSerial::pendingInput() const { return g_serialInput.size(); }
@@ -0,0 +1,42 @@
+#include "SimBus.h"
+#include "Arduino.h"
+
+namespace sim {
+
+Bus& bus() {
+    static Bus instance;
+    return instance;
+}
+
+void Bus::collect(Segment& segment, uint8_t address, Device*& first, size_t& count, int depth) {
+    if (depth > 8) return;
+    for (Device* device : segment.devices()) {
+        if (device->address() == address) {
+            if (!first) first = device;
+            count++;
+        }
+        if (Segment* next = device->downstream()) {
+            collect(*next, address, first, count, depth + 1);
+        }
+    }
+}
+
+Device* Bus::resolve(uint8_t address, size_t& responders) {
+    Device* first = nullptr;
+    responders = 0;
+    collect(_root, address, first, responders, 0);
+    return first;
+}
+
+void Bus::account(size_t bytes, bool acked) {
+    // START + address byte + payload bytes (8 data bits + ACK each) + STOP.
+    uint64_t bits = 1 + 9 * (1 + bytes) + 1;
+    uint64_t us = (bits * 1000000u + _clockHz - 1) / _clockHz;
+    _stats.transactions++;
+    _stats.bytes += bytes;
+    _stats.busMicros += us;
+    if (!acked) _stats.nacks++;
+    advanceMicros(us);
+}
+
+} // namespace sim
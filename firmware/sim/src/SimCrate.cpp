@@ -0,0 +1,197 @@
+#include "SimCrate.h"
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <string>
+
+namespace sim {
+
+namespace {
+const uint8_t kTesTcaAddress = 0x22;
+const uint8_t kTesInaAddress = 0x40;
+const uint8_t kLnaDacAddress = 0x60;
+const uint8_t kLnaDrainInaAddress = 0x40;
+const uint8_t kLnaGateInaAddress = 0x41;
+const uint32_t kLoopMicros = 100;   // simulated cost of one idle loop()
+}
+
+template <typename T, typename... A>
+T* Crate::make(A&&... args) {
+    T* device = new T(std::forward<A>(args)...);
+    _devices.emplace_back(device);
+    return device;
+}
+
+LTC4302Model* Crate::hub(uint8_t address) {
+    for (LTC4302Model* h : _hubs) {
+        if (h->address() == address) return h;
+    }
+    return nullptr;
+}
+
+void Crate::addBaseHub(uint8_t hubAddress, uint8_t dacAddress) {
+    LTC4302Model* base = make<LTC4302Model>(hubAddress);
+    _hubs.push_back(base);
+    bus().root().attach(base);
+    base->bus().attach(make<MCP4728Model>(dacAddress));
+    _cardBus = &base->bus();
+}
+
+void Crate::addTesCard(uint8_t hubAddress) {
+    if (_absent.count(hubAddress) || !_cardBus) return;
+    LTC4302Model* hub = make<LTC4302Model>(hubAddress);
+    _hubs.push_back(hub);
+    _cardBus->attach(hub);
+    TCA6424Model* tca = make<TCA6424Model>(kTesTcaAddress);
+    hub->bus().attach(tca);
+    // Binary-weighted current steering with a small, fixed per-bit mismatch
+    // (+/-0.4%) so calibration and search paths see realistic hardware.
+    hub->bus().attach(make<INA219Model>(kTesInaAddress, 10.0, [tca, hubAddress](double& amps, double& volts) {
+        uint32_t code = tca->outputs() & 0xFFFFFu;
+        double removed = 0;
+        for (int bit = 0; bit < 20; ++bit) {
+            if (code & (1u << bit)) {
+                double mismatch = 1.0 + 0.004 * (((bit * 7 + hubAddress) % 5) - 2) / 2.0;
+                removed += (double)(1u << bit) * mismatch;
+            }
+        }
+        double fraction = 1.0 - removed / 1048576.0;
+        if (fraction < 0) fraction = 0;
+        amps = 0.020 * fraction;
+        volts = 1.0 + 50.0 * amps;
+    }));
+}
+
+void Crate::addLnaCard(uint8_t hubAddress) {
+    if (_absent.count(hubAddress) || !_cardBus) return;
+    LTC4302Model* hub = make<LTC4302Model>(hubAddress);
+    _hubs.push_back(hub);
+    _cardBus->attach(hub);
+    MCP4728Model* dac = make<MCP4728Model>(kLnaDacAddress);
+    hub->bus().attach(dac);
+    // Drain: up to 40 mA / 2 V at full scale. Gate: up to -5 mA / 3 V.
+    hub->bus().attach(make<INA219Model>(kLnaDrainInaAddress, 5.0, [dac, hub](double& amps, double& volts) {
+        double x = hub->gpio(2) ? 0.0 : dac->value(0) / 4095.0;
+        amps = 0.040 * x * x;
+        volts = 2.0 * x;
+    }));
+    hub->bus().attach(make<INA219Model>(kLnaGateInaAddress, 5.0, [dac, hub](double& amps, double& volts) {
+        double x = hub->gpio(1) ? 0.0 : dac->value(1) / 4095.0;
+        amps = -0.005 * x;
+        volts = 3.0 * x;
+    }));
+}
+
+namespace {
+
+void runLoop(void (*loopFn)(), uint64_t untilMicros) {
+    do {
+        loopFn();
+        advanceMicros(kLoopMicros);
+    } while (nowMicros() < untilMicros || Serial.pendingInput() > 0);
+}
+
+void report(const std::string& label, const BusStats& before, const BusStats& after, uint64_t elapsed) {
+    fprintf(stderr, "[sim] %-28s %6llu tx %7llu B %9.3f ms bus %9.3f ms total %llu nack %llu collision\n",
+            label.c_str(),
+            (unsigned long long)(after.transactions - before.transactions),
+            (unsigned long long)(after.bytes - before.bytes),
+            (after.busMicros - before.busMicros) / 1000.0,
+            elapsed / 1000.0,
+            (unsigned long long)(after.nacks - before.nacks),
+            (unsigned long long)(after.collisions - before.collisions));
+}
+
+std::set<uint8_t> parseAddressList(const char* list) {
+    std::set<uint8_t> out;
+    std::string s(list);
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t comma = s.find(',', pos);
+        std::string token = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (!token.empty()) out.insert((uint8_t)strtoul(token.c_str(), nullptr, 0));
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return out;
+}
+
+} // namespace
+
+int run(int argc, char** argv, void (*build)(Crate&), void (*setupFn)(), void (*loopFn)()) {
+    Crate crate;
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--absent=", 0) == 0) {
+            crate.setAbsent(parseAddressList(arg.c_str() + 9));
+        } else if (arg.rfind("--clock=", 0) == 0) {
+            bus().setClock((uint32_t)strtoul(arg.c_str() + 8, nullptr, 0));
+        } else if (arg == "--quiet") {
+            quiet = true;
+        } else {
+            fprintf(stderr, "usage: %s [--absent=0x64,0x65] [--clock=HZ] [--quiet] < commands\n", argv[0]);
+            return 2;
+        }
+    }
+    build(crate);
+
+    BusStats before = bus().stats();
+    uint64_t start = nowMicros();
+    setupFn();
+    if (!quiet) report("setup()", before, bus().stats(), nowMicros() - start);
+
+    char line[512];
+    while (fgets(line, sizeof(line), stdin)) {
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+        if (text.empty()) continue;
+
+        before = bus().stats();
+        start = nowMicros();
+        if (text[0] == '#') {
+            // Directives: "#advance <ms>" runs loop() for simulated time,
+            // "#reset <hub>" power-cycles one LTC4302; anything else is a comment.
+            if (text.rfind("#advance", 0) == 0) {
+                runLoop(loopFn, nowMicros() + (uint64_t)strtoul(text.c_str() + 8, nullptr, 0) * 1000u);
+                if (!quiet) report(text, before, bus().stats(), nowMicros() - start);
+            } else if (text.rfind("#reset", 0) == 0) {
+                LTC4302Model* h = crate.hub((uint8_t)strtoul(text.c_str() + 6, nullptr, 0));
+                if (h) h->reset();
+            } else if (text.rfind("#hex", 0) == 0) {
+                // Raw bytes for the binary protocol, e.g. "#hex 03 01 07 ... 00"
+                std::string bytes;
+                char* p = &text[4];
+                for (;;) {
+                    char* end;
+                    unsigned long b = strtoul(p, &end, 16);
+                    if (end == p) break;
+                    bytes.push_back((char)b);
+                    p = end;
+                }
+                Serial.feed(bytes.data(), bytes.size());
+                runLoop(loopFn, nowMicros());
+                fflush(stdout);
+                if (!quiet) report(text.substr(0, 40), before, bus().stats(), nowMicros() - start);
+            }
+            continue;
+        }
+        text += "\n";
+        Serial.feed(text.c_str(), text.size());
+        runLoop(loopFn, nowMicros());
+        fflush(stdout);
+        if (!quiet) {
+            text.pop_back();
+            report(text, before, bus().stats(), nowMicros() - start);
+        }
+    }
+
+    const BusStats& total = bus().stats();
+    fprintf(stderr, "[sim] total: %llu tx, %llu B, %.3f ms bus, %llu nack, %llu collision, %.3f ms simulated\n",
+            (unsigned long long)total.transactions, (unsigned long long)total.bytes,
+            total.busMicros / 1000.0, (unsigned long long)total.nacks,
+            (unsigned long long)total.collisions, nowMicros() / 1000.0);
+    return 0;
+}
+
+} // namespace sim
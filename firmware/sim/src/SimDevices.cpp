@@ -0,0 +1,171 @@
+#include "SimDevices.h"
+#include "Arduino.h"
+
+namespace sim {
+
+// ---- LTC4302 ------------------------------------------------------------------
+
+bool LTC4302Model::onWrite(const uint8_t* data, size_t len, bool stop) {
+    if (len == 0) return true;   // address probe
+    if (!stop) return true;      // register pointer ahead of a read
+    _control = (uint8_t)((_control & 0x1F) | (data[len - 1] & 0xE0));
+    return true;
+}
+
+size_t LTC4302Model::onRead(uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) data[i] = _control;
+    return len;
+}
+
+// ---- TCA6424 ------------------------------------------------------------------
+
+void TCA6424Model::advance() {
+    if (!_autoIncrement) return;
+    uint8_t bank = _pointer & 0x0C;
+    uint8_t index = (uint8_t)((_pointer & 0x03) + 1);
+    if (index > 2) index = 0;
+    _pointer = (uint8_t)(bank | index);
+}
+
+bool TCA6424Model::onWrite(const uint8_t* data, size_t len, bool stop) {
+    (void)stop;
+    if (len == 0) return true;
+    _pointer = data[0] & 0x0F;
+    _autoIncrement = (data[0] & 0x80) != 0;
+    for (size_t i = 1; i < len; ++i) {
+        // Input port registers are read-only.
+        if (_pointer > 0x02) _regs[_pointer] = data[i];
+        advance();
+    }
+    return true;
+}
+
+size_t TCA6424Model::onRead(uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t reg = _pointer;
+        // Inputs mirror the outputs: every pin on the cards is driven.
+        if (reg <= 0x02) reg = (uint8_t)(reg + 4);
+        data[i] = _regs[reg];
+        advance();
+    }
+    return len;
+}
+
+// ---- INA219 -------------------------------------------------------------------
+
+namespace {
+uint32_t adcMicros(uint8_t setting) {
+    static const uint32_t averaged[8] = {532, 1060, 2130, 4260, 8510, 17020, 34050, 68100};
+    if (setting & 0x08) return averaged[setting & 0x07];
+    static const uint32_t resolution[4] = {84, 148, 276, 532};
+    return resolution[setting & 0x03];
+}
+}
+
+uint32_t INA219Model::conversionMicros() const {
+    uint8_t mode = _config & 0x07;
+    uint32_t total = 0;
+    if (mode & 0x01) total += adcMicros((uint8_t)((_config >> 3) & 0x0F));
+    if (mode & 0x02) total += adcMicros((uint8_t)((_config >> 7) & 0x0F));
+    return total;
+}
+
+bool INA219Model::onWrite(const uint8_t* data, size_t len, bool stop) {
+    (void)stop;
+    if (len == 0) return true;
+    _pointer = data[0];
+    if (len < 3) return true;
+    uint16_t value = (uint16_t)((data[1] << 8) | data[2]);
+    if (_pointer == 0x00) {
+        if (value & 0x8000) {
+            _config = 0x399F;
+            _calibration = 0;
+        } else {
+            _config = value;
+        }
+        _conversionStart = nowMicros();
+        _conversionRead = false;
+    } else if (_pointer == 0x05) {
+        _calibration = (uint16_t)(value & 0xFFFE);
+    }
+    return true;
+}
+
+uint16_t INA219Model::registerValue(uint8_t reg) {
+    double amps = 0, volts = 0;
+    if (_load) _load(amps, volts);
+
+    double shuntRaw = amps * _shuntOhms / 10e-6;
+    if (shuntRaw > 32000) shuntRaw = 32000;
+    if (shuntRaw < -32000) shuntRaw = -32000;
+    int16_t shunt = (int16_t)lround(shuntRaw);
+    uint16_t busRaw = (uint16_t)lround((volts < 0 ? -volts : volts) / 4e-3);
+    int16_t current = (int16_t)(((int32_t)shunt * _calibration) / 4096);
+    uint16_t power = (uint16_t)(((int32_t)(current < 0 ? -current : current) * busRaw) / 5000);
+    bool ready = !_conversionRead && (nowMicros() - _conversionStart) >= conversionMicros();
+
+    switch (reg) {
+        case 0x00: return _config;
+        case 0x01: return (uint16_t)shunt;
+        case 0x02: return (uint16_t)((busRaw << 3) | (ready ? 0x02 : 0x00));
+        case 0x03:
+            // Reading power clears CNVR; continuous modes start over.
+            if ((_config & 0x07) >= 5) _conversionStart = nowMicros();
+            else _conversionRead = true;
+            return power;
+        case 0x04: return (uint16_t)current;
+        case 0x05: return _calibration;
+        default: return 0;
+    }
+}
+
+size_t INA219Model::onRead(uint8_t* data, size_t len) {
+    uint16_t value = registerValue(_pointer);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = (i % 2 == 0) ? (uint8_t)(value >> 8) : (uint8_t)(value & 0xFF);
+    }
+    return len;
+}
+
+// ---- MCP4728 ------------------------------------------------------------------
+
+bool MCP4728Model::onWrite(const uint8_t* data, size_t len, bool stop) {
+    (void)stop;
+    if (len == 0) return true;
+    if ((data[0] & 0xF8) == 0x40) {
+        // Multi-write: repeated (command, config|hi, lo) triplets.
+        for (size_t i = 0; i + 2 < len; i += 3) {
+            uint8_t channel = (uint8_t)((data[i] >> 1) & 0x03);
+            _config[channel] = (uint8_t)(data[i + 1] & 0xF0);
+            _value[channel] = (uint16_t)(((data[i + 1] & 0x0F) << 8) | data[i + 2]);
+        }
+        return true;
+    }
+    if ((data[0] & 0xC0) == 0x00) {
+        // Fast write: two bytes per channel, A through D.
+        for (size_t i = 0; i + 1 < len && i / 2 < 4; i += 2) {
+            _config[i / 2] = (uint8_t)((data[i] & 0x30) << 1);
+            _value[i / 2] = (uint16_t)(((data[i] & 0x0F) << 8) | data[i + 1]);
+        }
+        return true;
+    }
+    return true;
+}
+
+size_t MCP4728Model::onRead(uint8_t* data, size_t len) {
+    uint8_t frame[24];
+    for (uint8_t ch = 0; ch < 4; ++ch) {
+        uint8_t* p = &frame[ch * 6];
+        p[0] = (uint8_t)(0x80 | (ch << 4));
+        p[1] = (uint8_t)(_config[ch] | ((_value[ch] >> 8) & 0x0F));
+        p[2] = (uint8_t)(_value[ch] & 0xFF);
+        p[3] = (uint8_t)(0x88 | (ch << 4));
+        p[4] = p[1];
+        p[5] = p[2];
+    }
+    size_t n = len < sizeof(frame) ? len : sizeof(frame);
+    memcpy(data, frame, n);
+    return n;
+}
+
+} // namespace sim
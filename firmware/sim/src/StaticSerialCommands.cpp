@@ -0,0 +1,139 @@
+#include "StaticSerialCommands.h"
+
+SerialCommands::SerialCommands(Stream& serial, Command* commands, uint16_t commandCount,
+                               char* buffer, uint16_t bufferSize, char delimiter, char terminator)
+    : _serial(serial),
+      _commands(commands),
+      _commandCount(commandCount),
+      _buffer(buffer ? buffer : _ownBuffer),
+      _bufferSize(buffer ? bufferSize : (uint16_t)sizeof(_ownBuffer)),
+      _delimiter(delimiter),
+      _terminator(terminator) {}
+
+void SerialCommands::readSerial() {
+    while (_serial.available() > 0) {
+        int c = _serial.read();
+        if (c < 0) break;
+        if (c == '\r') continue;
+        if (c == _terminator) {
+            _buffer[_length] = '\0';
+            if (_overflow) {
+                _serial.println("ERROR: Command too long");
+            } else if (_length > 0) {
+                execute(_buffer);
+            }
+            _length = 0;
+            _overflow = false;
+            continue;
+        }
+        if (_length + 1 < _bufferSize) {
+            _buffer[_length++] = (char)c;
+        } else {
+            _overflow = true;
+        }
+    }
+}
+
+bool SerialCommands::parseArg(const CommandArg& spec, char* token, Arg& out) {
+    char* end = nullptr;
+    switch (spec.type) {
+        case ArgType::Int:
+            out._int = strtol(token, &end, 10);
+            if (*end != '\0' || out._int < (long)spec.min || out._int > (long)spec.max) return false;
+            out._float = (float)out._int;
+            break;
+        case ArgType::Float:
+            out._float = strtof(token, &end);
+            if (*end != '\0' || out._float < spec.min || out._float > spec.max) return false;
+            out._int = (long)out._float;
+            break;
+        default:
+            break;
+    }
+    out._string = token;
+    return true;
+}
+
+void SerialCommands::execute(char* line) {
+    char* tokens[16];
+    size_t tokenCount = 0;
+    char* p = line;
+    while (*p && tokenCount < 16) {
+        while (*p == _delimiter) *p++ = '\0';
+        if (!*p) break;
+        tokens[tokenCount++] = p;
+        while (*p && *p != _delimiter) p++;
+    }
+    if (tokenCount == 0) return;
+
+    Args args;
+    const Command* table = _commands;
+    uint16_t tableCount = _commandCount;
+    const Command* current = nullptr;
+    size_t t = 0;
+    while (t < tokenCount) {
+        const Command* match = nullptr;
+        for (uint16_t i = 0; i < tableCount; ++i) {
+            if (strcasecmp(table[i].name, tokens[t]) == 0) {
+                match = &table[i];
+                break;
+            }
+        }
+        if (!match) {
+            _serial.print("ERROR: Unknown command: ");
+            _serial.println(tokens[t]);
+            return;
+        }
+        current = match;
+        t++;
+        for (uint8_t a = 0; a < current->argCount; ++a, ++t) {
+            if (t >= tokenCount || args._count >= SIM_ARGS_MAX) {
+                _serial.print("ERROR: Missing argument: ");
+                _serial.println(current->args[a].name);
+                return;
+            }
+            if (!parseArg(current->args[a], tokens[t], args._args[args._count])) {
+                _serial.print("ERROR: Invalid argument: ");
+                _serial.println(current->args[a].name);
+                return;
+            }
+            args._count++;
+        }
+        if (t < tokenCount && current->subCommands) {
+            table = current->subCommands;
+            tableCount = current->subCommandCount;
+            continue;
+        }
+        break;
+    }
+    if (t < tokenCount) {
+        _serial.print("ERROR: Unexpected token: ");
+        _serial.println(tokens[t]);
+        return;
+    }
+    if (current && current->callback) current->callback(*this, args);
+}
+
+void SerialCommands::listLevel(const Command* commands, uint16_t count, int depth) {
+    for (uint16_t i = 0; i < count; ++i) {
+        for (int d = 0; d < depth; ++d) _serial.print("  ");
+        _serial.print(commands[i].name);
+        for (uint8_t a = 0; a < commands[i].argCount; ++a) {
+            _serial.print(" <");
+            _serial.print(commands[i].args[a].name);
+            _serial.print(">");
+        }
+        if (commands[i].description) {
+            _serial.print("  ");
+            _serial.print(commands[i].description);
+        }
+        _serial.println();
+        if (commands[i].subCommands) {
+            listLevel(commands[i].subCommands, commands[i].subCommandCount, depth + 1);
+        }
+    }
+}
+
+void SerialCommands::listAllCommands(Command* commands, uint16_t commandCount) {
+    listLevel(commands, commandCount, 0);
+}
@@ -0,0 +1,60 @@
+#include "Wire.h"
+#include "SimBus.h"
+
+TwoWire Wire;
+
+void TwoWire::setClock(uint32_t hz) { sim::bus().setClock(hz); }
+
+void TwoWire::beginTransmission(uint8_t address) {
+    _txAddress = address;
+    _txLength = 0;
+    _txOverflow = false;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (_txLength >= SIM_WIRE_BUFFER_LENGTH) {
+        _txOverflow = true;
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    size_t n = 0;
+    while (quantity--) n += write(*data++);
+    return n;
+}
+
+// Status codes follow the AVR Wire library: 1 data too long,
+// 2 NACK on address, 3 NACK on data.
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    if (_txOverflow) return 1;
+    size_t responders = 0;
+    sim::Device* device = sim::bus().resolve(_txAddress, responders);
+    if (!device) {
+        sim::bus().account(0, false);
+        return 2;
+    }
+    if (responders > 1) sim::bus().noteCollision();
+    bool acked = device->onWrite(_txBuffer, _txLength, sendStop);
+    sim::bus().account(_txLength, acked);
+    return acked ? 0 : 3;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+    (void)sendStop;
+    _rxIndex = 0;
+    _rxLength = 0;
+    if (quantity > SIM_WIRE_BUFFER_LENGTH) quantity = SIM_WIRE_BUFFER_LENGTH;
+    size_t responders = 0;
+    sim::Device* device = sim::bus().resolve(address, responders);
+    if (!device) {
+        sim::bus().account(0, false);
+        return 0;
+    }
+    if (responders > 1) sim::bus().noteCollision();
+    _rxLength = device->onRead(_rxBuffer, quantity);
+    sim::bus().account(_rxLength, true);
+    return (uint8_t)_rxLength;
+}
@@ -0,0 +1,281 @@
+#include "BinaryCommands.h"
+#include "Responses.h"
+#include "../helpers/I2CStats.h"
+
+// --- Binary protocol ---------------------------------------------------------
+// Opcodes and payload layouts are listed in src/protocol/BinaryLink.h. Each
+// handler reads its request, returns a status, and on success writes the
+// response payload. They mirror the text commands of the same name.
+
+typedef uint8_t (*BinaryHandler)(BinaryReader& args, BinaryWriter& out);
+
+struct BinaryCommand {
+    uint8_t opcode;
+    BinaryHandler handler;
+};
+
+bool binaryMode = false;
+
+void cmdBinary(SerialCommands& sender, Args& args) {
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "BINARY");
+    printYAMLInt(out, "protocol_version", BIN_PROTOCOL_VERSION);
+    printYAMLMessage(out, "Binary mode; send opcode 0x02 to return to text");
+    commandContext.binaryLink->reset();
+    binaryMode = true;
+}
+
+// milli-units (mA, mV, mW) to the protocol's micro-units
+static int32_t toMicro(float milli) {
+    return (int32_t)lroundf(milli * 1000.0f);
+}
+
+static TESDriver* binaryTes(uint8_t channel) {
+    return (channel >= 1 && channel <= commandContext.numTes) ? commandContext.tesDriver[channel - 1] : nullptr;
+}
+
+static LNADriver* binaryLna(uint8_t channel) {
+    return (channel >= 1 && channel <= commandContext.numLna) ? commandContext.lnaDriver[channel - 1] : nullptr;
+}
+
+static uint8_t binPing(BinaryReader& args, BinaryWriter& out) {
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    out.u8(BIN_PROTOCOL_VERSION);
+    return 0;
+}
+
+static uint8_t binText(BinaryReader& args, BinaryWriter& out) {
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    return 0; // serviceBinary() leaves binary mode after the response
+}
+
+static uint8_t binTesGet(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    TESDriver* tes = binaryTes(args.u8());
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!tes) return 10;
+    TesReading reading;
+    RETURN_IF_ERROR(tes->readAll(reading));
+    out.u8(reading.enabled);
+    out.u32(reading.tcaBits);
+    out.i32(toMicro(reading.shunt_mV));
+    out.i32(toMicro(reading.bus_V * 1000.0f));
+    out.i32(toMicro(reading.current_mA));
+    out.i32(toMicro(reading.power_mW));
+    out.u32(reading.timestamp_us);
+    out.u32(reading.duration_us);
+    return 0;
+}
+
+static uint8_t binTesSet(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    TESDriver* tes = binaryTes(args.u8());
+    int32_t target_uA = args.i32();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!tes || target_uA < 0 || target_uA > 20000) return 10;
+    if (commandContext.jobs.busy(tes)) return BIN_ERR_CHANNEL_BUSY;
+    float current_mA = target_uA / 1000.0f;
+    uint32_t finalState;
+    TesSetMethod method;
+    uint32_t start = millis();
+    RETURN_IF_ERROR(tes->setCurrent_mA(current_mA, &finalState, &current_mA, 10, &method));
+    out.i32(toMicro(current_mA));
+    out.u32(finalState);
+    out.u8(method);
+    out.u32(millis() - start);
+    return 0;
+}
+
+static uint8_t binTesSetBits(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    TESDriver* tes = binaryTes(args.u8());
+    uint32_t bits = args.u32();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!tes || bits > 0xFFFFF) return 10;
+    if (commandContext.jobs.busy(tes)) return BIN_ERR_CHANNEL_BUSY;
+    RETURN_IF_ERROR(tes->setAllOutputPins(bits));
+    out.u32(bits);
+    return 0;
+}
+
+static uint8_t binTesBits(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    TESDriver* tes = binaryTes(args.u8());
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!tes) return 10;
+    uint32_t bits;
+    RETURN_IF_ERROR(tes->getAllOutputPins(bits));
+    out.u32(bits);
+    return 0;
+}
+
+static uint8_t binTesCurrent(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    TESDriver* tes = binaryTes(args.u8());
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!tes) return 10;
+    float current_mA;
+    RETURN_IF_ERROR(tes->getCurrent_mA(current_mA));
+    out.i32(toMicro(current_mA));
+    return 0;
+}
+
+static uint8_t binTesEnable(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    TESDriver* tes = binaryTes(args.u8());
+    uint8_t enable = args.u8();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!tes || enable > 1) return 10;
+    RETURN_IF_ERROR(tes->setOutEnable(enable));
+    out.u8(enable);
+    return 0;
+}
+
+static uint8_t binLnaGet(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    LNADriver* lna = binaryLna(args.u8());
+    uint8_t side = args.u8();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!lna || side > LNA_GATE) return 10;
+    LnaReading reading;
+    RETURN_IF_ERROR(lna->readAll((LnaSide)side, reading));
+    out.u8(reading.enabled);
+    out.u16(reading.dacValue);
+    out.i32(toMicro(reading.shunt_mV));
+    out.i32(toMicro(reading.bus_V * 1000.0f));
+    out.i32(toMicro(reading.current_mA));
+    out.i32(toMicro(reading.power_mW));
+    out.u32(reading.timestamp_us);
+    out.u32(reading.duration_us);
+    return 0;
+}
+
+// Shared by LNA_SETMA and LNA_SETV: bracketing search, 1 ms settle as in SETMA/SETV
+static uint8_t binaryLnaSearch(BinaryReader& args, BinaryWriter& out, bool voltage) {
+    LNADriver* lna = binaryLna(args.u8());
+    uint8_t side = args.u8();
+    int32_t target = args.i32(); // uA or uV
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!lna || side > LNA_GATE || target < 0 || target > (voltage ? 5000000L : 64000L)) return 10;
+    if (commandContext.jobs.busy(lna)) return BIN_ERR_CHANNEL_BUSY;
+    float value = voltage ? target / 1000000.0f : target / 1000.0f;
+    uint16_t dacValue;
+    LnaSearchStats stats;
+    if (side == LNA_DRAIN) {
+        RETURN_IF_ERROR(voltage ? lna->setDrainVoltage(value, dacValue, 1, LNA_SEARCH_BRACKET, &stats)
+                                : lna->setDrainCurrent(value, dacValue, 1, LNA_SEARCH_BRACKET, &stats));
+    } else {
+        RETURN_IF_ERROR(voltage ? lna->setGateVoltage(value, dacValue, 1, LNA_SEARCH_BRACKET, &stats)
+                                : lna->setGateCurrent(value, dacValue, 1, LNA_SEARCH_BRACKET, &stats));
+    }
+    out.i32(toMicro(voltage ? value * 1000.0f : value));
+    out.u16(dacValue);
+    out.u16(stats.iterations);
+    out.u32(stats.elapsed_ms);
+    return 0;
+}
+
+static uint8_t binLnaSetCurrent(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    return binaryLnaSearch(args, out, false);
+}
+
+static uint8_t binLnaSetVoltage(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    return binaryLnaSearch(args, out, true);
+}
+
+static uint8_t binLnaSetDac(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    LNADriver* lna = binaryLna(args.u8());
+    uint8_t side = args.u8();
+    uint16_t value = args.u16();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!lna || side > LNA_GATE || value > LNA_DAC_MAX) return 10;
+    if (commandContext.jobs.busy(lna)) return BIN_ERR_CHANNEL_BUSY;
+    RETURN_IF_ERROR(side == LNA_DRAIN ? lna->writeDrain(value) : lna->writeGate(value));
+    out.u16(value);
+    return 0;
+}
+
+static uint8_t binLnaCurrent(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    LNADriver* lna = binaryLna(args.u8());
+    uint8_t side = args.u8();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!lna || side > LNA_GATE) return 10;
+    float current_mA;
+    RETURN_IF_ERROR(side == LNA_DRAIN ? lna->getDrainCurrent_mA(current_mA) : lna->getGateCurrent_mA(current_mA));
+    out.i32(toMicro(current_mA));
+    return 0;
+}
+
+static uint8_t binLnaEnable(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    LNADriver* lna = binaryLna(args.u8());
+    uint8_t side = args.u8();
+    uint8_t enable = args.u8();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (!lna || side > LNA_GATE || enable > 1) return 10;
+    RETURN_IF_ERROR(side == LNA_DRAIN ? lna->setDrainEnable(enable) : lna->setGateEnable(enable));
+    out.u8(enable);
+    return 0;
+}
+
+static uint8_t binDacSet(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    uint16_t value = args.u16();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    if (value > 1024) return 10;
+    RETURN_IF_ERROR(commandContext.mainDac.writeDAC(MCP4728_CHANNEL_A, value + commandContext.mainDacOffset, false)); // Same offset as DAC SET
+    out.u16(value);
+    return 0;
+}
+
+static uint8_t binDacGet(BinaryReader& args, BinaryWriter& out) {
+    I2C_STATS_COMMAND();
+    if (!args.done()) return BIN_ERR_BAD_LENGTH;
+    uint16_t value;
+    RETURN_IF_ERROR(commandContext.mainDac.readDAC(MCP4728_CHANNEL_A, value));
+    out.u16(value);
+    return 0;
+}
+
+static const BinaryCommand binaryCommands[] = {
+    { BIN_OP_PING, binPing },
+    { BIN_OP_TEXT, binText },
+    { BIN_OP_TES_GET, binTesGet },
+    { BIN_OP_TES_SET, binTesSet },
+    { BIN_OP_TES_SETBITS, binTesSetBits },
+    { BIN_OP_TES_BITS, binTesBits },
+    { BIN_OP_TES_CURRENT, binTesCurrent },
+    { BIN_OP_TES_ENABLE, binTesEnable },
+    { BIN_OP_LNA_GET, binLnaGet },
+    { BIN_OP_LNA_SETMA, binLnaSetCurrent },
+    { BIN_OP_LNA_SETV, binLnaSetVoltage },
+    { BIN_OP_LNA_SETDAC, binLnaSetDac },
+    { BIN_OP_LNA_CURRENT, binLnaCurrent },
+    { BIN_OP_LNA_ENABLE, binLnaEnable },
+    { BIN_OP_DAC_SET, binDacSet },
+    { BIN_OP_DAC_GET, binDacGet },
+};
+
+void serviceBinary() {
+    uint8_t opcode, seq;
+    BinaryReader args(nullptr, 0);
+    while (binaryMode && commandContext.binaryLink->poll(opcode, seq, args)) {
+        BinaryWriter out;
+        uint8_t status = BIN_ERR_UNKNOWN_OPCODE;
+        for (size_t i = 0; i < sizeof(binaryCommands) / sizeof(BinaryCommand); ++i) {
+            if (binaryCommands[i].opcode == opcode) {
+                status = binaryCommands[i].handler(args, out);
+                break;
+            }
+        }
+        commandContext.binaryLink->send(opcode, seq, status, out);
+        if (opcode == BIN_OP_TEXT && !status) {
+            binaryMode = false;
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef BINARY_COMMANDS_H
+#define BINARY_COMMANDS_H
+
+#include <StaticSerialCommands.h>
+
+// BINARY and the framed opcodes it switches to, acting on commandContext
+// and read through its binaryLink
+
+// Set by BINARY and cleared by the TEXT opcode. While it is set, loop()
+// calls serviceBinary() instead of reading text commands.
+extern bool binaryMode;
+
+void cmdBinary(SerialCommands& sender, Args& args);
+void serviceBinary();
+
+#endif // BINARY_COMMANDS_H
@@ -0,0 +1,70 @@
+#ifndef COMMAND_ARGS_H
+#define COMMAND_ARGS_H
+
+#include <StaticSerialCommands.h>
+#include "../telemetry/Sampler.h"
+
+// Arguments of the shared command sets. The CHANNEL arguments depend on the
+// crate's NUM_TES / NUM_LNA and are defined by each sketch.
+
+constexpr auto lnaDrainGate =
+    ARG(ArgType::String, "DRAIN|GATE");
+
+constexpr auto lnaCurrentArg =
+    ARG(ArgType::Float, 0, 64, "CURRENT");
+
+constexpr auto lnaVoltageArg =
+    ARG(ArgType::Float, 0, 5, "VOLTAGE");
+
+constexpr auto dacValueArg =
+    ARG(ArgType::Int, 0, 4095, "VALUE");
+
+constexpr auto tesTCAArg =
+    ARG(ArgType::Int, 0, 0xFFFFF, "BITS"); // 20 bits for TES TCA
+
+constexpr auto tesTCAHexArg =
+    ARG(ArgType::String, "HEXSTRING"); // Hex string for TES TCA
+
+constexpr auto tcaCurrentArg =
+    ARG(ArgType::Float, 0, 20, "CURRENT");
+
+constexpr auto tesTargetsArg =
+    ARG(ArgType::String, "CH:MA,..."); // e.g. 1:5,2:5.5 or *:5 for every channel
+
+constexpr auto jobIdArg =
+    ARG(ArgType::Int, 1, 65535, "JOB_ID");
+
+constexpr auto inaProfileArg =
+    ARG(ArgType::String, "DEFAULT|MONITOR|FAST");
+
+constexpr auto addrChanArg =
+    ARG(ArgType::Int, 1, 16, "CHANNEL"); // Checked against the crate's NUM_TES / NUM_LNA by DeviceMap
+
+constexpr auto addrListArg =
+    ARG(ArgType::String, "HUB[:PART:...]"); // Hex, e.g. 65 or 0x65:40:22
+
+constexpr auto topologyKindArg =
+    ARG(ArgType::String, "TES|LNA");
+
+constexpr auto streamPeriodArg =
+    ARG(ArgType::Int, SAMPLER_MIN_PERIOD_MS, SAMPLER_MAX_PERIOD_MS, "PERIOD_MS");
+
+constexpr auto streamSourcesArg =
+    ARG(ArgType::String, "KIND:CH,..."); // e.g. TES:1,DRAIN:2,GATEV:2
+
+constexpr auto historySeriesArg =
+    ARG(ArgType::String, "TES|DRAIN|GATE:CH");
+
+constexpr auto subSourceArg =
+    ARG(ArgType::String, "KIND:CH"); // Same kinds as STREAM, e.g. DRAIN:2
+
+constexpr auto subDeadbandArg =
+    ARG(ArgType::Float, 0, 1000, "DEADBAND"); // mA for currents, mV for voltages
+
+constexpr auto subHeartbeatArg =
+    ARG(ArgType::Int, 0, 3600000, "HEARTBEAT_MS"); // 0 = report changes only
+
+constexpr auto subIdArg =
+    ARG(ArgType::Int, 1, 255, "SUB_ID");
+
+#endif // COMMAND_ARGS_H
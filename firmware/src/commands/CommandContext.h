@@ -0,0 +1,45 @@
+#ifndef COMMAND_CONTEXT_H
+#define COMMAND_CONTEXT_H
+
+#include <Arduino.h>
+#include "../drivers/MCP4728.h"
+#include "../devices/LNADriver.h"
+#include "../devices/TESDriver.h"
+#include "../devices/DeviceTable.h"
+#include "../devices/CrateBoot.h"
+#include "../devices/Topology.h"
+#include "../jobs/JobEngine.h"
+#include "../protocol/BinaryLink.h"
+#include "../protocol/RequestStream.h"
+#include "../telemetry/History.h"
+#include "../telemetry/Sampler.h"
+#include "../telemetry/Subscriptions.h"
+
+// The crate the shared command handlers in src/commands act on. Each sketch
+// defines commandContext with its own devices. Channel numbers are range
+// checked by the CHANNEL arguments in the sketch's command tables (1 to
+// NUM_TES / NUM_LNA), so the handlers index the driver arrays directly;
+// channels parsed from a list or a binary frame are checked against
+// numTes / numLna.
+struct CommandContext {
+    JobEngine& jobs;
+    MCP4728& mainDac;
+    uint16_t mainDacOffset;         // Added to DAC SET values before they are written
+    TESDriver* const* tesDriver;    // nullptr on a crate without TES channels
+    LNADriver* const* lnaDriver;
+    uint8_t numTes;                 // Entries in tesDriver and lnaDriver
+    uint8_t numLna;
+    RequestStream* requestStream;   // Source of echoed request ids; nullptr for none
+    DeviceMap* deviceMap;           // Card addresses, for ADDR
+    CrateBoot* crateBoot;           // Card presence and boot timing, for BOOT
+    Topology* topology;             // I2C tree map, for TOPOLOGY
+    // nullptr on a crate built without telemetry or the binary protocol
+    Sampler* sampler;               // For STREAM
+    History* history;               // For HISTORY
+    Subscriptions* subscriptions;   // For SUB
+    BinaryLink* binaryLink;         // Framed transport for BINARY
+};
+
+extern CommandContext commandContext;
+
+#endif // COMMAND_CONTEXT_H
@@ -0,0 +1,271 @@
+#include "LnaCommands.h"
+#include "Quantities.h"
+#include "Responses.h"
+#include "../helpers/I2CStats.h"
+#include "../jobs/Jobs.h"
+
+typedef uint8_t (LNADriver::*LnaGetter)(float&);
+
+// Getter per QUANTITIES row, indexed by LnaSide
+static const LnaGetter LNA_GETTERS[QUANTITY_COUNT][2] = {
+    { &LNADriver::getDrainShuntVoltage_mV, &LNADriver::getGateShuntVoltage_mV },
+    { &LNADriver::getDrainBusVoltage_V, &LNADriver::getGateBusVoltage_V },
+    { &LNADriver::getDrainCurrent_mA, &LNADriver::getGateCurrent_mA },
+    { &LNADriver::getDrainPower_mW, &LNADriver::getGatePower_mW },
+};
+
+static const char* lnaTargetName(LnaSide side) {
+    return side == LNA_DRAIN ? "DRAIN" : "GATE";
+}
+
+// As the rail is named in messages
+static const char* lnaDeviceName(LnaSide side) {
+    return side == LNA_DRAIN ? "Drain" : "Gate";
+}
+
+// Channel and DRAIN/GATE, the first two arguments of every LNA subcommand.
+// Reports LNA_TARGET_ERROR and returns false for any other target.
+static bool parseLnaArgs(SerialCommands& sender, Args& args, uint8_t& channel, LnaSide& side) {
+    channel = args[0].getInt() - 1;
+    const char* target = args[1].getString();
+    if (strcasecmp(target, "DRAIN") == 0) {
+        side = LNA_DRAIN;
+    } else if (strcasecmp(target, "GATE") == 0) {
+        side = LNA_GATE;
+    } else {
+        reportError(sender, "LNA_TARGET_ERROR", "Invalid target. Use DRAIN or GATE.");
+        return false;
+    }
+    return true;
+}
+
+// Header through `target`, shared by the LNA responses
+static void printLnaHeader(Stream &out, const char* command, uint8_t channel, LnaSide side) {
+    printChannelHeader(out, command, channel);
+    printYAMLString(out, "target", lnaTargetName(side));
+}
+
+// Shared by SETMA/SETMALIN and SETV/SETVLIN
+static void lnaSearch(SerialCommands& sender, Args& args, bool voltage, LnaSearchMode mode) {
+    uint8_t channel;
+    LnaSide side;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    float value = args[2].getFloat();
+    uint16_t dacValue;
+    LnaSearchStats stats;
+    LNADriver* lna = commandContext.lnaDriver[channel];
+    if (reportIfBusy(sender, lna)) {
+        return;
+    }
+    uint8_t status;
+    if (side == LNA_DRAIN) {
+        status = voltage ? lna->setDrainVoltage(value, dacValue, 1, mode, &stats)
+                         : lna->setDrainCurrent(value, dacValue, 1, mode, &stats);
+    } else {
+        status = voltage ? lna->setGateVoltage(value, dacValue, 1, mode, &stats)
+                         : lna->setGateCurrent(value, dacValue, 1, mode, &stats);
+    }
+    char message[32];
+    joinText(message, sizeof(message), "Failed to set ", lnaDeviceName(side), voltage ? " voltage." : " current.");
+    if (reportIfError(sender, status, "LNA_SET_ERROR", message)) {
+        return;
+    }
+    const char* search = (mode == LNA_SEARCH_LINEAR) ? "linear" : (stats.fellBack ? "linear_fallback" : "bracket");
+    Stream &out = sender.getSerial();
+    printLnaHeader(out, "LNA_SET", channel, side);
+    printYAMLFloat(out, voltage ? "voltage_V" : "current_mA", value, 4);
+    printYAMLInt(out, "dac_value", dacValue);
+    printYAMLString(out, "search", search);
+    printYAMLInt(out, "iterations", stats.iterations);
+    printYAMLInt(out, "elapsed_ms", stats.elapsed_ms);
+    printYAMLMessage(out, voltage ? "LNA voltage set" : "LNA current set");
+}
+
+void cmdLNASetCurrent(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSearch(sender, args, false, LNA_SEARCH_BRACKET);
+}
+
+void cmdLNASetCurrentLinear(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSearch(sender, args, false, LNA_SEARCH_LINEAR);
+}
+
+void cmdLNASetVoltage(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSearch(sender, args, true, LNA_SEARCH_BRACKET);
+}
+
+void cmdLNASetVoltageLinear(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSearch(sender, args, true, LNA_SEARCH_LINEAR);
+}
+
+static void lnaSearchAsync(SerialCommands& sender, Args& args, bool voltage) {
+    uint8_t channel;
+    LnaSide side;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    float value = args[2].getFloat();
+    LNADriver* lna = commandContext.lnaDriver[channel];
+    if (reportIfBusy(sender, lna)) {
+        return;
+    }
+    // Same 1 ms settle as the blocking SETMA/SETV
+    uint16_t id = commandContext.jobs.submit<LnaSetJob>(lna, channel + 1, side, voltage, value, LNA_SEARCH_BRACKET, 1);
+    reportJobSubmitted(sender, "LNA_SET", id);
+}
+
+void cmdLNASetCurrentAsync(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSearchAsync(sender, args, false);
+}
+
+void cmdLNASetVoltageAsync(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSearchAsync(sender, args, true);
+}
+
+void cmdLNASetDac(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel;
+    LnaSide side;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    uint16_t value = args[2].getInt();
+    LNADriver* lna = commandContext.lnaDriver[channel];
+    if (reportIfBusy(sender, lna)) {
+        return;
+    }
+    uint8_t status = side == LNA_DRAIN ? lna->writeDrain(value) : lna->writeGate(value);
+    char message[32];
+    joinText(message, sizeof(message), "Failed to set ", lnaDeviceName(side), " DAC value.");
+    if (reportIfError(sender, status, "LNA_SET_ERROR", message)) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printLnaHeader(out, "LNA_SET", channel, side);
+    printYAMLInt(out, "value", value);
+    printYAMLMessage(out, joinText(message, sizeof(message), "LNA ", lnaTargetName(side), " DAC value set"));
+}
+
+// Shared by SHUNT, BUS, CURRENT and POWER
+static void lnaRead(SerialCommands& sender, Args& args, Quantity quantity) {
+    uint8_t channel;
+    LnaSide side;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    float value = 0;
+    uint8_t status = (commandContext.lnaDriver[channel]->*LNA_GETTERS[quantity][side])(value);
+    reportQuantity(sender, quantity, status, value, "LNA", channel, lnaTargetName(side), lnaDeviceName(side));
+}
+
+void cmdLNAShunt(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaRead(sender, args, QUANTITY_SHUNT);
+}
+
+void cmdLNABus(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaRead(sender, args, QUANTITY_BUS);
+}
+
+void cmdLNACurrent(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaRead(sender, args, QUANTITY_CURRENT);
+}
+
+void cmdLNAPower(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaRead(sender, args, QUANTITY_POWER);
+}
+
+// Shared by ENABLE and DISABLE
+static void lnaSetEnable(SerialCommands& sender, Args& args, bool enable) {
+    uint8_t channel;
+    LnaSide side;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    LNADriver* lna = commandContext.lnaDriver[channel];
+    uint8_t status = side == LNA_DRAIN ? lna->setDrainEnable(enable) : lna->setGateEnable(enable);
+    char errKey[32];
+    char message[32];
+    joinText(errKey, sizeof(errKey), "LNA_", lnaTargetName(side), enable ? "_ENABLE_ERROR" : "_DISABLE_ERROR");
+    joinText(message, sizeof(message), enable ? "Failed to enable " : "Failed to disable ", lnaDeviceName(side), ".");
+    if (reportIfError(sender, status, errKey, message)) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printLnaHeader(out, enable ? "LNA_ENABLE" : "LNA_DISABLE", channel, side);
+    printYAMLBool(out, "enabled", enable);
+    printYAMLMessage(out, joinText(message, sizeof(message), lnaDeviceName(side), enable ? " enabled" : " disabled"));
+}
+
+void cmdLNAEnable(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSetEnable(sender, args, true);
+}
+
+void cmdLNADisable(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    lnaSetEnable(sender, args, false);
+}
+
+void cmdLNAAdc(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel;
+    LnaSide side;
+    INA219Profile profile;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    if (!parseInaProfile(args[2].getString(), profile)) {
+        reportError(sender, "INA_PROFILE_ARG_ERROR", "Profile must be DEFAULT, MONITOR or FAST.");
+        return;
+    }
+    LNADriver* lna = commandContext.lnaDriver[channel];
+    if (reportIfBusy(sender, lna)) {
+        return;
+    }
+    uint8_t status = lna->setInaProfile(side, profile);
+    if (reportIfError(sender, status, "LNA_ADC_ERROR", "Failed to configure INA219.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printLnaHeader(out, "LNA_ADC", channel, side);
+    printYAMLString(out, "profile", inaProfileName(profile));
+    printYAMLMessage(out, "LNA INA219 profile set");
+}
+
+void cmdLNAGetAll(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel;
+    LnaSide side;
+    if (!parseLnaArgs(sender, args, channel, side)) {
+        return;
+    }
+    LnaReading reading;
+    uint8_t status = commandContext.lnaDriver[channel]->readAll(side, reading);
+    char message[40];
+    joinText(message, sizeof(message), "Failed to read ", lnaDeviceName(side), " parameters.");
+    if (reportIfError(sender, status, "LNA_READ_ERROR", message)) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printLnaHeader(out, "LNA_GET", channel, side);
+    printYAMLInt(out, "dac_value", reading.dacValue);
+    printYAMLBool(out, "enabled", reading.enabled);
+    printYAMLFloat(out, "shunt_mV", reading.shunt_mV, 4);
+    printYAMLFloat(out, "bus_V", reading.bus_V, 4);
+    printYAMLFloat(out, "current_mA", reading.current_mA, 4);
+    printYAMLFloat(out, "power_mW", reading.power_mW, 4);
+    printYAMLInt(out, "timestamp_us", reading.timestamp_us);
+    printYAMLInt(out, "duration_us", reading.duration_us);
+    printYAMLMessage(out, "LNA parameters");
+}
@@ -0,0 +1,44 @@
+#ifndef LNA_COMMANDS_H
+#define LNA_COMMANDS_H
+
+#include <StaticSerialCommands.h>
+#include "CommandArgs.h"
+
+// LNA <CHANNEL> <DRAIN|GATE> ... subcommands, acting on
+// commandContext.lnaDriver. DRAIN and GATE match in any case.
+
+void cmdLNAGetAll(SerialCommands& sender, Args& args);
+void cmdLNASetCurrent(SerialCommands& sender, Args& args);
+void cmdLNASetCurrentLinear(SerialCommands& sender, Args& args);
+void cmdLNASetVoltage(SerialCommands& sender, Args& args);
+void cmdLNASetVoltageLinear(SerialCommands& sender, Args& args);
+void cmdLNASetCurrentAsync(SerialCommands& sender, Args& args);
+void cmdLNASetVoltageAsync(SerialCommands& sender, Args& args);
+void cmdLNASetDac(SerialCommands& sender, Args& args);
+void cmdLNAShunt(SerialCommands& sender, Args& args);
+void cmdLNABus(SerialCommands& sender, Args& args);
+void cmdLNACurrent(SerialCommands& sender, Args& args);
+void cmdLNAPower(SerialCommands& sender, Args& args);
+void cmdLNAAdc(SerialCommands& sender, Args& args);
+void cmdLNAEnable(SerialCommands& sender, Args& args);
+void cmdLNADisable(SerialCommands& sender, Args& args);
+
+// Entries of a sketch's lnaCommands[] table
+#define LNA_COMMANDS \
+    COMMAND(cmdLNAGetAll, "GET", nullptr, "Get All LNA Parameters for Gate/Drain"), \
+    COMMAND(cmdLNAEnable, "ENABLE", nullptr, "Enable Gate/Drain"), \
+    COMMAND(cmdLNADisable, "DISABLE", nullptr, "Disable Gate/Drain"), \
+    COMMAND(cmdLNASetCurrent, "SETMA", lnaCurrentArg, nullptr, "Search and set Gate/Drain DAC Value (mA)"), \
+    COMMAND(cmdLNASetCurrentLinear, "SETMALIN", lnaCurrentArg, nullptr, "Set Gate/Drain DAC Value (mA) by Linear Sweep"), \
+    COMMAND(cmdLNASetVoltage, "SETV", lnaVoltageArg, nullptr, "Search and set Gate/Drain DAC Value (V)"), \
+    COMMAND(cmdLNASetVoltageLinear, "SETVLIN", lnaVoltageArg, nullptr, "Set Gate/Drain DAC Value (V) by Linear Sweep"), \
+    COMMAND(cmdLNASetCurrentAsync, "SETMAASYNC", lnaCurrentArg, nullptr, "Start Gate/Drain Current Search as a Job (mA)"), \
+    COMMAND(cmdLNASetVoltageAsync, "SETVASYNC", lnaVoltageArg, nullptr, "Start Gate/Drain Voltage Search as a Job (V)"), \
+    COMMAND(cmdLNASetDac, "SETDAC", dacValueArg, nullptr, "Set Gate/Drain DAC Value"), \
+    COMMAND(cmdLNAShunt, "SHUNT", nullptr, "Get Gate/Drain Shunt Voltage (mV)"), \
+    COMMAND(cmdLNABus, "BUS", nullptr, "Get Gate/Drain Bus Voltage (V)"), \
+    COMMAND(cmdLNACurrent, "CURRENT", nullptr, "Get Gate/Drain Current (mA)"), \
+    COMMAND(cmdLNAPower, "POWER", nullptr, "Get Gate/Drain Power (mW)"), \
+    COMMAND(cmdLNAAdc, "ADC", inaProfileArg, nullptr, "Set Gate/Drain INA219 Profile")
+
+#endif // LNA_COMMANDS_H
@@ -0,0 +1,29 @@
+#include "Quantities.h"
+#include "Responses.h"
+
+const QuantityInfo QUANTITIES[QUANTITY_COUNT] = {
+    { "SHUNT", "shunt voltage", "mV", "shunt_mV" },
+    { "BUS", "bus voltage", "V", "bus_V" },
+    { "CURRENT", "current", "mA", "current_mA" },
+    { "POWER", "power", "mW", "power_mW" },
+};
+
+void reportQuantity(SerialCommands& sender, Quantity quantity, uint8_t status, float value,
+                    const char* family, uint8_t channel, const char* target, const char* device) {
+    const QuantityInfo& info = QUANTITIES[quantity];
+    char name[32];
+    char message[48];
+    if (status) {
+        joinText(name, sizeof(name), family, "_", info.name, "_READ_ERROR");
+        joinText(message, sizeof(message), "Failed to read ", device, " ", info.label, ".");
+        reportIfError(sender, status, name, message);
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, joinText(name, sizeof(name), family, "_", info.name), channel);
+    if (target) {
+        printYAMLString(out, "target", target);
+    }
+    printYAMLFloat(out, info.key, value, 4);
+    printYAMLMessage(out, joinText(message, sizeof(message), device, " ", info.label, " (", info.unit, ")"));
+}
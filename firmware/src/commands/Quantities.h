@@ -0,0 +1,33 @@
+#ifndef QUANTITIES_H
+#define QUANTITIES_H
+
+#include <Arduino.h>
+#include <StaticSerialCommands.h>
+
+// The INA219 readings behind the per-channel SHUNT, BUS, CURRENT and POWER
+// commands. One table row gives the command suffix, wording, unit and
+// response key; the TES and LNA command sets map each row to a driver getter.
+enum Quantity {
+    QUANTITY_SHUNT,
+    QUANTITY_BUS,
+    QUANTITY_CURRENT,
+    QUANTITY_POWER,
+    QUANTITY_COUNT
+};
+
+struct QuantityInfo {
+    const char* name;   // Command suffix: SHUNT gives TES_SHUNT and TES_SHUNT_READ_ERROR
+    const char* label;  // Wording in messages: "shunt voltage"
+    const char* unit;   // "mV"
+    const char* key;    // Response key: "shunt_mV"
+};
+
+extern const QuantityInfo QUANTITIES[QUANTITY_COUNT];
+
+// Reports one reading, or `status` as <family>_<NAME>_READ_ERROR when it is
+// non-zero. `device` names the rail in messages ("TES", "Drain", "Gate");
+// `target` is echoed when not nullptr.
+void reportQuantity(SerialCommands& sender, Quantity quantity, uint8_t status, float value,
+                    const char* family, uint8_t channel, const char* target, const char* device);
+
+#endif // QUANTITIES_H
@@ -0,0 +1,116 @@
+#include "Responses.h"
+#include "../helpers/MemoryStats.h"
+
+void printYAMLHeader(Stream &s, const char *status) {
+    memoryStats.sample();
+    LineBuffer header(s);
+    header.println("---");
+    // Echo the request id of an "@<id> COMMAND" line
+    RequestStream* requests = commandContext.requestStream;
+    if (requests && requests->get_requestId() != REQUEST_NO_ID) {
+        header.print("id: ");
+        printInt(header, requests->get_requestId());
+        header.println();
+    }
+    header.print("status: ");
+    header.println(status);
+    header.println("result:");
+}
+
+// convenience to finish a response with an optional human message key
+void printYAMLMessage(Stream &s, const char *message) {
+    LineBuffer line(s);
+    if (message && *message) {
+        printYAMLKey(line, "message");
+        printQuoted(line, message);
+        line.println();
+    }
+    line.println();
+}
+
+bool reportIfError(SerialCommands& sender, uint8_t status, const char* errKey, const char* message) {
+    if (status) {
+        Stream &out = sender.getSerial();
+        printYAMLHeader(out, "error");
+        printYAMLString(out, "error", errKey);
+        // include numeric status code for easier debugging
+        printYAMLInt(out, "code", status);
+        printYAMLMessage(out, message);
+        return true;
+    }
+    return false;
+}
+
+void reportError(SerialCommands& sender, const char* errKey, const char* message) {
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "error");
+    printYAMLString(out, "error", errKey);
+    printYAMLMessage(out, message);
+}
+
+bool reportIfBusy(SerialCommands& sender, const void* device) {
+    if (!commandContext.jobs.busy(device)) {
+        return false;
+    }
+    reportError(sender, "CHANNEL_BUSY", "A running job drives this channel. Wait for it or JOB CANCEL it.");
+    return true;
+}
+
+void reportJobSubmitted(SerialCommands& sender, const char* command, uint16_t id) {
+    if (reportIfError(sender, id ? 0 : JOB_ERR_TABLE_FULL, "JOB_TABLE_FULL", "Every job slot holds a running job.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", command);
+    printYAMLInt(out, "job_id", id);
+    printYAMLString(out, "state", jobStateName(JOB_RUNNING));
+    printYAMLMessage(out, "Job started; poll it with JOB STATUS");
+}
+
+void printChannelHeader(Stream &out, const char* command, uint8_t channel) {
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", command);
+    printYAMLInt(out, "channel", channel + 1);
+}
+
+void printInlineError(Print &out, const char *errKey, uint8_t status) {
+    out.print("error: ");
+    printQuoted(out, errKey);
+    out.print(", code: ");
+    printInt(out, status);
+}
+
+const char* inaProfileName(INA219Profile profile) {
+    switch (profile) {
+        case INA219_PROFILE_MONITOR: return "MONITOR";
+        case INA219_PROFILE_FAST: return "FAST";
+        default: return "DEFAULT";
+    }
+}
+
+bool parseInaProfile(const char* name, INA219Profile& profile) {
+    if (strcasecmp(name, "DEFAULT") == 0) {
+        profile = INA219_PROFILE_DEFAULT;
+    } else if (strcasecmp(name, "MONITOR") == 0) {
+        profile = INA219_PROFILE_MONITOR;
+    } else if (strcasecmp(name, "FAST") == 0) {
+        profile = INA219_PROFILE_FAST;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* joinText(char* buffer, size_t size, const char* a, const char* b, const char* c,
+                     const char* d, const char* e, const char* f) {
+    const char* parts[] = { a, b, c, d, e, f };
+    size_t length = 0;
+    for (uint8_t i = 0; i < 6; ++i) {
+        for (const char* p = parts[i]; *p && length + 1 < size; ++p) {
+            buffer[length++] = *p;
+        }
+    }
+    buffer[length] = '\0';
+    return buffer;
+}
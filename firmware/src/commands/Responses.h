@@ -0,0 +1,51 @@
+#ifndef RESPONSES_H
+#define RESPONSES_H
+
+#include <Arduino.h>
+#include <StaticSerialCommands.h>
+#include "../drivers/INA219.h"
+#include "../helpers/YAMLWriter.h"
+#include "CommandContext.h"
+
+// YAML response framing shared by every command. A response is
+//
+//   ---
+//   id: 7               (only for "@7 COMMAND" lines)
+//   status: ok | error
+//   result:
+//     key: value
+//     message: "..."
+//   <blank line>
+//
+// Key/value lines come from src/helpers/YAMLWriter.h and allocate nothing.
+
+void printYAMLHeader(Stream &s, const char *status);
+void printYAMLMessage(Stream &s, const char *message);  // Ends the response
+
+// Error responses. reportIfError() reports and returns true for a non-zero
+// status, which it includes as `code`.
+bool reportIfError(SerialCommands& sender, uint8_t status, const char* errKey, const char* message);
+void reportError(SerialCommands& sender, const char* errKey, const char* message);
+
+// Writes are refused on a channel that a running job drives; reads are not
+bool reportIfBusy(SerialCommands& sender, const void* device);
+void reportJobSubmitted(SerialCommands& sender, const char* command, uint16_t id);
+
+// Header, command name and channel: the start of every per-channel response.
+// `channel` is the 0-based index and is reported 1-based.
+void printChannelHeader(Stream &out, const char* command, uint8_t channel);
+
+// "error: ..., code: N" inside one row of a list, for the SNAPSHOT and TESSET
+// channels that fail without aborting the rest
+void printInlineError(Print &out, const char *errKey, uint8_t status);
+
+// INA219 profile names as used by the ADC commands
+const char* inaProfileName(INA219Profile profile);
+bool parseInaProfile(const char* name, INA219Profile& profile);
+
+// Concatenates up to six parts into `buffer`, cut at `size` - 1 characters,
+// for keys and messages built from the command tables
+const char* joinText(char* buffer, size_t size, const char* a, const char* b, const char* c = "",
+                     const char* d = "", const char* e = "", const char* f = "");
+
+#endif // RESPONSES_H
@@ -0,0 +1,416 @@
+#include "SystemCommands.h"
+#include "Responses.h"
+#include "../helpers/I2CStats.h"
+#include "../helpers/MemoryStats.h"
+
+// --- DAC ---------------------------------------------------------------------
+
+void cmdDACSet(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint16_t value = args[0].getInt();
+    uint8_t status = commandContext.mainDac.writeDAC(MCP4728_CHANNEL_A, value + commandContext.mainDacOffset, false);
+    if (reportIfError(sender, status, "DAC_SET_ERROR", "Failed to set main DAC value.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "DAC_SET");
+    printYAMLInt(out, "value", value);
+    printYAMLMessage(out, "Main DAC value set");
+}
+
+void cmdDACGet(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint16_t value;
+    uint8_t status = commandContext.mainDac.readDAC(MCP4728_CHANNEL_A, value);
+    if (reportIfError(sender, status, "DAC_GET_ERROR", "Failed to get main DAC value.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "DAC_GET");
+    printYAMLInt(out, "value", value);
+    printYAMLMessage(out, "Main DAC value retrieved");
+}
+
+// --- JOB ---------------------------------------------------------------------
+
+static uint32_t jobElapsedMs(const JobSlot& slot) {
+    return (slot.state == JOB_RUNNING ? millis() : slot.endMs) - slot.startMs;
+}
+
+void cmdJobList(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    JobEngine& jobs = commandContext.jobs;
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "JOB_LIST");
+    bool any = false;
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        any = any || jobs.slot(i)->id;
+    }
+    if (any) printYAMLSection(out, "jobs");
+    else printYAMLPlain(out, "jobs", "[]");
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        JobSlot* slot = jobs.slot(i);
+        if (!slot->id) continue;
+        LineBuffer line(out);
+        printIndent(line, 4);
+        line.print("- {job_id: ");
+        printInt(line, slot->id);
+        line.print(", kind: ");
+        printQuoted(line, slot->job->get_kind());
+        line.print(", state: ");
+        printQuoted(line, jobStateName(slot->state));
+        line.print(", elapsed_ms: ");
+        printInt(line, jobElapsedMs(*slot));
+        line.println("}");
+    }
+    printYAMLInt(out, "running", jobs.get_running());
+    printYAMLMessage(out, "Jobs");
+}
+
+void cmdJobStatus(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint16_t id = args[0].getInt();
+    JobSlot* slot = commandContext.jobs.find(id);
+    if (!slot) {
+        reportError(sender, "JOB_NOT_FOUND", "No job with that ID (finished jobs are dropped when their slot is reused).");
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "JOB_STATUS");
+    printYAMLInt(out, "job_id", slot->id);
+    printYAMLString(out, "kind", slot->job->get_kind());
+    printYAMLString(out, "state", jobStateName(slot->state));
+    printYAMLInt(out, "elapsed_ms", jobElapsedMs(*slot));
+    if (slot->state == JOB_FAILED) {
+        printYAMLInt(out, "code", slot->job->get_status());
+    }
+    slot->job->printResult(out, 2);
+    printYAMLMessage(out, "Job status");
+}
+
+void cmdJobCancel(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint16_t id = args[0].getInt();
+    if (!commandContext.jobs.cancel(id)) {
+        reportError(sender, "JOB_NOT_RUNNING", "No running job with that ID.");
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "JOB_CANCEL");
+    printYAMLInt(out, "job_id", id);
+    printYAMLString(out, "state", jobStateName(JOB_CANCELLED));
+    printYAMLMessage(out, "Job cancelled; outputs are left where the job stopped");
+}
+
+// --- MEM ---------------------------------------------------------------------
+// Free RAM now and its low-water mark since boot or MEM RESET. Responses are
+// formatted without the heap, so once booted the mark only follows stack
+// depth; a mark that keeps falling over days points at heap growth.
+
+void cmdMem(SerialCommands& sender, Args& args) {
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "MEM");
+    if (memoryStats.get_supported()) {
+        printYAMLInt(out, "free_bytes", memoryStats.get_free());
+        printYAMLInt(out, "min_free_bytes", memoryStats.get_minFree());
+    } else {
+        printYAMLPlain(out, "free_bytes", "null");
+        printYAMLPlain(out, "min_free_bytes", "null");
+    }
+    printYAMLInt(out, "uptime_ms", millis());
+    printYAMLMessage(out, memoryStats.get_supported() ? "Free RAM" : "Free RAM is not measurable on this platform");
+}
+
+void cmdMemReset(SerialCommands& sender, Args& args) {
+    memoryStats.resetMark();
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "MEM_RESET");
+    printYAMLMessage(out, "Low-water mark restarted");
+}
+
+// --- ADDR --------------------------------------------------------------------
+// The card addresses in use, and edits to the stored map that replaces the
+// sketch's defaults at boot. An edit names the card's hub and optionally its
+// parts, in hex; parts left out keep their current address.
+
+static void printAddressRow(Stream &out, uint8_t channel, const char* const* keys,
+                            const uint8_t* addresses, uint8_t count) {
+    LineBuffer line(out);
+    printIndent(line, 4);
+    line.print("- {channel: ");
+    printInt(line, channel + 1);
+    for (uint8_t i = 0; i < count; ++i) {
+        line.print(", ");
+        line.print(keys[i]);
+        line.print(": \"0x");
+        printHex(line, addresses[i], 2);
+        line.print('"');
+    }
+    line.println("}");
+}
+
+static const char* const TES_ADDRESS_KEYS[] = {"hub", "ina", "tca"};
+static const char* const LNA_ADDRESS_KEYS[] = {"hub", "dac", "ina_drain", "ina_gate"};
+
+void cmdAddr(SerialCommands& sender, Args& args) {
+    DeviceMap& map = *commandContext.deviceMap;
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "ADDR");
+    printYAMLBool(out, "stored", map.get_stored());
+    printYAMLBool(out, "pending_reset", map.get_pending());
+    if (map.get_numTes()) printYAMLSection(out, "tes");
+    else printYAMLPlain(out, "tes", "[]");
+    for (uint8_t i = 0; i < map.get_numTes(); ++i) {
+        const TesCardAddress& card = map.get_tes(i);
+        const uint8_t addresses[] = {card.hub, card.ina, card.tca};
+        printAddressRow(out, i, TES_ADDRESS_KEYS, addresses, 3);
+    }
+    if (map.get_numLna()) printYAMLSection(out, "lna");
+    else printYAMLPlain(out, "lna", "[]");
+    for (uint8_t i = 0; i < map.get_numLna(); ++i) {
+        const LnaCardAddress& card = map.get_lna(i);
+        const uint8_t addresses[] = {card.hub, card.dac, card.inaDrain, card.inaGate};
+        printAddressRow(out, i, LNA_ADDRESS_KEYS, addresses, 4);
+    }
+    printYAMLMessage(out, "Card addresses in use");
+}
+
+// Parses up to `count` colon-separated 7-bit addresses into `addresses`,
+// leaving the entries after the last one given untouched
+static bool parseAddressList(const char* text, uint8_t* addresses, uint8_t count) {
+    for (uint8_t i = 0; i < count; ++i) {
+        char* end;
+        unsigned long value = strtoul(text, &end, 16);
+        if (end == text || value < 0x08 || value > 0x77) return false;
+        addresses[i] = (uint8_t)value;
+        if (*end == '\0') return true;
+        if (*end != ':') return false;
+        text = end + 1;
+    }
+    return false;
+}
+
+static void reportAddressStored(SerialCommands& sender, const char* command, uint8_t channel,
+                                const char* const* keys, const uint8_t* addresses, uint8_t count) {
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, command, channel);
+    for (uint8_t i = 0; i < count; ++i) {
+        printYAMLHex(out, keys[i], addresses[i], 2);
+    }
+    printYAMLMessage(out, "Card addresses stored; they apply at the next reset");
+}
+
+void cmdAddrTes(SerialCommands& sender, Args& args) {
+    DeviceMap& map = *commandContext.deviceMap;
+    uint8_t channel = args[0].getInt() - 1;
+    if (channel >= map.get_numTes()) {
+        reportError(sender, "ADDR_CHANNEL_ERROR", "No TES channel with that number on this crate.");
+        return;
+    }
+    const TesCardAddress& card = map.get_tes(channel);
+    uint8_t addresses[] = {card.hub, card.ina, card.tca};
+    if (!parseAddressList(args[1].getString(), addresses, 3)) {
+        reportError(sender, "ADDR_FORMAT_ERROR", "Expected HUB[:INA[:TCA]] in hex, each 0x08 to 0x77.");
+        return;
+    }
+    TesCardAddress stored = {addresses[0], addresses[1], addresses[2]};
+    if (reportIfError(sender, map.storeTes(channel, stored), "ADDR_STORE_ERROR", "Failed to store card addresses.")) {
+        return;
+    }
+    reportAddressStored(sender, "ADDR_TES", channel, TES_ADDRESS_KEYS, addresses, 3);
+}
+
+void cmdAddrLna(SerialCommands& sender, Args& args) {
+    DeviceMap& map = *commandContext.deviceMap;
+    uint8_t channel = args[0].getInt() - 1;
+    if (channel >= map.get_numLna()) {
+        reportError(sender, "ADDR_CHANNEL_ERROR", "No LNA channel with that number on this crate.");
+        return;
+    }
+    const LnaCardAddress& card = map.get_lna(channel);
+    uint8_t addresses[] = {card.hub, card.dac, card.inaDrain, card.inaGate};
+    if (!parseAddressList(args[1].getString(), addresses, 4)) {
+        reportError(sender, "ADDR_FORMAT_ERROR", "Expected HUB[:DAC[:INA_DRAIN[:INA_GATE]]] in hex, each 0x08 to 0x77.");
+        return;
+    }
+    LnaCardAddress stored = {addresses[0], addresses[1], addresses[2], addresses[3]};
+    if (reportIfError(sender, map.storeLna(channel, stored), "ADDR_STORE_ERROR", "Failed to store card addresses.")) {
+        return;
+    }
+    reportAddressStored(sender, "ADDR_LNA", channel, LNA_ADDRESS_KEYS, addresses, 4);
+}
+
+void cmdAddrClear(SerialCommands& sender, Args& args) {
+    if (reportIfError(sender, commandContext.deviceMap->erase(), "ADDR_STORE_ERROR", "Failed to erase card addresses.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "ADDR_CLEAR");
+    printYAMLMessage(out, "Stored card addresses erased; the defaults apply at the next reset");
+}
+
+// --- BOOT --------------------------------------------------------------------
+// setup() only probes the slots, so the command loop is live after
+// `setup_ms`; the cards' parts are set up from loop() until `ready_ms`.
+
+// "  key: [1, 4]" for the channels of one kind with `failed` set, or that
+// are absent when `failed` is false
+static void printBootChannels(Stream &out, const char* key, CrateBoot& boot, bool tes, bool failed) {
+    LineBuffer line(out);
+    printYAMLKey(line, key);
+    line.print('[');
+    bool first = true;
+    uint8_t count = tes ? boot.get_numTes() : boot.get_numLna();
+    for (uint8_t i = 0; i < count; ++i) {
+        bool listed = failed ? (tes ? boot.get_tesFailed(i) : boot.get_lnaFailed(i))
+                             : !(tes ? boot.get_tesPresent(i) : boot.get_lnaPresent(i));
+        if (!listed) continue;
+        if (!first) line.print(", ");
+        printInt(line, i + 1);
+        first = false;
+    }
+    line.println(']');
+}
+
+void cmdBoot(SerialCommands& sender, Args& args) {
+    CrateBoot& boot = *commandContext.crateBoot;
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "BOOT");
+    printYAMLInt(out, "probe_ms", boot.get_probeMs());
+    printYAMLInt(out, "setup_ms", boot.get_setupMs());
+    if (boot.get_readyMs()) printYAMLInt(out, "ready_ms", boot.get_readyMs());
+    else printYAMLPlain(out, "ready_ms", "null");
+    if (boot.get_numTes()) {
+        printBootChannels(out, "tes_absent", boot, true, false);
+        printBootChannels(out, "tes_failed", boot, true, true);
+    }
+    printBootChannels(out, "lna_absent", boot, false, false);
+    printBootChannels(out, "lna_failed", boot, false, true);
+    printYAMLMessage(out, boot.get_readyMs() ? "Every present card is set up" : "Cards are still being set up");
+}
+
+// --- TOPOLOGY ----------------------------------------------------------------
+// The I2C tree as last scanned: one branch per card, its hub and the parts
+// the card tables expect behind it. Until a scan, `present` is the boot
+// probe's and `parts` is null; `extra` is null unless the last scan of the
+// branch was a RESCAN, which sweeps it for addresses no table names.
+
+static void printTopologyRow(Stream &out, Topology& topology, uint8_t i) {
+    const TopologyBranch& branch = topology.get_branch(i);
+    bool lna = topology.isLna(i);
+    LineBuffer line(out);
+    printIndent(line, 4);
+    line.print(lna ? "- {kind: \"LNA\", channel: " : "- {kind: \"TES\", channel: ");
+    printInt(line, topology.get_channelIndex(i) + 1);
+    line.print(", hub: \"0x");
+    printHex(line, topology.get_hubAddress(i), 2);
+    line.print("\", present: ");
+    if (!branch.scannedMs) {
+        line.println("null, parts: null, extra: null}");
+        return;
+    }
+    line.print(branch.hubPresent ? "true" : "false");
+    line.print(", parts: ");
+    if (branch.partsScanned) {
+        const char* const* keys = lna ? LNA_ADDRESS_KEYS : TES_ADDRESS_KEYS;
+        uint8_t parts[TOPOLOGY_MAX_PARTS];
+        uint8_t count = topology.get_parts(i, parts);
+        line.print('{');
+        for (uint8_t p = 0; p < count; ++p) {
+            if (p) line.print(", ");
+            line.print(keys[p + 1]);
+            line.print((branch.partsPresent & (1 << p)) ? ": true" : ": false");
+        }
+        line.print('}');
+    } else {
+        line.print("null");
+    }
+    line.print(", extra: ");
+    if (branch.swept) {
+        line.print('[');
+        uint8_t kept = branch.numExtra < TOPOLOGY_MAX_EXTRA ? branch.numExtra : TOPOLOGY_MAX_EXTRA;
+        for (uint8_t e = 0; e < kept; ++e) {
+            if (e) line.print(", ");
+            line.print("\"0x");
+            printHex(line, branch.extra[e], 2);
+            line.print('"');
+        }
+        if (branch.numExtra > kept) line.print(", \"...\"");
+        line.print(']');
+    } else {
+        line.print("null");
+    }
+    line.print(", scanned_ms: ");
+    printInt(line, branch.scannedMs);
+    line.println('}');
+}
+
+static void reportTopology(SerialCommands& sender, const char* command, Topology& topology,
+                           uint8_t first, uint8_t count, const char* message) {
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", command);
+    printYAMLInt(out, "scan_us", topology.get_scanUs());
+    if (count) printYAMLSection(out, "branches");
+    else printYAMLPlain(out, "branches", "[]");
+    for (uint8_t i = first; i < first + count; ++i) {
+        printTopologyRow(out, topology, i);
+    }
+    printYAMLMessage(out, message);
+}
+
+void cmdTopology(SerialCommands& sender, Args& args) {
+    Topology& topology = *commandContext.topology;
+    reportTopology(sender, "TOPOLOGY", topology, 0, topology.get_numBranches(), "I2C tree as last scanned");
+}
+
+void cmdTopologyScan(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    Topology& topology = *commandContext.topology;
+    topology.scan();
+    reportTopology(sender, "TOPOLOGY_SCAN", topology, 0, topology.get_numBranches(), "Every branch scanned");
+}
+
+// Shared by RESCAN and RESET: one branch, swept for unlisted devices. Only
+// RESET sets up a card that was already present again.
+static void topologyRescan(SerialCommands& sender, Args& args, bool reset) {
+    Topology& topology = *commandContext.topology;
+    const char* kind = args[0].getString();
+    bool lna = strcasecmp(kind, "LNA") == 0;
+    if (!lna && strcasecmp(kind, "TES") != 0) {
+        reportError(sender, "TOPOLOGY_KIND_ERROR", "Expected TES or LNA.");
+        return;
+    }
+    uint8_t index = args[1].getInt() - 1;
+    if (index >= (lna ? commandContext.numLna : commandContext.numTes)) {
+        reportError(sender, "TOPOLOGY_CHANNEL_ERROR", "No channel with that number on this crate.");
+        return;
+    }
+    const void* driver = lna ? (const void*)commandContext.lnaDriver[index] : commandContext.tesDriver[index];
+    if (reportIfBusy(sender, driver)) {
+        return;
+    }
+    topology.rescan(lna, index, true, reset);
+    reportTopology(sender, reset ? "TOPOLOGY_RESET" : "TOPOLOGY_RESCAN", topology,
+                   lna ? topology.get_numTes() + index : index, 1, reset ? "Branch rescanned and reset" : "Branch rescanned");
+}
+
+void cmdTopologyRescan(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    topologyRescan(sender, args, false);
+}
+
+void cmdTopologyReset(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    topologyRescan(sender, args, true);
+}
@@ -0,0 +1,56 @@
+#ifndef SYSTEM_COMMANDS_H
+#define SYSTEM_COMMANDS_H
+
+#include <StaticSerialCommands.h>
+#include "CommandArgs.h"
+
+// Crate-wide DAC, JOB, MEM, ADDR, BOOT and TOPOLOGY commands, acting on commandContext
+
+void cmdDACSet(SerialCommands& sender, Args& args);
+void cmdDACGet(SerialCommands& sender, Args& args);
+
+void cmdJobList(SerialCommands& sender, Args& args);
+void cmdJobStatus(SerialCommands& sender, Args& args);
+void cmdJobCancel(SerialCommands& sender, Args& args);
+
+void cmdMem(SerialCommands& sender, Args& args);
+void cmdMemReset(SerialCommands& sender, Args& args);
+
+void cmdAddr(SerialCommands& sender, Args& args);
+void cmdAddrTes(SerialCommands& sender, Args& args);
+void cmdAddrLna(SerialCommands& sender, Args& args);
+void cmdAddrClear(SerialCommands& sender, Args& args);
+
+void cmdBoot(SerialCommands& sender, Args& args);
+
+void cmdTopology(SerialCommands& sender, Args& args);
+void cmdTopologyScan(SerialCommands& sender, Args& args);
+void cmdTopologyRescan(SerialCommands& sender, Args& args);
+void cmdTopologyReset(SerialCommands& sender, Args& args);
+
+// Entries of a sketch's dacCommands[] table. DAC SET writes VALUE plus
+// commandContext.mainDacOffset, so `valueArg` bounds VALUE before the offset.
+#define DAC_COMMANDS(valueArg) \
+    COMMAND(cmdDACSet, "SET", valueArg, nullptr, "Set Main DAC Value"), \
+    COMMAND(cmdDACGet, "GET", nullptr, "Get Main DAC Value")
+
+#define JOB_COMMANDS \
+    COMMAND(cmdJobList, "LIST", nullptr, "List Jobs"), \
+    COMMAND(cmdJobStatus, "STATUS", jobIdArg, nullptr, "Get Job State and Result"), \
+    COMMAND(cmdJobCancel, "CANCEL", jobIdArg, nullptr, "Stop a Running Job")
+
+#define MEM_COMMANDS \
+    COMMAND(cmdMemReset, "RESET", nullptr, "Restart the Free-RAM Low-Water Mark")
+
+// Stored addresses take effect at the next reset
+#define ADDR_COMMANDS \
+    COMMAND(cmdAddrTes, "TES", addrChanArg, addrListArg, nullptr, "Store a TES Card's HUB:INA:TCA Addresses"), \
+    COMMAND(cmdAddrLna, "LNA", addrChanArg, addrListArg, nullptr, "Store an LNA Card's HUB:DAC:INA_DRAIN:INA_GATE Addresses"), \
+    COMMAND(cmdAddrClear, "CLEAR", nullptr, "Erase the Stored Addresses (Defaults at Next Reset)")
+
+#define TOPOLOGY_COMMANDS \
+    COMMAND(cmdTopologyScan, "SCAN", nullptr, "Probe Every Card's Hub and Parts"), \
+    COMMAND(cmdTopologyRescan, "RESCAN", topologyKindArg, addrChanArg, nullptr, "Rescan One Card and Sweep It for Other Devices"), \
+    COMMAND(cmdTopologyReset, "RESET", topologyKindArg, addrChanArg, nullptr, "Rescan One Card and Set It Up Again, as at Boot")
+
+#endif // SYSTEM_COMMANDS_H
@@ -0,0 +1,494 @@
+#include "TelemetryCommands.h"
+#include "Responses.h"
+#include "BinaryCommands.h"
+#include "../helpers/I2CStats.h"
+
+#define STREAM_LIST_SIZE 96 // Longest STREAM CONFIG list: SAMPLER_MAX_SOURCES "DRAINV:ch" items
+
+// --- SNAPSHOT --------------------------------------------------------------
+// One document covering the whole crate. Channels are read in order with
+// readAll(), so each card's route is opened once, and each channel is a
+// single YAML flow map to keep the output compact. A channel that fails to
+// read reports its error inline instead of aborting the snapshot.
+
+static void printSnapshotTes(Print &out, const TesReading &reading) {
+    out.print("enabled: ");
+    printBool(out, reading.enabled);
+    out.print(", tca_bits: \"0x");
+    printHex(out, reading.tcaBits, 5);
+    out.print("\", shunt_mV: ");
+    printFixed(out, reading.shunt_mV, 4);
+    out.print(", bus_V: ");
+    printFixed(out, reading.bus_V, 4);
+    out.print(", current_mA: ");
+    printFixed(out, reading.current_mA, 4);
+    out.print(", power_mW: ");
+    printFixed(out, reading.power_mW, 4);
+    out.print(", timestamp_us: ");
+    printInt(out, reading.timestamp_us);
+}
+
+static void printSnapshotLnaSide(Print &out, const char *side, const LnaReading &reading) {
+    out.print(side);
+    out.print(": {dac_value: ");
+    printInt(out, reading.dacValue);
+    out.print(", enabled: ");
+    printBool(out, reading.enabled);
+    out.print(", shunt_mV: ");
+    printFixed(out, reading.shunt_mV, 4);
+    out.print(", bus_V: ");
+    printFixed(out, reading.bus_V, 4);
+    out.print(", current_mA: ");
+    printFixed(out, reading.current_mA, 4);
+    out.print(", power_mW: ");
+    printFixed(out, reading.power_mW, 4);
+    out.print(", timestamp_us: ");
+    printInt(out, reading.timestamp_us);
+    out.print("}");
+}
+
+void cmdSnapshot(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    Stream &out = sender.getSerial();
+    unsigned long start = millis();
+    uint16_t dacValue;
+    uint8_t status = commandContext.mainDac.readDAC(MCP4728_CHANNEL_A, dacValue);
+    if (reportIfError(sender, status, "DAC_GET_ERROR", "Failed to get main DAC value.")) {
+        return;
+    }
+
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "SNAPSHOT");
+    printYAMLInt(out, "dac_value", dacValue);
+    printYAMLSection(out, "tes");
+    for (uint8_t i = 0; i < commandContext.numTes; ++i) {
+        TesReading reading;
+        status = commandContext.tesDriver[i]->readAll(reading);
+        LineBuffer line(out);
+        printIndent(line, 4);
+        line.print("- {channel: ");
+        printInt(line, i + 1);
+        line.print(", ");
+        if (status) printInlineError(line, "TES_READ_ERROR", status);
+        else printSnapshotTes(line, reading);
+        line.println("}");
+    }
+    printYAMLSection(out, "lna");
+    for (uint8_t i = 0; i < commandContext.numLna; ++i) {
+        LnaReading drain, gate;
+        status = commandContext.lnaDriver[i]->readAll(LNA_DRAIN, drain);
+        if (!status) status = commandContext.lnaDriver[i]->readAll(LNA_GATE, gate);
+        LineBuffer line(out);
+        printIndent(line, 4);
+        line.print("- {channel: ");
+        printInt(line, i + 1);
+        line.print(", ");
+        if (status) {
+            printInlineError(line, "LNA_READ_ERROR", status);
+        } else {
+            printSnapshotLnaSide(line, "drain", drain);
+            line.print(", ");
+            printSnapshotLnaSide(line, "gate", gate);
+        }
+        line.println("}");
+    }
+    printYAMLInt(out, "elapsed_ms", millis() - start);
+    printYAMLMessage(out, "Snapshot of all channels");
+}
+
+// --- STATS -------------------------------------------------------------------
+
+#if I2C_STATS
+static void printI2CCounters(Print &out, const I2CCounters& c) {
+    out.print(", transactions: ");
+    printInt(out, c.transactions);
+    out.print(", bytes: ");
+    printInt(out, c.bytes);
+    out.print(", errors: ");
+    printInt(out, c.errors);
+    out.print(", bus_us: ");
+    printInt(out, c.micros);
+}
+#endif
+
+void cmdStats(SerialCommands& sender, Args& args) {
+#if I2C_STATS
+    Stream &out = sender.getSerial();
+    const I2CCounters& totals = i2cStats.get_totals();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "STATS");
+    printYAMLInt(out, "elapsed_ms", i2cStats.get_elapsedMs());
+    printYAMLInt(out, "transactions", totals.transactions);
+    printYAMLInt(out, "bytes", totals.bytes);
+    printYAMLInt(out, "errors", totals.errors);
+    printYAMLInt(out, "bus_us", totals.micros);
+
+    // endTransmission() codes: 1 data too long, 2 address NACK, 3 data NACK,
+    // 4 other, 5 timeout
+    {
+        LineBuffer line(out);
+        printYAMLKey(line, "error_codes");
+        line.print("{");
+        for (uint8_t code = 1; code < I2C_STATS_SHORT_READ; ++code) {
+            printInt(line, code);
+            line.print(": ");
+            printInt(line, i2cStats.get_errorCount(code));
+            line.print(", ");
+        }
+        line.print("short_read: ");
+        printInt(line, i2cStats.get_errorCount(I2C_STATS_SHORT_READ));
+        line.println("}");
+    }
+
+    if (i2cStats.get_deviceCount()) printYAMLSection(out, "devices");
+    else printYAMLPlain(out, "devices", "[]");
+    for (uint8_t i = 0; i < i2cStats.get_deviceCount(); ++i) {
+        const I2CDeviceStats& device = i2cStats.get_device(i);
+        LineBuffer line(out);
+        printIndent(line, 4);
+        line.print("- {address: \"0x");
+        printHex(line, device.address, 2);
+        line.print("\"");
+        printI2CCounters(line, device.counters);
+        line.print(", last_error: ");
+        printInt(line, device.lastError);
+        line.println("}");
+    }
+
+    if (i2cStats.get_commandCount()) printYAMLSection(out, "commands");
+    else printYAMLPlain(out, "commands", "[]");
+    for (uint8_t i = 0; i < i2cStats.get_commandCount(); ++i) {
+        const I2CCommandStats& command = i2cStats.get_command(i);
+        LineBuffer line(out);
+        printIndent(line, 4);
+        line.print("- {name: ");
+        printQuoted(line, command.name);
+        line.print(", calls: ");
+        printInt(line, command.calls);
+        printI2CCounters(line, command.counters);
+        line.println("}");
+    }
+    printYAMLMessage(out, "I2C statistics since reset");
+#else
+    reportError(sender, "STATS_DISABLED", "Built with I2C_STATS=0.");
+#endif
+}
+
+void cmdStatsReset(SerialCommands& sender, Args& args) {
+#if I2C_STATS
+    i2cStats.reset();
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "STATS_RESET");
+    printYAMLMessage(out, "I2C statistics cleared");
+#else
+    reportError(sender, "STATS_DISABLED", "Built with I2C_STATS=0.");
+#endif
+}
+
+// --- STREAM ------------------------------------------------------------------
+// The sampler reads its sources every period into a ring buffer; while it
+// runs, loop() prints one buffered row per pass as a "#STREAM" line between
+// command responses. Rows are held back in binary mode.
+
+struct StreamKind {
+    const char* name;
+    SampleKind kind;
+};
+
+static const StreamKind streamKinds[] = {
+    { "TES", SAMPLE_TES_CURRENT },
+    { "DRAIN", SAMPLE_LNA_DRAIN_CURRENT },
+    { "GATE", SAMPLE_LNA_GATE_CURRENT },
+    { "DRAINV", SAMPLE_LNA_DRAIN_VOLTAGE },
+    { "GATEV", SAMPLE_LNA_GATE_VOLTAGE },
+};
+
+static const StreamKind* findStreamKind(const char* name) {
+    for (size_t i = 0; i < sizeof(streamKinds) / sizeof(StreamKind); ++i) {
+        if (strcasecmp(name, streamKinds[i].name) == 0) return &streamKinds[i];
+    }
+    return nullptr;
+}
+
+// Parses one "KIND:ch" item (modified in place); false if malformed
+static bool parseSampleSource(char* item, SampleSource& source) {
+    char* colon = strchr(item, ':');
+    if (!colon) return false;
+    *colon = '\0';
+    char* end;
+    long channel = strtol(colon + 1, &end, 10);
+    if (end == colon + 1 || *end != '\0') return false;
+
+    const StreamKind* kind = findStreamKind(item);
+    if (!kind) return false;
+    if (kind->kind == SAMPLE_TES_CURRENT) {
+        if (channel < 1 || channel > commandContext.numTes) return false;
+        source.driver = commandContext.tesDriver[channel - 1];
+    } else {
+        if (channel < 1 || channel > commandContext.numLna) return false;
+        source.driver = commandContext.lnaDriver[channel - 1];
+    }
+    source.kind = kind->kind;
+    source.channel = channel;
+    return true;
+}
+
+// Replaces the sampler's sources with "KIND:ch" items; false on a malformed list
+// Parses the whole list into `sources` without touching the sampler, so a
+// bad item leaves the running configuration as it was. Returns the number
+// of sources, or 0 if any item is invalid or there are too many.
+static uint8_t parseStreamSources(const char* list, SampleSource* sources) {
+    char buffer[STREAM_LIST_SIZE];
+    if (strlen(list) >= sizeof(buffer)) return 0;
+    strcpy(buffer, list);
+
+    uint8_t count = 0;
+    for (char* item = strtok(buffer, ","); item; item = strtok(nullptr, ",")) {
+        if (count == SAMPLER_MAX_SOURCES || !parseSampleSource(item, sources[count])) return 0;
+        count++;
+    }
+    return count;
+}
+
+static void printStreamSources(Stream &out) {
+    LineBuffer line(out);
+    printYAMLKey(line, "sources");
+    line.print("[");
+    for (uint8_t i = 0; i < commandContext.sampler->get_sourceCount(); ++i) {
+        const SampleSource& source = commandContext.sampler->get_source(i);
+        line.print(i ? ", " : "");
+        line.print("{kind: ");
+        printQuoted(line, sampleKindName(source.kind));
+        line.print(", channel: ");
+        printInt(line, source.channel);
+        line.print("}");
+    }
+    line.println("]");
+}
+
+void serviceStream() {
+    SampleRow row;
+    if (!binaryMode && commandContext.sampler->pop(row)) {
+        Sampler::printRow(Serial, row, commandContext.sampler->get_sourceCount());
+    }
+}
+
+void cmdStreamConfig(SerialCommands& sender, Args& args) {
+    if (commandContext.sampler->isRunning()) {
+        reportError(sender, "STREAM_RUNNING", "STREAM STOP before changing the configuration.");
+        return;
+    }
+    SampleSource sources[SAMPLER_MAX_SOURCES];
+    uint8_t count = parseStreamSources(args[1].getString(), sources);
+    if (!count) {
+        reportError(sender, "STREAM_ARG_ERROR", "Expected up to 8 KIND:ch items, KIND one of TES, DRAIN, GATE, DRAINV, GATEV.");
+        return;
+    }
+    commandContext.sampler->clearSources();
+    for (uint8_t i = 0; i < count; ++i) {
+        commandContext.sampler->addSource(sources[i].kind, sources[i].channel, sources[i].driver);
+    }
+    commandContext.sampler->setPeriod_ms(args[0].getInt());
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "STREAM_CONFIG");
+    printYAMLInt(out, "period_ms", commandContext.sampler->get_period_ms());
+    printStreamSources(out);
+    printYAMLMessage(out, "Stream configured");
+}
+
+void cmdStreamStart(SerialCommands& sender, Args& args) {
+    if (!commandContext.sampler->get_sourceCount()) {
+        reportError(sender, "STREAM_NOT_CONFIGURED", "Set the sources with STREAM CONFIG first.");
+        return;
+    }
+    commandContext.sampler->start();
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "STREAM_START");
+    printYAMLInt(out, "period_ms", commandContext.sampler->get_period_ms());
+    printStreamSources(out);
+    printYAMLMessage(out, "Streaming; rows follow as #STREAM seq,timestamp_us,values...");
+}
+
+void cmdStreamStop(SerialCommands& sender, Args& args) {
+    commandContext.sampler->stop();
+    // Flush what is buffered so no row follows the response
+    SampleRow row;
+    while (commandContext.sampler->pop(row)) {
+        Sampler::printRow(sender.getSerial(), row, commandContext.sampler->get_sourceCount());
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "STREAM_STOP");
+    printYAMLInt(out, "rows", commandContext.sampler->get_taken());
+    printYAMLInt(out, "dropped", commandContext.sampler->get_dropped());
+    printYAMLMessage(out, "Stream stopped");
+}
+
+void cmdStreamStatus(SerialCommands& sender, Args& args) {
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "STREAM_STATUS");
+    printYAMLBool(out, "running", commandContext.sampler->isRunning());
+    printYAMLInt(out, "period_ms", commandContext.sampler->get_period_ms());
+    printStreamSources(out);
+    printYAMLInt(out, "rows", commandContext.sampler->get_taken());
+    printYAMLInt(out, "dropped", commandContext.sampler->get_dropped());
+    printYAMLInt(out, "buffered", commandContext.sampler->get_buffered());
+    printYAMLMessage(out, "Stream status");
+}
+
+// --- HISTORY -----------------------------------------------------------------
+// Dumps one series of the on-device history: every retained 1 s, 1 min and
+// 1 h bucket, oldest first, as [min, max, mean] in mA. Buckets without
+// readings (a blocking command held loop()) are null.
+
+static void printHistoryLevel(Stream &out, const char* key, uint8_t series, uint8_t level) {
+    LineBuffer line(out);
+    printYAMLKey(line, key);
+    line.print("[");
+    for (uint8_t i = 0; i < commandContext.history->get_bucketCount(level); ++i) {
+        HistoryBucket bucket = commandContext.history->get_bucket(series, level, i);
+        line.print(i ? ", " : "");
+        if (bucket.min > bucket.max) {
+            line.print("null");
+            continue;
+        }
+        line.print("[");
+        printFixed(line, bucket.min * (HISTORY_UNIT_UA / 1000.0f), 3);
+        line.print(", ");
+        printFixed(line, bucket.max * (HISTORY_UNIT_UA / 1000.0f), 3);
+        line.print(", ");
+        printFixed(line, bucket.mean * (HISTORY_UNIT_UA / 1000.0f), 3);
+        line.print("]");
+    }
+    line.println("]");
+}
+
+void cmdHistory(SerialCommands& sender, Args& args) {
+    char buffer[16];
+    strncpy(buffer, args[0].getString(), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    int8_t series = -1;
+    char* colon = strchr(buffer, ':');
+    if (colon) {
+        *colon = '\0';
+        const StreamKind* kind = findStreamKind(buffer);
+        if (kind) series = commandContext.history->find(kind->kind, atoi(colon + 1));
+    }
+    if (series < 0) {
+        reportError(sender, "HISTORY_ARG_ERROR", "Expected TES:ch, DRAIN:ch or GATE:ch.");
+        return;
+    }
+    const SampleSource& source = commandContext.history->get_series(series);
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "HISTORY");
+    printYAMLString(out, "kind", sampleKindName(source.kind));
+    printYAMLInt(out, "channel", source.channel);
+    printYAMLString(out, "unit", "mA");
+    printYAMLInt(out, "uptime_s", commandContext.history->get_seconds());
+    printYAMLInt(out, "seconds_end_s", commandContext.history->get_end_s(0));
+    printYAMLInt(out, "minutes_end_s", commandContext.history->get_end_s(1));
+    printYAMLInt(out, "hours_end_s", commandContext.history->get_end_s(2));
+    printYAMLInt(out, "sample_ms", HISTORY_SAMPLE_MS);
+    printYAMLInt(out, "read_errors", commandContext.history->get_readErrors());
+    printHistoryLevel(out, "seconds", series, 0);
+    printHistoryLevel(out, "minutes", series, 1);
+    printHistoryLevel(out, "hours", series, 2);
+    printYAMLMessage(out, "Buckets oldest first as [min, max, mean]; the newest of each level ends at its *_end_s");
+}
+
+// --- SUB ---------------------------------------------------------------------
+// Each subscription reads its source every SUB_POLL_MS and reports only when
+// the value moves beyond its deadband from the last report, or when its
+// heartbeat passes without one. loop() prints one "#SUB" line per pass
+// between command responses; reports are held back in binary mode.
+
+void serviceSubscriptions() {
+    if (binaryMode) {
+        return;
+    }
+    const Subscription* sub = commandContext.subscriptions->popReport();
+    if (sub) {
+        Subscriptions::printReport(Serial, *sub);
+    }
+}
+
+static void printSubscription(Stream &out, const Subscription& sub) {
+    LineBuffer line(out);
+    printIndent(line, 4);
+    line.print("- {id: ");
+    printInt(line, sub.id);
+    line.print(", kind: ");
+    printQuoted(line, sampleKindName(sub.source.kind));
+    line.print(", channel: ");
+    printInt(line, sub.source.channel);
+    line.print(", deadband: ");
+    printInt(line, sub.deadband);
+    line.print(", heartbeat_ms: ");
+    printInt(line, sub.heartbeat_ms);
+    line.println("}");
+}
+
+void cmdSubAdd(SerialCommands& sender, Args& args) {
+    char buffer[16];
+    strncpy(buffer, args[0].getString(), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+    SampleSource source;
+    if (!parseSampleSource(buffer, source)) {
+        reportError(sender, "SUB_ARG_ERROR", "Expected KIND:ch, KIND one of TES, DRAIN, GATE, DRAINV, GATEV.");
+        return;
+    }
+    int32_t deadband = (int32_t)lroundf(args[1].getFloat() * 1000.0f);
+    uint8_t id;
+    uint8_t status = commandContext.subscriptions->add(source, deadband, args[2].getInt(), id);
+    if (reportIfError(sender, status, "SUB_TABLE_FULL", "Every subscription slot is in use; SUB REMOVE one first.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "SUB_ADD");
+    printYAMLInt(out, "id", id);
+    printYAMLString(out, "kind", sampleKindName(source.kind));
+    printYAMLInt(out, "channel", source.channel);
+    printYAMLInt(out, "deadband", deadband);
+    printYAMLInt(out, "heartbeat_ms", args[2].getInt());
+    printYAMLMessage(out, "Subscribed; reports follow as #SUB id,time_ms,value,reason");
+}
+
+void cmdSubRemove(SerialCommands& sender, Args& args) {
+    if (!commandContext.subscriptions->remove(args[0].getInt())) {
+        reportError(sender, "SUB_NOT_FOUND", "No subscription with that id.");
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "SUB_REMOVE");
+    printYAMLInt(out, "id", args[0].getInt());
+    printYAMLMessage(out, "Subscription removed");
+}
+
+void cmdSubList(SerialCommands& sender, Args& args) {
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "SUB_LIST");
+    printYAMLInt(out, "poll_ms", SUB_POLL_MS);
+    if (commandContext.subscriptions->get_count()) printYAMLSection(out, "subscriptions");
+    else printYAMLPlain(out, "subscriptions", "[]");
+    for (uint8_t i = 0; i < SUB_MAX; ++i) {
+        const Subscription& sub = commandContext.subscriptions->get_slot(i);
+        if (sub.id) printSubscription(out, sub);
+    }
+    printYAMLMessage(out, "Subscriptions");
+}
+
+void cmdSubClear(SerialCommands& sender, Args& args) {
+    commandContext.subscriptions->clear();
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "SUB_CLEAR");
+    printYAMLMessage(out, "Subscriptions cleared");
+}
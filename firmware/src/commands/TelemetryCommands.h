@@ -0,0 +1,48 @@
+#ifndef TELEMETRY_COMMANDS_H
+#define TELEMETRY_COMMANDS_H
+
+#include <StaticSerialCommands.h>
+#include "CommandArgs.h"
+
+// SNAPSHOT, STATS, STREAM, HISTORY and SUB, acting on commandContext. The
+// STREAM, HISTORY and SUB handlers need its sampler, history and
+// subscriptions.
+
+void cmdSnapshot(SerialCommands& sender, Args& args);
+
+void cmdStats(SerialCommands& sender, Args& args);
+void cmdStatsReset(SerialCommands& sender, Args& args);
+
+void cmdStreamConfig(SerialCommands& sender, Args& args);
+void cmdStreamStart(SerialCommands& sender, Args& args);
+void cmdStreamStop(SerialCommands& sender, Args& args);
+void cmdStreamStatus(SerialCommands& sender, Args& args);
+
+void cmdHistory(SerialCommands& sender, Args& args);
+
+void cmdSubAdd(SerialCommands& sender, Args& args);
+void cmdSubRemove(SerialCommands& sender, Args& args);
+void cmdSubList(SerialCommands& sender, Args& args);
+void cmdSubClear(SerialCommands& sender, Args& args);
+
+// Called from loop(): print at most one buffered "#STREAM" row or "#SUB"
+// report between command responses; both hold back in binary mode
+void serviceStream();
+void serviceSubscriptions();
+
+#define STATS_COMMANDS \
+    COMMAND(cmdStatsReset, "RESET", nullptr, "Clear I2C Statistics")
+
+#define STREAM_COMMANDS \
+    COMMAND(cmdStreamConfig, "CONFIG", streamPeriodArg, streamSourcesArg, nullptr, "Set Sample Period and Sources"), \
+    COMMAND(cmdStreamStart, "START", nullptr, "Start Sampling and Streaming Rows"), \
+    COMMAND(cmdStreamStop, "STOP", nullptr, "Stop Streaming"), \
+    COMMAND(cmdStreamStatus, "STATUS", nullptr, "Get Sampler Configuration and Counters")
+
+#define SUB_COMMANDS \
+    COMMAND(cmdSubAdd, "ADD", subSourceArg, subDeadbandArg, subHeartbeatArg, nullptr, "Report a Value on Change or Heartbeat"), \
+    COMMAND(cmdSubRemove, "REMOVE", subIdArg, nullptr, "Remove a Subscription"), \
+    COMMAND(cmdSubList, "LIST", nullptr, "List Subscriptions"), \
+    COMMAND(cmdSubClear, "CLEAR", nullptr, "Remove Every Subscription")
+
+#endif // TELEMETRY_COMMANDS_H
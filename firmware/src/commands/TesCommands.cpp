@@ -0,0 +1,422 @@
+#include "TesCommands.h"
+#include "Quantities.h"
+#include "Responses.h"
+#include "../helpers/I2CStats.h"
+#include "../jobs/Jobs.h"
+
+#define TESSET_LIST_SIZE 192 // Longest TESSET list, as long as the TES sketch's command line
+
+typedef uint8_t (TESDriver::*TesGetter)(float&);
+
+// Getter per QUANTITIES row
+static const TesGetter TES_GETTERS[QUANTITY_COUNT] = {
+    &TESDriver::getShuntVoltage_mV,
+    &TESDriver::getBusVoltage_V,
+    &TESDriver::getCurrent_mA,
+    &TESDriver::getPower_mW,
+};
+
+static uint8_t tesChannel(Args& args) {
+    return args[0].getInt() - 1;
+}
+
+// Shared by SETINT and SETHEX, once the channel is known to be free
+static void tesSetBits(SerialCommands& sender, uint8_t channel, uint32_t value,
+                       const char* command, const char* errKey, const char* message) {
+    uint8_t status = commandContext.tesDriver[channel]->setAllOutputPins(value);
+    if (reportIfError(sender, status, errKey, "Failed to set TES TCA bits.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, command, channel);
+    printYAMLHex(out, "tca_bits", value, 5);
+    printYAMLMessage(out, message);
+}
+
+void cmdTESSetInt(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    if (reportIfBusy(sender, commandContext.tesDriver[channel])) {
+        return;
+    }
+    tesSetBits(sender, channel, args[1].getInt(), "TES_SETINT", "TES_SETINT_ERROR", "TES TCA bits set (int)");
+}
+
+void cmdTESSetHex(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    uint32_t value = strtoul(args[1].getString(), nullptr, 16);
+    if (reportIfBusy(sender, commandContext.tesDriver[channel])) {
+        return;
+    }
+    if (value > 0xFFFFF) {
+        reportError(sender, "TES_SETHEX_VALUE_ERROR", "Hex value exceeds 20 bits.");
+        return;
+    }
+    tesSetBits(sender, channel, value, "TES_SETHEX", "TES_SETHEX_ERROR", "TES TCA bits set (hex)");
+}
+
+// Shared by ENABLE and DISABLE
+static void tesSetEnable(SerialCommands& sender, Args& args, bool enable) {
+    uint8_t channel = tesChannel(args);
+    uint8_t status = commandContext.tesDriver[channel]->setOutEnable(enable);
+    if (reportIfError(sender, status, enable ? "TES_ENABLE_ERROR" : "TES_DISABLE_ERROR",
+                      enable ? "Failed to enable TES outputs." : "Failed to disable TES outputs.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, enable ? "TES_ENABLE" : "TES_DISABLE", channel);
+    printYAMLBool(out, "enabled", enable);
+    printYAMLMessage(out, enable ? "TES outputs enabled" : "TES outputs disabled");
+}
+
+void cmdTESEnable(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesSetEnable(sender, args, true);
+}
+
+void cmdTESDisable(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesSetEnable(sender, args, false);
+}
+
+// Shared by SHUNT, BUS, CURRENT and POWER
+static void tesRead(SerialCommands& sender, Args& args, Quantity quantity) {
+    uint8_t channel = tesChannel(args);
+    float value = 0;
+    uint8_t status = (commandContext.tesDriver[channel]->*TES_GETTERS[quantity])(value);
+    reportQuantity(sender, quantity, status, value, "TES", channel, nullptr, "TES");
+}
+
+void cmdTESShunt(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesRead(sender, args, QUANTITY_SHUNT);
+}
+
+void cmdTESBus(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesRead(sender, args, QUANTITY_BUS);
+}
+
+void cmdTESCurrent(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesRead(sender, args, QUANTITY_CURRENT);
+}
+
+void cmdTESPower(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesRead(sender, args, QUANTITY_POWER);
+}
+
+const char* tesSetMethodName(TesSetMethod method) {
+    if (method == TES_SET_MODEL) return "model";
+    if (method == TES_SET_MODEL_FALLBACK) return "model_fallback";
+    return "search";
+}
+
+void cmdTESSet(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    float current_mA = args[1].getFloat();
+    uint32_t finalState;
+    TesSetMethod method;
+    TESDriver* tes = commandContext.tesDriver[channel];
+    if (reportIfBusy(sender, tes)) {
+        return;
+    }
+    uint32_t start = millis();
+    uint8_t status = tes->setCurrent_mA(current_mA, &finalState, &current_mA, 10, &method);
+    if (reportIfError(sender, status, "TES_SET_CURRENT_ERROR", "Failed to set TES output current.")) {
+        return;
+    }
+    uint32_t elapsed = millis() - start;
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_SET", channel);
+    printYAMLFloat(out, "current_mA", current_mA, 4);
+    printYAMLHex(out, "tca_bits", finalState, 5);
+    printYAMLString(out, "method", tesSetMethodName(method));
+    printYAMLInt(out, "elapsed_ms", elapsed);
+    printYAMLMessage(out, "TES output current set");
+}
+
+static void printTesCalibration(Stream &out, const TesCalibration &cal) {
+    printYAMLBool(out, "calibrated", cal.valid);
+    if (!cal.valid) return;
+    printYAMLFloat(out, "base_mA", cal.base_mA, 4);
+    printYAMLInt(out, "measured_bits", cal.measuredBits);
+    // Bit 0 first
+    LineBuffer line(out);
+    printYAMLKey(line, "weights_mA");
+    line.print("[");
+    for (int bit = 0; bit < TES_NUM_BITS; ++bit) {
+        if (bit) line.print(", ");
+        printFixed(line, cal.weight_mA[bit], 6);
+    }
+    line.println("]");
+}
+
+void cmdTESCal(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    TESDriver* tes = commandContext.tesDriver[channel];
+    if (reportIfBusy(sender, tes)) {
+        return;
+    }
+    uint32_t start = millis();
+    uint8_t status = tes->calibrate(10);
+    if (reportIfError(sender, status, "TES_CAL_ERROR", "Failed to calibrate TES bit weights. Is the output enabled?")) {
+        return;
+    }
+    uint32_t elapsed = millis() - start;
+    bool saved = false;
+#if TES_CAL_EEPROM
+    saved = tes->saveCalibration(channel) == 0;
+#endif
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_CAL", channel);
+    printTesCalibration(out, tes->get_calibration());
+    printYAMLBool(out, "saved", saved);
+    printYAMLInt(out, "elapsed_ms", elapsed);
+    printYAMLMessage(out, "TES bit weights calibrated");
+}
+
+void cmdTESCalGet(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    TESDriver* tes = commandContext.tesDriver[channel];
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_CALGET", channel);
+    printTesCalibration(out, tes->get_calibration());
+    printYAMLFloat(out, "tolerance_mA", tes->get_calibrationTolerance(), 4);
+    printYAMLMessage(out, "TES bit-weight calibration");
+}
+
+void cmdTESCalClear(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    commandContext.tesDriver[channel]->clearCalibration();
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_CALCLEAR", channel);
+    printYAMLMessage(out, "TES calibration cleared");
+}
+
+void cmdTESAdc(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    INA219Profile profile;
+    if (!parseInaProfile(args[1].getString(), profile)) {
+        reportError(sender, "INA_PROFILE_ARG_ERROR", "Profile must be DEFAULT, MONITOR or FAST.");
+        return;
+    }
+    TESDriver* tes = commandContext.tesDriver[channel];
+    if (reportIfBusy(sender, tes)) {
+        return;
+    }
+    uint8_t status = tes->setInaProfile(profile);
+    if (reportIfError(sender, status, "TES_ADC_ERROR", "Failed to configure INA219.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_ADC", channel);
+    printYAMLString(out, "profile", inaProfileName(profile));
+    printYAMLMessage(out, "TES INA219 profile set");
+}
+
+void cmdTESSetAsync(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    float current_mA = args[1].getFloat();
+    if (reportIfBusy(sender, commandContext.tesDriver[channel])) {
+        return;
+    }
+    uint8_t number = channel + 1;
+    uint16_t id = commandContext.jobs.submit<TesSetJob>(&commandContext.tesDriver[channel], &number, &current_mA, 1, 10);
+    reportJobSubmitted(sender, "TES_SET", id);
+}
+
+// Shared by INC and DEC
+static void tesBump(SerialCommands& sender, Args& args, bool increase) {
+    uint8_t channel = tesChannel(args);
+    uint32_t delta = args[1].getInt();
+    uint32_t finalState;
+    const char* errKey = increase ? "TES_INC_ERROR" : "TES_DEC_ERROR";
+    TESDriver* tes = commandContext.tesDriver[channel];
+    if (reportIfBusy(sender, tes)) {
+        return;
+    }
+    uint8_t status = tes->bumpOutputPins(increase ? static_cast<int32_t>(delta) : -static_cast<int32_t>(delta));
+    if (reportIfError(sender, status, errKey, increase ? "Failed to increase TES TCA bits." : "Failed to decrease TES TCA bits.")) {
+        return;
+    }
+    status = tes->getAllOutputPins(finalState);
+    if (reportIfError(sender, status, errKey, "Failed to read TES TCA bits.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, increase ? "TES_INC" : "TES_DEC", channel);
+    printYAMLInt(out, "delta", delta);
+    printYAMLHex(out, "tca_bits", finalState, 5);
+    printYAMLMessage(out, increase ? "TES TCA bits increased" : "TES TCA bits decreased");
+}
+
+void cmdTESInc(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesBump(sender, args, true);
+}
+
+void cmdTESDec(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    tesBump(sender, args, false);
+}
+
+void cmdTESBits(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    uint32_t currentState;
+    uint8_t status = commandContext.tesDriver[channel]->getAllOutputPins(currentState);
+    if (reportIfError(sender, status, "TES_TCA_READ_ERROR", "Failed to read TES TCA bits.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_BITS", channel);
+    printYAMLHex(out, "tca_bits", currentState, 5);
+    printYAMLMessage(out, "TES TCA bits (hex)");
+}
+
+void cmdTESGetAll(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channel = tesChannel(args);
+    TesReading reading;
+    uint8_t status = commandContext.tesDriver[channel]->readAll(reading);
+    if (reportIfError(sender, status, "TES_READ_ERROR", "Failed to read TES parameters.")) {
+        return;
+    }
+    Stream &out = sender.getSerial();
+    printChannelHeader(out, "TES_GET", channel);
+    printYAMLBool(out, "enabled", reading.enabled);
+    printYAMLHex(out, "tca_bits", reading.tcaBits, 5);
+    printYAMLFloat(out, "shunt_mV", reading.shunt_mV, 4);
+    printYAMLFloat(out, "bus_V", reading.bus_V, 4);
+    printYAMLFloat(out, "current_mA", reading.current_mA, 4);
+    printYAMLFloat(out, "power_mW", reading.power_mW, 4);
+    printYAMLInt(out, "timestamp_us", reading.timestamp_us);
+    printYAMLInt(out, "duration_us", reading.duration_us);
+    printYAMLMessage(out, "TES parameters");
+}
+
+// --- TESSET ----------------------------------------------------------------
+// Interleaved SET across several channels. Takes "ch:mA" pairs separated by
+// commas; "*:mA" applies one target to every channel.
+
+// Returns the number of channels parsed, or 0 on a malformed list
+static uint8_t parseTesTargets(const char* list, uint8_t* channels, float* targets) {
+    char buffer[TESSET_LIST_SIZE];
+    if (strlen(list) >= sizeof(buffer)) return 0;
+    strcpy(buffer, list);
+
+    uint8_t numTes = commandContext.numTes; // At most TES_MAX_INTERLEAVED, checked by the sketch
+    bool used[TES_MAX_INTERLEAVED] = {};
+    uint8_t count = 0;
+    for (char* item = strtok(buffer, ","); item; item = strtok(nullptr, ",")) {
+        char* colon = strchr(item, ':');
+        if (!colon) return 0;
+        *colon = '\0';
+        char* end;
+        float target = strtod(colon + 1, &end);
+        if (end == colon + 1 || *end != '\0' || !(target >= 0.0f && target <= 20.0f)) return 0;
+
+        if (strcmp(item, "*") == 0) {
+            if (count) return 0; // "*" must stand alone
+            for (uint8_t i = 0; i < numTes; ++i) {
+                channels[i] = i;
+                targets[i] = target;
+            }
+            count = numTes;
+            if (strtok(nullptr, ",")) return 0;
+            break;
+        }
+        long channel = strtol(item, &end, 10);
+        if (end == item || *end != '\0' || channel < 1 || channel > numTes) return 0;
+        if (used[channel - 1]) return 0;
+        used[channel - 1] = true;
+        channels[count] = channel - 1;
+        targets[count] = target;
+        count++;
+    }
+    return count;
+}
+
+void cmdTESSetMulti(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channels[TES_MAX_INTERLEAVED];
+    float targets[TES_MAX_INTERLEAVED];
+    uint8_t count = parseTesTargets(args[0].getString(), channels, targets);
+    if (!count) {
+        reportError(sender, "TES_SET_ARG_ERROR", "Expected ch:mA pairs, e.g. 1:5,2:5.5 or *:5 (channels 1-12, 0-20 mA).");
+        return;
+    }
+
+    TESDriver* drivers[TES_MAX_INTERLEAVED];
+    for (uint8_t i = 0; i < count; ++i) {
+        drivers[i] = commandContext.tesDriver[channels[i]];
+        if (reportIfBusy(sender, drivers[i])) {
+            return;
+        }
+    }
+    uint32_t states[TES_MAX_INTERLEAVED];
+    float measured[TES_MAX_INTERLEAVED];
+    TesSetMethod methods[TES_MAX_INTERLEAVED];
+    uint8_t statuses[TES_MAX_INTERLEAVED];
+    unsigned long start = millis();
+    uint8_t status = TESDriver::setCurrents_mA(drivers, targets, count, states, measured, methods, statuses, 10);
+    if (reportIfError(sender, status, "TES_SET_CURRENT_ERROR", "Failed to set TES output currents.")) {
+        return;
+    }
+
+    Stream &out = sender.getSerial();
+    printYAMLHeader(out, "ok");
+    printYAMLString(out, "command", "TES_SET_MULTI");
+    printYAMLSection(out, "channels");
+    for (uint8_t i = 0; i < count; ++i) {
+        LineBuffer line(out);
+        printIndent(line, 4);
+        line.print("- {channel: ");
+        printInt(line, channels[i] + 1);
+        line.print(", ");
+        if (statuses[i]) {
+            printInlineError(line, "TES_SET_CURRENT_ERROR", statuses[i]);
+        } else {
+            line.print("current_mA: ");
+            printFixed(line, measured[i], 4);
+            line.print(", tca_bits: \"0x");
+            printHex(line, states[i], 5);
+            line.print("\", method: ");
+            printQuoted(line, tesSetMethodName(methods[i]));
+        }
+        line.println("}");
+    }
+    printYAMLInt(out, "elapsed_ms", millis() - start);
+    printYAMLMessage(out, "TES output currents set");
+}
+
+void cmdTESSetMultiAsync(SerialCommands& sender, Args& args) {
+    I2C_STATS_COMMAND();
+    uint8_t channels[TES_MAX_INTERLEAVED];
+    float targets[TES_MAX_INTERLEAVED];
+    uint8_t count = parseTesTargets(args[0].getString(), channels, targets);
+    if (!count) {
+        reportError(sender, "TES_SET_ARG_ERROR", "Expected ch:mA pairs, e.g. 1:5,2:5.5 or *:5 (channels 1-12, 0-20 mA).");
+        return;
+    }
+    TESDriver* drivers[TES_MAX_INTERLEAVED];
+    uint8_t numbers[TES_MAX_INTERLEAVED];
+    for (uint8_t i = 0; i < count; ++i) {
+        drivers[i] = commandContext.tesDriver[channels[i]];
+        numbers[i] = channels[i] + 1;
+        if (reportIfBusy(sender, drivers[i])) {
+            return;
+        }
+    }
+    uint16_t id = commandContext.jobs.submit<TesSetJob>(drivers, numbers, targets, count, 10);
+    reportJobSubmitted(sender, "TES_SET_MULTI", id);
+}
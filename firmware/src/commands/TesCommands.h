@@ -0,0 +1,57 @@
+#ifndef TES_COMMANDS_H
+#define TES_COMMANDS_H
+
+#include <StaticSerialCommands.h>
+#include "../devices/TESDriver.h"
+#include "CommandArgs.h"
+
+// TES <CHANNEL> ... subcommands, acting on commandContext.tesDriver
+
+void cmdTESGetAll(SerialCommands& sender, Args& args);
+void cmdTESSet(SerialCommands& sender, Args& args);
+void cmdTESSetAsync(SerialCommands& sender, Args& args);
+void cmdTESSetInt(SerialCommands& sender, Args& args);
+void cmdTESSetHex(SerialCommands& sender, Args& args);
+void cmdTESBits(SerialCommands& sender, Args& args);
+void cmdTESEnable(SerialCommands& sender, Args& args);
+void cmdTESDisable(SerialCommands& sender, Args& args);
+void cmdTESInc(SerialCommands& sender, Args& args);
+void cmdTESDec(SerialCommands& sender, Args& args);
+void cmdTESShunt(SerialCommands& sender, Args& args);
+void cmdTESBus(SerialCommands& sender, Args& args);
+void cmdTESCurrent(SerialCommands& sender, Args& args);
+void cmdTESPower(SerialCommands& sender, Args& args);
+void cmdTESCal(SerialCommands& sender, Args& args);
+void cmdTESCalGet(SerialCommands& sender, Args& args);
+void cmdTESCalClear(SerialCommands& sender, Args& args);
+void cmdTESAdc(SerialCommands& sender, Args& args);
+
+// TESSET and TESSETASYNC <CH:MA,...>, across several channels of commandContext.tesDriver
+void cmdTESSetMulti(SerialCommands& sender, Args& args);
+void cmdTESSetMultiAsync(SerialCommands& sender, Args& args);
+
+// As reported in `method` by TES SET and TESSET
+const char* tesSetMethodName(TesSetMethod method);
+
+// Entries of a sketch's tesCommands[] table
+#define TES_COMMANDS \
+    COMMAND(cmdTESGetAll, "GET", nullptr, "Get All TES Parameters"), \
+    COMMAND(cmdTESEnable, "ENABLE", nullptr, "Enable TES Outputs"), \
+    COMMAND(cmdTESDisable, "DISABLE", nullptr, "Disable TES Outputs"), \
+    COMMAND(cmdTESSet, "SET", tcaCurrentArg, nullptr, "Search and set TES Output Current (mA)"), \
+    COMMAND(cmdTESSetAsync, "SETASYNC", tcaCurrentArg, nullptr, "Start TES Current Search as a Job (mA)"), \
+    COMMAND(cmdTESSetInt, "SETINT", tesTCAArg, nullptr, "Set TES TCA Output Bits (Integer)"), \
+    COMMAND(cmdTESSetHex, "SETHEX", tesTCAHexArg, nullptr, "Set TES TCA Output Bits (Hex)"), \
+    COMMAND(cmdTESBits, "BIT", nullptr, "Get TES TCA Output Bits (Hex)"), \
+    COMMAND(cmdTESInc, "INC", tesTCAArg, nullptr, "Increase TES TCA Output Bits (Integer)"), \
+    COMMAND(cmdTESDec, "DEC", tesTCAArg, nullptr, "Decrease TES TCA Output Bits (Integer)"), \
+    COMMAND(cmdTESShunt, "SHUNT", nullptr, "Get TES Shunt Voltage (mV)"), \
+    COMMAND(cmdTESBus, "BUS", nullptr, "Get TES Bus Voltage (V)"), \
+    COMMAND(cmdTESCurrent, "CURRENT", nullptr, "Get TES Current (mA)"), \
+    COMMAND(cmdTESPower, "POWER", nullptr, "Get TES Power (mW)"), \
+    COMMAND(cmdTESCal, "CAL", nullptr, "Measure TES Bit Weights"), \
+    COMMAND(cmdTESCalGet, "CALGET", nullptr, "Get TES Bit-Weight Calibration"), \
+    COMMAND(cmdTESCalClear, "CALCLEAR", nullptr, "Discard TES Calibration (SET searches)"), \
+    COMMAND(cmdTESAdc, "ADC", inaProfileArg, nullptr, "Set TES INA219 Profile")
+
+#endif // TES_COMMANDS_H
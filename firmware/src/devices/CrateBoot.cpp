@@ -0,0 +1,44 @@
+#include "CrateBoot.h"
+
+CrateBoot::CrateBoot(Router* router, TESDriver* const* tes, uint8_t numTes, LNADriver* const* lna, uint8_t numLna)
+    : _router(router), _tes(tes), _lna(lna),
+      _numTes(numTes < CRATE_BOOT_MAX_CARDS ? numTes : CRATE_BOOT_MAX_CARDS),
+      _numLna(numLna < CRATE_BOOT_MAX_CARDS ? numLna : CRATE_BOOT_MAX_CARDS),
+      _tesPresent(0), _lnaPresent(0), _tesFailed(0), _lnaFailed(0),
+      _next(0), _probeMs(0), _setupMs(0), _readyMs(0) {}
+
+void CrateBoot::probe() {
+    uint32_t start = millis();
+    _tesPresent = 0;
+    _lnaPresent = 0;
+    _tesFailed = 0;
+    _lnaFailed = 0;
+    _next = 0;
+    _readyMs = 0;
+    _router->flush(); // beginHub() disables each hub, so drop any cached route first
+    for (uint8_t i = 0; i < _numTes; ++i) {
+        if (_tes[i]->beginHub() == 0) _tesPresent |= 1ul << i;
+    }
+    for (uint8_t i = 0; i < _numLna; ++i) {
+        if (_lna[i]->beginHub() == 0) _lnaPresent |= 1ul << i;
+    }
+    _probeMs = millis() - start;
+}
+
+bool CrateBoot::service() {
+    // Skip absent cards and those a command has already set up
+    while (!get_done()) {
+        uint8_t i = _next++;
+        if (i < _numTes) {
+            if (!get_tesPresent(i) || _tes[i]->get_ready()) continue;
+            if (_tes[i]->beginParts()) _tesFailed |= 1ul << i;
+        } else {
+            i -= _numTes;
+            if (!get_lnaPresent(i) || _lna[i]->get_ready()) continue;
+            if (_lna[i]->beginParts()) _lnaFailed |= 1ul << i;
+        }
+        return true;
+    }
+    if (!_readyMs) _readyMs = millis();
+    return false;
+}
@@ -0,0 +1,53 @@
+#ifndef CRATE_BOOT_H
+#define CRATE_BOOT_H
+
+#include <Arduino.h>
+#include "TESDriver.h"
+#include "LNADriver.h"
+#include "../routers/Router.h"
+
+#define CRATE_BOOT_MAX_CARDS 32 // Per kind; one bit each in the presence maps
+
+// Brings the crate's cards up without holding the command loop. probe()
+// makes one pass over the slots from setup(): each card's hub gets a
+// single beginHub() write, which quiets every populated card (bus off,
+// outputs disabled) and records which slots answer. service(), called from
+// loop(), then sets up the parts behind one present card per call. A
+// command that reaches a card first sets it up itself on connect(), so the
+// order only decides when the work is done, not whether it is.
+class CrateBoot {
+public:
+    CrateBoot(Router* router, TESDriver* const* tes, uint8_t numTes, LNADriver* const* lna, uint8_t numLna);
+
+    void probe();
+    void setupDone() { _setupMs = millis(); }   // The command loop is live from here
+    bool service();                             // False once every present card has been set up
+
+    bool get_tesPresent(uint8_t i) { return (_tesPresent >> i) & 1u; }
+    bool get_lnaPresent(uint8_t i) { return (_lnaPresent >> i) & 1u; }
+    bool get_tesFailed(uint8_t i) { return (_tesFailed >> i) & 1u; }  // Present, but beginParts() failed
+    bool get_lnaFailed(uint8_t i) { return (_lnaFailed >> i) & 1u; }
+    uint8_t get_numTes() { return _numTes; }
+    uint8_t get_numLna() { return _numLna; }
+    bool get_done() { return _next >= _numTes + _numLna; }
+    uint32_t get_probeMs() { return _probeMs; }   // Time the presence pass took
+    uint32_t get_setupMs() { return _setupMs; }   // millis() when setup() finished
+    uint32_t get_readyMs() { return _readyMs; }   // millis() when service() finished; 0 until then
+
+private:
+    Router* _router;
+    TESDriver* const* _tes;
+    LNADriver* const* _lna;
+    uint8_t _numTes;
+    uint8_t _numLna;
+    uint32_t _tesPresent;
+    uint32_t _lnaPresent;
+    uint32_t _tesFailed;
+    uint32_t _lnaFailed;
+    uint8_t _next;      // Next card for service(): TES channels first, then LNA
+    uint32_t _probeMs;
+    uint32_t _setupMs;
+    uint32_t _readyMs;
+};
+
+#endif // CRATE_BOOT_H
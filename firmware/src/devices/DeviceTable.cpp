@@ -0,0 +1,106 @@
+#include "DeviceTable.h"
+
+#if DEVICE_MAP_EEPROM
+#define DEVICE_MAP_MAGIC 0xAD01u
+
+// What the stored map holds. The counts are those of the sketch that wrote
+// it; a sketch with other counts (say, after reflashing the board with the
+// other controller) ignores the map and keeps its defaults.
+struct DeviceMapRecord {
+    uint16_t magic;
+    uint8_t numTes;
+    uint8_t numLna;
+    TesCardAddress tes[DEVICE_MAP_MAX_TES];
+    LnaCardAddress lna[DEVICE_MAP_MAX_LNA];
+    uint8_t checksum;
+};
+static_assert(sizeof(DeviceMapRecord) <= DEVICE_MAP_EEPROM_SIZE, "DEVICE_MAP_EEPROM_SIZE too small");
+
+static uint8_t mapChecksum(const DeviceMapRecord& record) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < offsetof(DeviceMapRecord, checksum); ++i) sum += bytes[i];
+    return (uint8_t)~sum;
+}
+
+static bool readRecord(DeviceMapRecord& record) {
+    EEPROM.get(DEVICE_MAP_EEPROM_BASE, record);
+    return record.magic == DEVICE_MAP_MAGIC && record.checksum == mapChecksum(record)
+        && record.numTes <= DEVICE_MAP_MAX_TES && record.numLna <= DEVICE_MAP_MAX_LNA;
+}
+
+static void writeRecord(DeviceMapRecord& record) {
+    record.magic = DEVICE_MAP_MAGIC;
+    record.checksum = mapChecksum(record);
+    EEPROM.put(DEVICE_MAP_EEPROM_BASE, record);
+}
+#endif
+
+DeviceMap::DeviceMap(TesCardAddress* tes, uint8_t numTes, LnaCardAddress* lna, uint8_t numLna)
+    : _tes(tes), _lna(lna), _numTes(numTes), _numLna(numLna), _stored(false), _pending(false) {}
+
+bool DeviceMap::begin() {
+#if DEVICE_MAP_EEPROM
+    DeviceMapRecord record;
+    _stored = readRecord(record) && record.numTes == _numTes && record.numLna == _numLna;
+    if (!_stored) return false;
+    for (uint8_t i = 0; i < _numTes; ++i) _tes[i] = record.tes[i];
+    for (uint8_t i = 0; i < _numLna; ++i) _lna[i] = record.lna[i];
+#endif
+    return _stored;
+}
+
+#if DEVICE_MAP_EEPROM
+// Start from the stored map, or from the running tables if there is none,
+// so that storing one card keeps every other card as it is now
+static void loadOrSeed(DeviceMapRecord& record, const TesCardAddress* tes, uint8_t numTes,
+                       const LnaCardAddress* lna, uint8_t numLna) {
+    if (readRecord(record) && record.numTes == numTes && record.numLna == numLna) return;
+    memset(&record, 0, sizeof(record));
+    record.numTes = numTes;
+    record.numLna = numLna;
+    for (uint8_t i = 0; i < numTes; ++i) record.tes[i] = tes[i];
+    for (uint8_t i = 0; i < numLna; ++i) record.lna[i] = lna[i];
+}
+#endif
+
+uint8_t DeviceMap::storeTes(uint8_t index, const TesCardAddress& address) {
+#if DEVICE_MAP_EEPROM
+    if (index >= _numTes) return 10;
+    if (_numTes > DEVICE_MAP_MAX_TES || _numLna > DEVICE_MAP_MAX_LNA) return DEVICE_MAP_ERR_NO_STORAGE;
+    DeviceMapRecord record;
+    loadOrSeed(record, _tes, _numTes, _lna, _numLna);
+    record.tes[index] = address;
+    writeRecord(record);
+    _pending = true;
+    return 0;
+#else
+    return DEVICE_MAP_ERR_NO_STORAGE;
+#endif
+}
+
+uint8_t DeviceMap::storeLna(uint8_t index, const LnaCardAddress& address) {
+#if DEVICE_MAP_EEPROM
+    if (index >= _numLna) return 10;
+    if (_numTes > DEVICE_MAP_MAX_TES || _numLna > DEVICE_MAP_MAX_LNA) return DEVICE_MAP_ERR_NO_STORAGE;
+    DeviceMapRecord record;
+    loadOrSeed(record, _tes, _numTes, _lna, _numLna);
+    record.lna[index] = address;
+    writeRecord(record);
+    _pending = true;
+    return 0;
+#else
+    return DEVICE_MAP_ERR_NO_STORAGE;
+#endif
+}
+
+uint8_t DeviceMap::erase() {
+#if DEVICE_MAP_EEPROM
+    // Clearing the magic is enough for begin() to ignore the record
+    EEPROM.put(DEVICE_MAP_EEPROM_BASE, (uint16_t)0xFFFF);
+    _pending = true;
+    return 0;
+#else
+    return DEVICE_MAP_ERR_NO_STORAGE;
+#endif
+}
@@ -0,0 +1,113 @@
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <Arduino.h>
+#include <new>
+#include "TESDriver.h"
+#include "LNADriver.h"
+
+// Where a card's parts answer. Every card is an LTC4302 directly behind the
+// base hub, so its route is base hub -> card hub, and its parts sit on the
+// card's downstream bus.
+struct TesCardAddress {
+    uint8_t hub;        // The card's LTC4302
+    uint8_t ina;        // INA219
+    uint8_t tca;        // TCA6424 bias bits
+};
+
+struct LnaCardAddress {
+    uint8_t hub;
+    uint8_t dac;        // MCP4728: channel A drain, channel B gate
+    uint8_t inaDrain;
+    uint8_t inaGate;
+};
+
+// A card's hub and its driver side by side, so a loop over every channel
+// walks one contiguous array
+struct TesCard {
+    LTC4302 hub;
+    TESDriver driver;
+
+    TesCard(const TesCardAddress& address, Router* router)
+        : hub(address.hub), driver(&hub, router, address.ina, address.tca) {}
+};
+
+struct LnaCard {
+    LTC4302 hub;
+    LNADriver driver;
+
+    LnaCard(const LnaCardAddress& address, Router* router)
+        : hub(address.hub), driver(&hub, router, address.dac, address.inaDrain, address.inaGate) {}
+};
+
+// Statically allocated room for N objects that are constructed at boot,
+// once their constructor arguments (here: the card addresses) are known.
+// The space is a global array, so it appears in the link-time RAM figure
+// instead of coming from the heap.
+template <typename T, uint8_t N>
+class StaticPool {
+public:
+    template <typename... A>
+    T* construct(uint8_t i, const A&... args) { return new (_storage[i]) T(args...); }
+    T* get(uint8_t i) { return reinterpret_cast<T*>(_storage[i]); }
+
+private:
+    alignas(T) uint8_t _storage[N][sizeof(T)];
+};
+
+// The card addresses a sketch boots with, and their persisted override.
+// The sketch owns the tables, initialised with its defaults; begin() applies
+// a stored map over them. storeTes()/storeLna() write one card's entry to
+// the stored map and take effect at the next reset, so a crate with a
+// different card population needs no recompile.
+//
+// A stored map only applies to a sketch with the same NUM_TES and NUM_LNA.
+// Set DEVICE_MAP_EEPROM to 0 on cores without EEPROM.h; the defaults are
+// then always used and the store calls return DEVICE_MAP_ERR_NO_STORAGE.
+#ifndef DEVICE_MAP_EEPROM
+#define DEVICE_MAP_EEPROM 1
+#endif
+#define DEVICE_MAP_MAX_TES 16
+#define DEVICE_MAP_MAX_LNA 8
+#define DEVICE_MAP_EEPROM_SIZE 96       // Bytes reserved at DEVICE_MAP_EEPROM_BASE
+#define DEVICE_MAP_ERR_NO_STORAGE 50    // Built without DEVICE_MAP_EEPROM, or more cards than the record holds
+
+// The map sits at the top of EEPROM. The TES sketch checks at compile time
+// that its calibration slots, counted up from TES_CAL_EEPROM_BASE, end below it.
+#if DEVICE_MAP_EEPROM
+#include <EEPROM.h>
+#ifndef DEVICE_MAP_EEPROM_BASE
+#ifdef E2END
+#define DEVICE_MAP_EEPROM_BASE (E2END + 1 - DEVICE_MAP_EEPROM_SIZE)
+#else
+#define DEVICE_MAP_EEPROM_BASE 0
+#endif
+#endif
+#endif
+
+class DeviceMap {
+public:
+    DeviceMap(TesCardAddress* tes, uint8_t numTes, LnaCardAddress* lna, uint8_t numLna);
+
+    bool begin();   // True if a stored map was applied
+    uint8_t storeTes(uint8_t index, const TesCardAddress& address);
+    uint8_t storeLna(uint8_t index, const LnaCardAddress& address);
+    uint8_t erase(); // The defaults apply again from the next reset
+
+    bool get_stored() { return _stored; }      // The addresses in use came from the stored map
+    bool get_pending() { return _pending; }    // The stored map changed since boot
+    uint8_t get_numTes() { return _numTes; }
+    uint8_t get_numLna() { return _numLna; }
+    const TesCardAddress& get_tes(uint8_t i) { return _tes[i]; }
+    const LnaCardAddress& get_lna(uint8_t i) { return _lna[i]; }
+
+private:
+    TesCardAddress* _tes;
+    LnaCardAddress* _lna;
+    uint8_t _numTes;
+    uint8_t _numLna;
+    bool _stored;
+    bool _pending;
+};
+
+#endif // DEVICE_TABLE_H
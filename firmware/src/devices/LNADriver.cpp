@@ -5,23 +5,38 @@
 // for routing. The MCP4728 still has its own internal channels (A, B, C, D) for
 // DAC selection.
 
-LNADriver::LNADriver(LTC4302* lnaLtc4302, Router* router)
+LNADriver::LNADriver(LTC4302* lnaLtc4302, Router* router, uint8_t dacAddress,
+                     uint8_t inaDrainAddress, uint8_t inaGateAddress)
     : _lnaLtc4302(lnaLtc4302),
       _router(router),
       _routeToLnaLtc4302({_lnaLtc4302, nullptr}),
-      _lnaDac(LNA_MCP4728_ADDR),
-      _lnaInaDrain(LNA_INA_DRAIN_ADDR),
-      _lnaInaGate(LNA_INA_GATE_ADDR) {
+      _lnaDac(dacAddress),
+      _lnaInaDrain(inaDrainAddress),
+      _lnaInaGate(inaGateAddress),
+      _ready(false),
+      _present(true) {
 }
 
 uint8_t LNADriver::begin() {
-    RETURN_IF_ERROR(_lnaLtc4302->begin());
-    RETURN_IF_ERROR(connect());
-    RETURN_IF_ERROR(_lnaDac.begin());
-    RETURN_IF_ERROR(_lnaInaDrain.begin(LNA_INA_SHUNT_RESISTANCE_OHMS,
-                       LNA_INA_MAX_EXPECTED_CURRENT_AMPS));
-    RETURN_IF_ERROR(_lnaInaGate.begin(LNA_INA_SHUNT_RESISTANCE_OHMS,
-                      LNA_INA_MAX_EXPECTED_CURRENT_AMPS));
+    RETURN_IF_ERROR(_router->flush()); // beginHub() disables the hub, so drop any cached route first
+    RETURN_IF_ERROR(beginHub());
+    return beginParts();
+}
+
+uint8_t LNADriver::beginHub() {
+    _ready = false;
+    uint8_t status = _lnaLtc4302->begin();
+    _present = (status == 0);
+    return status;
+}
+
+void LNADriver::setPresent(bool present) {
+    _present = present;
+    if (!present) _ready = false; // A card fitted later starts from beginHub()
+}
+
+uint8_t LNADriver::beginParts() {
+    RETURN_IF_ERROR(connect()); // Sets up the DAC and INA219s while _ready is false
     return disconnect();
 }
 
@@ -49,116 +64,301 @@ uint8_t LNADriver::readGate(uint16_t& value) {
     return disconnect();
 }
 
-uint8_t LNADriver::setDrainCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs) {
+uint8_t LNADriver::setDrainCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs,
+                                   LnaSearchMode mode, LnaSearchStats* stats) {
     if (!(target_mA >= 0.0f && target_mA <= 64.0f)) {
         return 10; // invalid argument
     }
-    RETURN_IF_ERROR(connect());
-    float readCurrent = 0;
-    dacValue = 0;
-    while(readCurrent < target_mA && dacValue < 4095) {
-        dacValue++;
-        RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_DRAIN_CHANNEL, dacValue));
-        delay(delayMs); // Allow time for settling
-        RETURN_IF_ERROR(_lnaInaDrain.getCurrent_mA(readCurrent));
-    }
-    dacValue = (dacValue > 0 && dacValue < 4095) ? dacValue - 1 : 0;
-    RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_DRAIN_CHANNEL, dacValue));
-    RETURN_IF_ERROR(_lnaInaDrain.getCurrent_mA(target_mA));
-    return disconnect();
+    return searchDac(LNA_DRAIN, false, target_mA, dacValue, delayMs, mode, stats);
 }
 
-uint8_t LNADriver::setGateCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs) {
+uint8_t LNADriver::setGateCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs,
+                                  LnaSearchMode mode, LnaSearchStats* stats) {
     if (!(target_mA >= 0.0f && target_mA <= 64.0f)) {
         return 10; // invalid argument
     }
-    target_mA = -target_mA; // Gate current is negative
-    RETURN_IF_ERROR(connect());
-    float readCurrent = 0;
-    dacValue = 0;
-    while(readCurrent > target_mA && dacValue < 4095) {
-        dacValue++;
-        RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_GATE_CHANNEL, dacValue));
-        delay(delayMs); // Allow time for settling
-        RETURN_IF_ERROR(_lnaInaGate.getCurrent_mA(readCurrent));
+    // Gate current is negative; the search works on its magnitude
+    return searchDac(LNA_GATE, false, target_mA, dacValue, delayMs, mode, stats);
+}
+
+uint8_t LNADriver::setDrainVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs,
+                                   LnaSearchMode mode, LnaSearchStats* stats) {
+    if (!(target_V >= 0.0f && target_V <= 5.0f)) {
+        return 10; // invalid argument
     }
-    dacValue = (dacValue > 0 && dacValue < 4095) ? dacValue - 1 : 0;
-    RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_GATE_CHANNEL, dacValue));
-    RETURN_IF_ERROR(_lnaInaGate.getCurrent_mA(target_mA));
-    return disconnect();
+    return searchDac(LNA_DRAIN, true, target_V, dacValue, delayMs, mode, stats);
 }
 
-uint8_t LNADriver::setDrainVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs) {
+uint8_t LNADriver::setGateVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs,
+                                  LnaSearchMode mode, LnaSearchStats* stats) {
     if (!(target_V >= 0.0f && target_V <= 5.0f)) {
         return 10; // invalid argument
     }
+    return searchDac(LNA_GATE, true, target_V, dacValue, delayMs, mode, stats);
+}
+
+uint8_t LNADriver::searchDac(LnaSide side, bool voltage, float& target, uint16_t& dacValue,
+                             uint8_t delayMs, LnaSearchMode mode, LnaSearchStats* stats) {
+    unsigned long start = millis();
+    LnaDacSearch search;
+    search.begin(target, voltage, mode);
+
     RETURN_IF_ERROR(connect());
-    float readVoltage = 0;
-    dacValue = 0;
-    while(readVoltage < target_V && dacValue < 4095) {
-        dacValue++;
-        RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_DRAIN_CHANNEL, dacValue));
-        delay(delayMs); // Allow time for settling
-        RETURN_IF_ERROR(_lnaInaDrain.getBusVoltage_V(readVoltage));
+    uint16_t code;
+    while (search.next(code)) {
+        float progress;
+        RETURN_IF_ERROR(probe(side, voltage, code, delayMs, progress));
+        search.feed(progress);
+    }
+
+    // Settle one code below the first one that reached the target. A target
+    // that is never reached parks the DAC at zero.
+    dacValue = search.get_result();
+    float progress;
+    RETURN_IF_ERROR(probe(side, voltage, dacValue, delayMs, progress));
+    target = (side == LNA_GATE) ? -progress : progress; // Gate current and voltage are negative
+
+    if (stats) {
+        stats->iterations = search.get_iterations() + 1;
+        stats->elapsed_ms = millis() - start;
+        stats->fellBack = search.get_fellBack();
     }
-    dacValue = (dacValue > 0 && dacValue < 4095) ? dacValue - 1 : 0;
-    RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_DRAIN_CHANNEL, dacValue));
-    RETURN_IF_ERROR(_lnaInaDrain.getBusVoltage_V(target_V));
     return disconnect();
 }
 
-uint8_t LNADriver::setGateVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs) {
-    if (!(target_V >= 0.0f && target_V <= 5.0f)) {
-        return 10; // invalid argument
+uint8_t LNADriver::probe(LnaSide side, bool voltage, uint16_t code, uint8_t delayMs, float& progress) {
+    RETURN_IF_ERROR(_lnaDac.writeDAC(side == LNA_DRAIN ? LNA_DRAIN_CHANNEL : LNA_GATE_CHANNEL, code));
+    if (get_inaProfile(side) != INA219_PROFILE_FAST) delay(delayMs); // Allow time for settling
+    return readProgress(side, voltage, progress);
+}
+
+uint8_t LNADriver::readProgress(LnaSide side, bool voltage, float& progress) {
+    bool drain = (side == LNA_DRAIN);
+    INA219& ina = drain ? _lnaInaDrain : _lnaInaGate;
+    RETURN_IF_ERROR(ina.refresh()); // FAST: a conversion that starts after the DAC write
+    if (voltage) {
+        RETURN_IF_ERROR(ina.getBusVoltage_V(progress));
+    } else {
+        RETURN_IF_ERROR(ina.getCurrent_mA(progress));
+        if (!drain) progress = -progress;
     }
+    return 0;
+}
+
+uint8_t LNADriver::writeSearchCode(LnaSide side, uint16_t code) {
     RETURN_IF_ERROR(connect());
-    float readVoltage = 0;
-    dacValue = 0;
-    while(readVoltage < target_V && dacValue < 4095) {
-        dacValue++;
-        RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_GATE_CHANNEL, dacValue));
-        delay(delayMs); // Allow time for settling
-        RETURN_IF_ERROR(_lnaInaGate.getBusVoltage_V(readVoltage));
-    }
-    dacValue = (dacValue > 0 && dacValue < 4095) ? dacValue - 1 : 0;
-    RETURN_IF_ERROR(_lnaDac.writeDAC(LNA_GATE_CHANNEL, dacValue));
-    RETURN_IF_ERROR(_lnaInaGate.getBusVoltage_V(target_V));
-    target_V = -target_V; // Gate voltage is negative
+    RETURN_IF_ERROR(_lnaDac.writeDAC(side == LNA_DRAIN ? LNA_DRAIN_CHANNEL : LNA_GATE_CHANNEL, code));
+    return disconnect();
+}
+
+uint8_t LNADriver::readSearchProgress(LnaSide side, bool voltage, float& progress) {
+    RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(readProgress(side, voltage, progress));
     return disconnect();
 }
 
+// --- LnaDacSearch ------------------------------------------------------------
+// The bracketing search walks up from code 1, never more than doubling the
+// code, taking a damped secant step towards the target once two readings
+// exist, so the output only overshoots by the last step. It then bisects the
+// bracket and re-checks a few codes either side of the boundary. A reading
+// that goes backwards by more than the tolerance restarts as a linear sweep.
+
+void LnaDacSearch::begin(float target, bool voltage, LnaSearchMode mode) {
+    _target = target;
+    _tol = voltage ? LNA_SEARCH_TOL_V : LNA_SEARCH_TOL_MA;
+    _code = 0;
+    _progress = 0.0f;
+    _havePrev = false;
+    _firstReached = 0;
+    _iterations = 0;
+    _fellBack = false;
+    if (mode == LNA_SEARCH_LINEAR) {
+        _phase = LINEAR;
+    } else if (!(target > 0.0f)) {
+        finish(0); // Already there at code 0, as with the linear sweep
+    } else {
+        _phase = WALK_START;
+    }
+}
+
+void LnaDacSearch::fallBack() {
+    _fellBack = true;
+    _phase = LINEAR;
+    _code = 0;
+    _progress = 0.0f;
+}
+
+uint16_t LnaDacSearch::get_result() {
+    return (_firstReached > 0 && _firstReached < LNA_DAC_MAX) ? _firstReached - 1 : 0;
+}
+
+bool LnaDacSearch::next(uint16_t& code) {
+    switch (_phase) {
+    case LINEAR:
+        if (_progress < _target && _code < LNA_DAC_MAX) {
+            code = ++_code;
+            return true;
+        }
+        finish(_code);
+        return false;
+
+    case WALK_START:
+        code = _code = 1;
+        return true;
+
+    case WALK: {
+        if (_lo >= LNA_DAC_MAX) {
+            finish(LNA_DAC_MAX); // Never reached
+            return false;
+        }
+        uint32_t next = (uint32_t)_lo * 2;
+        if (_havePrev && _loVal > _prevVal) {
+            float slope = (_loVal - _prevVal) / (float)(_lo - _prev);
+            float step = LNA_SEARCH_DAMPING * (_target - _loVal) / slope;
+            uint32_t secant = _lo + (step < 1.0f ? 1 : (uint32_t)step);
+            if (secant < next) next = secant;
+        }
+        if (next > LNA_DAC_MAX) next = LNA_DAC_MAX;
+        code = _code = (uint16_t)next;
+        return true;
+    }
+
+    case BISECT:
+        if (_hi - _lo > 1) {
+            code = _code = _lo + (_hi - _lo) / 2;
+            return true;
+        }
+        _phase = REFINE_DOWN;
+        _refine = 0;
+        // fall through
+    case REFINE_DOWN:
+        if (_refine < LNA_SEARCH_REFINE_STEPS && _hi > 1) {
+            code = _code = _hi - 1;
+            return true;
+        }
+        _phase = REFINE_UP;
+        _refine = 0;
+        // fall through
+    case REFINE_UP:
+        if (_refine < LNA_SEARCH_REFINE_STEPS && _hi < LNA_DAC_MAX) {
+            code = _code = _hi;
+            return true;
+        }
+        finish(_hi);
+        return false;
+
+    case DONE:
+    default:
+        return false;
+    }
+}
+
+void LnaDacSearch::feed(float value) {
+    _iterations++;
+    switch (_phase) {
+    case LINEAR:
+        _progress = value;
+        break;
+
+    case WALK_START:
+        _lo = _code;
+        _loVal = value;
+        if (value >= _target) finish(_lo);
+        else _phase = WALK;
+        break;
+
+    case WALK:
+        if (value < _loVal - _tol) {
+            fallBack();
+        } else if (value >= _target) {
+            _hi = _code;
+            _hiVal = value;
+            _phase = BISECT;
+        } else {
+            _prev = _lo;
+            _prevVal = _loVal;
+            _havePrev = true;
+            _lo = _code;
+            _loVal = value;
+        }
+        break;
+
+    case BISECT:
+        if (value < _loVal - _tol || value > _hiVal + _tol) {
+            fallBack();
+        } else if (value >= _target) {
+            _hi = _code;
+            _hiVal = value;
+        } else {
+            _lo = _code;
+            _loVal = value;
+        }
+        break;
+
+    case REFINE_DOWN:
+        if (value < _target) {
+            _phase = REFINE_UP;
+            _refine = 0;
+        } else {
+            _hi--;
+            _refine++;
+        }
+        break;
+
+    case REFINE_UP:
+        if (value >= _target) {
+            finish(_hi);
+        } else {
+            _hi++;
+            _refine++;
+        }
+        break;
+
+    case DONE:
+    default:
+        break;
+    }
+}
+
 uint8_t LNADriver::getDrainShuntVoltage_mV(float& shuntVoltage) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaDrain.refresh());
     RETURN_IF_ERROR(_lnaInaDrain.getShuntVoltage_mV(shuntVoltage));
     return disconnect();
 }
 
 uint8_t LNADriver::getDrainBusVoltage_V(float& busVoltage) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaDrain.refresh());
     RETURN_IF_ERROR(_lnaInaDrain.getBusVoltage_V(busVoltage));
     return disconnect();
 }
 
 uint8_t LNADriver::getDrainCurrent_mA(float& current) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaDrain.refresh());
     RETURN_IF_ERROR(_lnaInaDrain.getCurrent_mA(current));
     return disconnect();
 }
 
 uint8_t LNADriver::getDrainPower_mW(float& power) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaDrain.refresh());
     RETURN_IF_ERROR(_lnaInaDrain.getPower_mW(power));
     return disconnect();
 }
 
 uint8_t LNADriver::getGateShuntVoltage_mV(float& shuntVoltage) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaGate.refresh());
     RETURN_IF_ERROR(_lnaInaGate.getShuntVoltage_mV(shuntVoltage));
     return disconnect();
 }
 
 uint8_t LNADriver::getGateBusVoltage_V(float& busVoltage) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaGate.refresh());
     RETURN_IF_ERROR(_lnaInaGate.getBusVoltage_V(busVoltage));
     busVoltage = -busVoltage; // Drain voltage is negative
     return disconnect();
@@ -166,16 +366,45 @@ uint8_t LNADriver::getGateBusVoltage_V(float& busVoltage) {
 
 uint8_t LNADriver::getGateCurrent_mA(float& current) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaGate.refresh());
     RETURN_IF_ERROR(_lnaInaGate.getCurrent_mA(current));
     return disconnect();
 }
 
 uint8_t LNADriver::getGatePower_mW(float& power) {
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_lnaInaGate.refresh());
     RETURN_IF_ERROR(_lnaInaGate.getPower_mW(power));
     return disconnect();
 }
 
+uint8_t LNADriver::readAll(LnaSide side, LnaReading& reading) {
+    bool drain = (side == LNA_DRAIN);
+    INA219& ina = drain ? _lnaInaDrain : _lnaInaGate;
+    RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(ina.refresh());
+    reading.timestamp_us = micros();
+    RETURN_IF_ERROR(_lnaDac.readDAC(drain ? LNA_DRAIN_CHANNEL : LNA_GATE_CHANNEL, reading.dacValue));
+    INA219Sample sample;
+    RETURN_IF_ERROR(ina.readSample(sample));
+    reading.shunt_mV = ina.toShunt_mV(sample.shunt);
+    reading.bus_V = ina.toBus_V(sample.bus);
+    reading.current_mA = ina.toCurrent_mA(sample.current);
+    reading.power_mW = ina.toPower_mW(sample.power);
+    if (!drain) reading.bus_V = -reading.bus_V; // Gate voltage is negative
+    bool gpio;
+    RETURN_IF_ERROR(_lnaLtc4302->getGPIO(drain ? 2 : 1, gpio));
+    reading.enabled = !gpio;  // Invert logic for return value
+    reading.duration_us = micros() - reading.timestamp_us;
+    return disconnect();
+}
+
+uint8_t LNADriver::setInaProfile(LnaSide side, INA219Profile profile) {
+    RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR((side == LNA_DRAIN ? _lnaInaDrain : _lnaInaGate).setProfile(profile));
+    return disconnect();
+}
+
 uint8_t LNADriver::setGateEnable(
     bool state) {    // False is enable, true is disable
     state = !state;  // Invert state for LTC4302 GPIO logic
@@ -205,7 +434,20 @@ uint8_t LNADriver::getDrainEnable(bool& state) {
     return disconnect();
 }
 
-uint8_t LNADriver::connect() { return _router->routeTo(&_routeToLnaLtc4302); }
+uint8_t LNADriver::connect() {
+    if (!_present) return ROUTER_ERR_ABSENT; // Skip the NACKs until a rescan finds the card
+    RETURN_IF_ERROR(_router->routeTo(&_routeToLnaLtc4302));
+    if (!_ready) {
+        // First use since beginHub() (or since boot, for a card found later)
+        RETURN_IF_ERROR(_lnaDac.begin());
+        RETURN_IF_ERROR(_lnaInaDrain.begin(LNA_INA_SHUNT_RESISTANCE_OHMS,
+                           LNA_INA_MAX_EXPECTED_CURRENT_AMPS));
+        RETURN_IF_ERROR(_lnaInaGate.begin(LNA_INA_SHUNT_RESISTANCE_OHMS,
+                          LNA_INA_MAX_EXPECTED_CURRENT_AMPS));
+        _ready = true;
+    }
+    return 0;
+}
 
 uint8_t LNADriver::disconnect() {
     return _router->endRoute(&_routeToLnaLtc4302);
@@ -18,22 +18,119 @@
 // MCP4728 channels for LNA functions
 #define LNA_DRAIN_CHANNEL MCP4728_CHANNEL_A
 #define LNA_GATE_CHANNEL  MCP4728_CHANNEL_B
+
+enum LnaSide {
+    LNA_DRAIN,
+    LNA_GATE
+};
+
+// DAC search strategies for the set*Current/set*Voltage calls. Both end on
+// the highest DAC code whose reading stays below the target.
+enum LnaSearchMode {
+    LNA_SEARCH_LINEAR,   // Step the code up by one from zero (original behaviour)
+    LNA_SEARCH_BRACKET   // Damped secant steps up from zero, then bisect the bracket
+};
+
+struct LnaSearchStats {
+    uint16_t iterations;   // DAC writes followed by an INA219 read
+    uint32_t elapsed_ms;
+    bool fellBack;         // Bracketing saw a non-monotonic response and swept linearly
+};
+
+#define LNA_DAC_MAX 4095
+#define LNA_SEARCH_TOL_MA 0.05f     // Reading noise tolerated by the monotonicity guard
+#define LNA_SEARCH_TOL_V 0.02f
+#define LNA_SEARCH_DAMPING 0.8f     // Fraction of the secant step taken, to approach from below
+#define LNA_SEARCH_REFINE_STEPS 8   // Max single-code steps when re-checking the boundary
+
+// The DAC search as a resumable state machine, with no I/O of its own: next()
+// proposes a code, the caller writes it, lets it settle and passes the
+// reading back through feed(). "Progress" is the reading oriented to rise
+// with the DAC code (gate current is negated). LNADriver runs it in a
+// blocking loop; LnaSetJob runs it one probe per step.
+class LnaDacSearch {
+public:
+    void begin(float target, bool voltage, LnaSearchMode mode);
+    bool next(uint16_t& code);  // Code to probe next; false once the result is known
+    void feed(float progress);  // Reading at the code last returned by next()
+    uint16_t get_result();      // One code below the first that reached the target, or 0
+    uint16_t get_iterations() { return _iterations; }
+    bool get_fellBack() { return _fellBack; }
+
+private:
+    enum Phase { LINEAR, WALK_START, WALK, BISECT, REFINE_DOWN, REFINE_UP, DONE };
+    Phase _phase;
+    float _target;
+    float _tol;
+    uint16_t _code;          // Last code handed out
+    float _progress;         // Linear sweep: last reading
+    uint16_t _lo, _hi, _prev;
+    float _loVal, _hiVal, _prevVal;
+    bool _havePrev;
+    uint8_t _refine;
+    uint16_t _firstReached;
+    uint16_t _iterations;
+    bool _fellBack;
+
+    void finish(uint16_t firstReached) { _firstReached = firstReached; _phase = DONE; }
+    void fallBack();
+};
+
+// One coherent set of readings for one side of an LNA, taken inside a single
+// route session. Gate bus voltage carries the same sign flip as
+// getGateBusVoltage_V().
+struct LnaReading {
+    float shunt_mV;
+    float bus_V;
+    float current_mA;
+    float power_mW;
+    uint16_t dacValue;
+    bool enabled;
+    uint32_t timestamp_us;  // micros() when the first register was read
+    uint32_t duration_us;   // Time from the first to the last register read
+};
+
 class LNADriver {
 public:
-    LNADriver(LTC4302* lnaLtc4302, Router* router); // Removed baseHubChannel
-    uint8_t begin();
+    LNADriver(LTC4302* lnaLtc4302, Router* router, uint8_t dacAddress = LNA_MCP4728_ADDR,
+              uint8_t inaDrainAddress = LNA_INA_DRAIN_ADDR, uint8_t inaGateAddress = LNA_INA_GATE_ADDR);
+    uint8_t begin();      // beginHub() and then beginParts()
     I2CRoute getRouteToLnaLtc4302() { return _routeToLnaLtc4302; } // Accessor for the route
 
+    // Boot in two steps, as for TESDriver. beginHub() is one write that
+    // disconnects the card's bus and disables its supplies; it fails on an
+    // empty slot. The DAC and INA219s are set up on the first connect()
+    // after it, or by beginParts().
+    uint8_t beginHub();
+    uint8_t beginParts();
+    bool get_ready() { return _ready; } // Parts set up since the last beginHub()
+
+    // Cleared when beginHub() or a topology scan gets no answer from the hub;
+    // connect() then fails with ROUTER_ERR_ABSENT without touching the bus
+    void setPresent(bool present);
+    bool get_present() { return _present; }
+
     // // Methods to interact with the LNA's MCP4728
     uint8_t writeDrain(uint16_t value);
     uint8_t writeGate(uint16_t value);
     uint8_t readDrain(uint16_t& value);
     uint8_t readGate(uint16_t& value);
 
-    uint8_t setDrainCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs = 10);
-    uint8_t setGateCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs = 10);
-    uint8_t setDrainVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs = 10);
-    uint8_t setGateVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs = 10);
+    // Search the DAC code for a target; the target is overwritten with the
+    // value measured at the final code.
+    uint8_t setDrainCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs = 10,
+                            LnaSearchMode mode = LNA_SEARCH_BRACKET, LnaSearchStats* stats = nullptr);
+    uint8_t setGateCurrent(float& target_mA, uint16_t& dacValue, uint8_t delayMs = 10,
+                           LnaSearchMode mode = LNA_SEARCH_BRACKET, LnaSearchStats* stats = nullptr);
+    uint8_t setDrainVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs = 10,
+                            LnaSearchMode mode = LNA_SEARCH_BRACKET, LnaSearchStats* stats = nullptr);
+    uint8_t setGateVoltage(float& target_V, uint16_t& dacValue, uint8_t delayMs = 10,
+                           LnaSearchMode mode = LNA_SEARCH_BRACKET, LnaSearchStats* stats = nullptr);
+
+    // One search probe split in two, each in its own route session, so a
+    // caller can do other work while the output settles
+    uint8_t writeSearchCode(LnaSide side, uint16_t code);
+    uint8_t readSearchProgress(LnaSide side, bool voltage, float& progress);
 
     // Methods to interact with the LNA's INA219s
     uint8_t getDrainShuntVoltage_mV(float& shuntVoltage);
@@ -46,6 +143,17 @@ public:
     uint8_t getGateCurrent_mA(float& current);
     uint8_t getGatePower_mW(float& power);
 
+    // DAC code, INA219 readings and enable state of one side in one route session
+    uint8_t readAll(LnaSide side, LnaReading& reading);
+
+    // INA219 ADC profile of one side. With INA219_PROFILE_FAST every read
+    // triggers its own conversion and the searches wait for CNVR instead of
+    // delayMs.
+    uint8_t setInaProfile(LnaSide side, INA219Profile profile);
+    INA219Profile get_inaProfile(LnaSide side) {
+        return (side == LNA_DRAIN ? _lnaInaDrain : _lnaInaGate).get_profile();
+    }
+
     // Methods to control GPIOs on the LNA LTC4302
     uint8_t setDrainEnable(bool state);
     uint8_t setGateEnable(bool state);
@@ -63,9 +171,17 @@ private:
     MCP4728 _lnaDac;
     INA219 _lnaInaDrain;
     INA219 _lnaInaGate;
+    bool _ready;
+    bool _present;
 
     uint8_t connect();
     uint8_t disconnect();
+
+    // DAC search helpers
+    uint8_t searchDac(LnaSide side, bool voltage, float& target, uint16_t& dacValue,
+                      uint8_t delayMs, LnaSearchMode mode, LnaSearchStats* stats);
+    uint8_t probe(LnaSide side, bool voltage, uint16_t code, uint8_t delayMs, float& progress);
+    uint8_t readProgress(LnaSide side, bool voltage, float& progress); // Route must be open
 };
 
 #endif // LNA_DRIVER_H
@@ -1,31 +1,70 @@
 #include "TESDriver.h"
 
+#if TES_CAL_EEPROM
+#include <EEPROM.h>
+
+#define TES_CAL_MAGIC 0x7E5Cu
+
+// What one EEPROM slot holds
+struct TesCalRecord {
+    uint16_t magic;
+    TesCalibration cal;
+    uint8_t checksum;
+};
+static_assert(sizeof(TesCalRecord) <= TES_CAL_EEPROM_SLOT_SIZE, "TES_CAL_EEPROM_SLOT_SIZE too small");
+
+static uint8_t calChecksum(const TesCalibration& cal) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&cal);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < sizeof(cal); ++i) sum += bytes[i];
+    return (uint8_t)~sum;
+}
+#endif
+
 // Each TESDriver manages a single TES device, which is behind its own LTC4302.
 // Therefore, the concept of "channels on the TES LTC4302 for its devices" is simplified.
 // The TES device itself is directly accessed through the LTC.
 
 
-TESDriver::TESDriver(LTC4302* tesLtc4302, Router* router)
+TESDriver::TESDriver(LTC4302* tesLtc4302, Router* router, uint8_t inaAddress, uint8_t tcaAddress)
     : _tesLtc4302(tesLtc4302),
       _router(router),
       // Initialize the route to the TES LTC4302 itself
       _routeToTesLtc4302({_tesLtc4302, nullptr}),
-      _tca(TES_TCA_ADDR),
-      _ina(TES_INA_ADDR){}
+      _cal(),
+      _calTol_mA(TES_CAL_DEFAULT_TOL_MA),
+      _ready(false),
+      _present(true),
+      _tca(tcaAddress),
+      _ina(inaAddress){}
 
 uint8_t TESDriver::begin() {
-    RETURN_IF_ERROR(_tesLtc4302->begin()); // Call begin on the pointer
-    RETURN_IF_ERROR(connect());
-    RETURN_IF_ERROR(_tca.begin()); // Initialize TCA642ARGJR
-    RETURN_IF_ERROR(_ina.begin()); // Initialize INA219
+    RETURN_IF_ERROR(_router->flush()); // beginHub() disables the hub, so drop any cached route first
+    RETURN_IF_ERROR(beginHub());
+    return beginParts();
+}
+
+uint8_t TESDriver::beginHub() {
+    _ready = false;
+    uint8_t status = _tesLtc4302->begin();
+    _present = (status == 0);
+    return status;
+}
+
+void TESDriver::setPresent(bool present) {
+    _present = present;
+    if (!present) _ready = false; // A card fitted later starts from beginHub()
+}
+
+uint8_t TESDriver::beginParts() {
+    RETURN_IF_ERROR(connect()); // Sets up the TCA and INA219 while _ready is false
     return disconnect();
 }
 
 uint8_t TESDriver::setOutEnable(bool state) {
     state = !state; // Invert logic: HIGH = disable, LOW = enable
     RETURN_IF_ERROR(connect());
-    RETURN_IF_ERROR(_tesLtc4302->setGPIO(2, state)); // GPIO2 controls OUT_EN
-    RETURN_IF_ERROR(_tesLtc4302->setGPIO(1, state)); // GPIO1 controls OUT_EN
+    RETURN_IF_ERROR(_tesLtc4302->setGPIOs(state, state)); // GPIO1 and GPIO2 both control OUT_EN
     return disconnect();
 }
 
@@ -38,28 +77,65 @@ uint8_t TESDriver::getOutEnable(bool& state) {
 
 uint8_t TESDriver::getBusVoltage_V(float& busVoltage){
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_ina.refresh());
     RETURN_IF_ERROR(_ina.getBusVoltage_V(busVoltage));
     return disconnect();
 }
 
 uint8_t TESDriver::getShuntVoltage_mV(float& shuntVoltage){
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_ina.refresh());
     RETURN_IF_ERROR(_ina.getShuntVoltage_mV(shuntVoltage));
     return disconnect();
 }
 
 uint8_t TESDriver::getCurrent_mA(float& current){
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_ina.refresh());
     RETURN_IF_ERROR(_ina.getCurrent_mA(current));
     return disconnect();
 }
 
 uint8_t TESDriver::getPower_mW(float& power){
     RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_ina.refresh());
     RETURN_IF_ERROR(_ina.getPower_mW(power));
     return disconnect();
 }
 
+uint8_t TESDriver::readAll(TesReading& reading) {
+    RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_ina.refresh());
+    reading.timestamp_us = micros();
+    INA219Sample sample;
+    RETURN_IF_ERROR(_ina.readSample(sample));
+    reading.shunt_mV = _ina.toShunt_mV(sample.shunt);
+    reading.bus_V = _ina.toBus_V(sample.bus);
+    reading.current_mA = _ina.toCurrent_mA(sample.current);
+    reading.power_mW = _ina.toPower_mW(sample.power);
+    RETURN_IF_ERROR(_tca.getAllOutputPins(reading.tcaBits));
+    reading.tcaBits &= 0xFFFFFu; //Mask to 20 bits
+    bool gpio;
+    RETURN_IF_ERROR(_tesLtc4302->getGPIO(2, gpio)); // GPIO2 controls OUT_EN
+    reading.enabled = !gpio;
+    reading.duration_us = micros() - reading.timestamp_us;
+    return disconnect();
+}
+
+uint8_t TESDriver::setInaProfile(INA219Profile profile) {
+    RETURN_IF_ERROR(connect());
+    RETURN_IF_ERROR(_ina.setProfile(profile));
+    return disconnect();
+}
+
+uint8_t TESDriver::settle(int delayMs) {
+    // A triggered conversion starts after the write, so CNVR marks the first
+    // reading that can see it; otherwise sleep for the caller's worst case
+    if (_ina.isTriggered()) return _ina.refresh();
+    if (delayMs > 0) delay(delayMs);
+    return 0;
+}
+
 uint8_t TESDriver::setOutputPin(uint8_t pin, bool state) {
     RETURN_IF_ERROR(connect());
     RETURN_IF_ERROR(_tca.setOutputPin(pin, state));
@@ -78,57 +154,190 @@ uint8_t TESDriver::setAllOutputPins(uint32_t state) {
 uint8_t TESDriver::getAllOutputPins(uint32_t &state) {
     RETURN_IF_ERROR(connect());
     RETURN_IF_ERROR(_tca.getAllOutputPins(state));
-    Serial.println("TESDriver::getAllOutputPins read state: 0x" + String(state, HEX));
     state &= 0xFFFFFu; //Mask to 20 bits
     return disconnect();
 }
 
-uint8_t TESDriver::setCurrent_mA(float target_mA, uint32_t* finalState, float* finalMeasured, int delayMs) {
+uint8_t TESDriver::setCurrent_mA(float target_mA, uint32_t* finalState, float* finalMeasured, int delayMs,
+                                  TesSetMethod* method) {
     // Sanity: expected current range 0..20 mA
     if (!(target_mA >= 0.0f && target_mA <= 20.0f)) {
         return 10; // invalid argument
     }
 
-    // Connect once and iterate through bits MSB->LSB greedily.
     RETURN_IF_ERROR(this->connect());
 
-    uint32_t state = 0u; // start with all outputs off
+    uint32_t state = 0u;
     float measured_mA = 0.0f;
+    TesSetMethod used = TES_SET_SEARCH;
 
-    // Apply initial state
-    RETURN_IF_ERROR(this->setAllOutputPins(state));
-    if (delayMs > 0) delay(delayMs);
+    // With a calibration, write the predicted pattern once and check it with
+    // one read. Only a miss beyond the tolerance pays for the full search.
+    if (_cal.valid) {
+        state = predictBits(target_mA);
+        RETURN_IF_ERROR(_tca.setAllOutputPins(state));
+        RETURN_IF_ERROR(settle(delayMs));
+        RETURN_IF_ERROR(_ina.getCurrent_mA(measured_mA));
+        used = fabsf(measured_mA - target_mA) <= _calTol_mA ? TES_SET_MODEL : TES_SET_MODEL_FALLBACK;
+    }
+    if (used != TES_SET_MODEL) {
+        RETURN_IF_ERROR(searchCurrent(target_mA, state, measured_mA, delayMs));
+    }
+
+    // Disconnect route
+    RETURN_IF_ERROR(this->disconnect());
+
+    // Output final state and measured value if requested
+    if (finalState) {
+        *finalState = state;
+    }
+    if (finalMeasured) {
+        *finalMeasured = measured_mA;
+    }
+    if (method) {
+        *method = used;
+    }
+    return 0;
+}
+
+uint8_t TESDriver::searchCurrent(float target_mA, uint32_t& state, float& measured_mA, int delayMs) {
+    state = 0u; // start with all outputs off
+
+    // Apply initial state. The route stays open for the whole search, so
+    // talk to the TCA and INA directly rather than through the wrappers.
+    RETURN_IF_ERROR(_tca.setAllOutputPins(state));
+    RETURN_IF_ERROR(settle(delayMs));
     // Measure baseline
-    RETURN_IF_ERROR(this->getCurrent_mA(measured_mA));
+    RETURN_IF_ERROR(_ina.getCurrent_mA(measured_mA));
 
     // Greedy MSB-to-LSB bit setting: try each bit, keep it if it improves closeness to target
-    for (int bit = 19; bit >= 0; --bit) {
+    for (int bit = TES_NUM_BITS - 1; bit >= 0; --bit) {
         uint32_t candidate = state | ((uint32_t)1 << bit);
 
         // Set candidate state
-        RETURN_IF_ERROR(this->setAllOutputPins(candidate));
-        if (delayMs > 0) delay(delayMs);
+        RETURN_IF_ERROR(_tca.setAllOutputPins(candidate));
+        RETURN_IF_ERROR(settle(delayMs));
         // Measure baseline
         float candidateMeasured = 0.0f;
-        RETURN_IF_ERROR(this->getCurrent_mA(candidateMeasured));
+        RETURN_IF_ERROR(_ina.getCurrent_mA(candidateMeasured));
         if (candidateMeasured >= target_mA) {
             state = candidate;
             measured_mA = candidateMeasured;
         }
     }
-    delay(delayMs);
-    // Disconnect route
-    RETURN_IF_ERROR(this->disconnect());
+    if (!_ina.isTriggered()) delay(delayMs);
+    return 0;
+}
 
-    // Output final state and measured value if requested
-    if (finalState) {
-        *finalState = state;
+uint8_t TESDriver::setCurrents_mA(TESDriver* const* drivers, const float* targets, uint8_t count,
+                                  uint32_t* finalStates, float* finalMeasured, TesSetMethod* methods,
+                                  uint8_t* statuses, int delayMs) {
+    TesCurrentSearch search;
+    RETURN_IF_ERROR(search.begin(drivers, targets, count));
+    while (search.writeRound()) {
+        if (delayMs > 0 && search.needsSettle()) delay(delayMs);
+        search.readRound();
     }
-    if (finalMeasured) {
-        *finalMeasured = measured_mA;
+    for (uint8_t i = 0; i < count; ++i) {
+        finalStates[i] = search.get_state(i);
+        finalMeasured[i] = search.get_measured(i);
+        methods[i] = search.get_method(i);
+        statuses[i] = search.get_status(i);
+    }
+    return 0;
+}
+
+uint8_t TESDriver::calibrate(int delayMs) {
+    RETURN_IF_ERROR(connect());
+
+    uint32_t previous;
+    uint8_t status = _tca.getAllOutputPins(previous);
+    if (status) {
+        disconnect();
+        return status;
+    }
+
+    // Whatever happens while measuring, put the previous pattern back and
+    // end the route before returning; the first error is the one reported
+    TesCalibration cal = {};
+    status = measureCalibration(cal, delayMs);
+    uint8_t restoreStatus = _tca.setAllOutputPins(previous);
+    uint8_t disconnectStatus = disconnect();
+    if (!status) status = restoreStatus;
+    if (!status) status = disconnectStatus;
+    RETURN_IF_ERROR(status);
+
+    // No bit moved the current: outputs disabled or nothing connected
+    if (cal.measuredBits == 0) {
+        return TES_ERR_NO_CALIBRATION;
+    }
+    cal.valid = true;
+    _cal = cal;
+    return 0;
+}
+
+uint8_t TESDriver::measureCalibration(TesCalibration& cal, int delayMs) {
+    RETURN_IF_ERROR(_tca.setAllOutputPins(0u));
+    RETURN_IF_ERROR(settle(delayMs));
+    RETURN_IF_ERROR(_ina.getCurrent_mA(cal.base_mA));
+
+    // Measure bits one at a time from the MSB down. Once a step is too small
+    // for the INA219 to resolve, the remaining bits are taken as binary
+    // fractions of the last one measured.
+    int bit = TES_NUM_BITS - 1;
+    for (; bit >= 0; --bit) {
+        RETURN_IF_ERROR(_tca.setAllOutputPins((uint32_t)1 << bit));
+        RETURN_IF_ERROR(settle(delayMs));
+        float measured_mA;
+        RETURN_IF_ERROR(_ina.getCurrent_mA(measured_mA));
+        float weight_mA = cal.base_mA - measured_mA;
+        if (weight_mA < TES_CAL_MIN_WEIGHT_MA) break;
+        cal.weight_mA[bit] = weight_mA;
+        cal.measuredBits++;
+    }
+    for (; bit >= 0 && cal.measuredBits > 0; --bit) {
+        cal.weight_mA[bit] = cal.weight_mA[bit + 1] * 0.5f;
+    }
+    return 0;
+}
+
+uint32_t TESDriver::predictBits(float target_mA) {
+    // Same greedy rule as the search, run against the model
+    uint32_t state = 0u;
+    float predicted_mA = _cal.base_mA;
+    for (int bit = TES_NUM_BITS - 1; bit >= 0; --bit) {
+        float candidate_mA = predicted_mA - _cal.weight_mA[bit];
+        if (candidate_mA >= target_mA) {
+            state |= (uint32_t)1 << bit;
+            predicted_mA = candidate_mA;
+        }
+    }
+    return state;
+}
+
+#if TES_CAL_EEPROM
+uint8_t TESDriver::saveCalibration(uint8_t slot) {
+    if (!_cal.valid) {
+        return TES_ERR_NO_CALIBRATION;
+    }
+    TesCalRecord record;
+    record.magic = TES_CAL_MAGIC;
+    record.cal = _cal;
+    record.checksum = calChecksum(_cal);
+    EEPROM.put(TES_CAL_EEPROM_BASE + slot * TES_CAL_EEPROM_SLOT_SIZE, record);
+    return 0;
+}
+
+uint8_t TESDriver::loadCalibration(uint8_t slot) {
+    TesCalRecord record;
+    EEPROM.get(TES_CAL_EEPROM_BASE + slot * TES_CAL_EEPROM_SLOT_SIZE, record);
+    if (record.magic != TES_CAL_MAGIC || record.checksum != calChecksum(record.cal) || !record.cal.valid) {
+        return TES_ERR_NO_CALIBRATION;
     }
+    _cal = record.cal;
     return 0;
 }
+#endif
 
 uint8_t TESDriver::bumpOutputPins(int8_t delta) {
     uint32_t currentState;
@@ -140,9 +349,143 @@ uint8_t TESDriver::bumpOutputPins(int8_t delta) {
 }
 
 uint8_t TESDriver::connect() {
-    return _router->routeTo(&_routeToTesLtc4302);
+    if (!_present) return ROUTER_ERR_ABSENT; // Skip the NACKs until a rescan finds the card
+    RETURN_IF_ERROR(_router->routeTo(&_routeToTesLtc4302));
+    if (!_ready) {
+        // First use since beginHub() (or since boot, for a card found later)
+        RETURN_IF_ERROR(_tca.begin()); // Initialize TCA642ARGJR
+        RETURN_IF_ERROR(_ina.begin()); // Initialize INA219
+        _ready = true;
+    }
+    return 0;
 }
 
 uint8_t TESDriver::disconnect() {
     return _router->endRoute(&_routeToTesLtc4302);
-}
\ No newline at end of file
+}
+
+// --- TesCurrentSearch --------------------------------------------------------
+// Calibrated channels get one round with their model pattern. Channels without
+// a calibration, and those that missed the tolerance, then run the greedy
+// MSB-to-LSB search together: a baseline round with every bit clear, then one
+// round per bit.
+
+uint8_t TesCurrentSearch::begin(TESDriver* const* drivers, const float* targets, uint8_t count) {
+    if (count > TES_MAX_INTERLEAVED) {
+        return 10; // invalid argument
+    }
+    _count = count;
+    _phase = MODEL;
+    _bit = TES_NUM_BITS - 1;
+    for (uint8_t i = 0; i < count; ++i) {
+        _drivers[i] = drivers[i];
+        _targets[i] = targets[i];
+        _states[i] = 0u;
+        _measured[i] = 0.0f;
+        _methods[i] = TES_SET_SEARCH;
+        _statuses[i] = (targets[i] >= 0.0f && targets[i] <= 20.0f) ? 0 : 10;
+        _searching[i] = false;
+    }
+    return 0;
+}
+
+bool TesCurrentSearch::uses(const TESDriver* driver) {
+    for (uint8_t i = 0; i < _count; ++i) {
+        if (_drivers[i] == driver) return true;
+    }
+    return false;
+}
+
+bool TesCurrentSearch::needsSettle() {
+    // getCurrent_mA() triggers and waits for a conversion on FAST channels
+    for (uint8_t i = 0; i < _count; ++i) {
+        if (_drivers[i]->get_inaProfile() != INA219_PROFILE_FAST) return true;
+    }
+    return false;
+}
+
+bool TesCurrentSearch::writeRound() {
+    while (true) {
+        bool wrote = false;
+        switch (_phase) {
+        case MODEL:
+            for (uint8_t i = 0; i < _count; ++i) {
+                if (_statuses[i] || !_drivers[i]->get_calibration().valid) continue;
+                _states[i] = _drivers[i]->predictBits(_targets[i]);
+                _statuses[i] = _drivers[i]->setAllOutputPins(_states[i]);
+                _methods[i] = TES_SET_MODEL_FALLBACK; // Until the read proves otherwise
+                wrote = true;
+            }
+            if (wrote) return true;
+            _phase = BASELINE;
+            break;
+
+        case BASELINE:
+            for (uint8_t i = 0; i < _count; ++i) {
+                _searching[i] = _statuses[i] == 0 && _methods[i] != TES_SET_MODEL;
+                if (!_searching[i]) continue;
+                _states[i] = 0u;
+                _statuses[i] = _drivers[i]->setAllOutputPins(0u);
+                wrote = true;
+            }
+            if (wrote) return true;
+            _phase = DONE;
+            break;
+
+        case BIT:
+            if (_bit >= 0) {
+                for (uint8_t i = 0; i < _count; ++i) {
+                    if (!_searching[i] || _statuses[i]) continue;
+                    _statuses[i] = _drivers[i]->setAllOutputPins(_states[i] | ((uint32_t)1 << _bit));
+                    wrote = true;
+                }
+                if (wrote) return true;
+            }
+            _phase = DONE;
+            break;
+
+        case DONE:
+        default:
+            return false;
+        }
+    }
+}
+
+void TesCurrentSearch::readRound() {
+    switch (_phase) {
+    case MODEL:
+        for (uint8_t i = 0; i < _count; ++i) {
+            if (_statuses[i] || _methods[i] != TES_SET_MODEL_FALLBACK) continue;
+            _statuses[i] = _drivers[i]->getCurrent_mA(_measured[i]);
+            if (!_statuses[i] && fabsf(_measured[i] - _targets[i]) <= _drivers[i]->get_calibrationTolerance()) {
+                _methods[i] = TES_SET_MODEL;
+            }
+        }
+        _phase = BASELINE;
+        break;
+
+    case BASELINE:
+        for (uint8_t i = 0; i < _count; ++i) {
+            if (_searching[i] && !_statuses[i]) _statuses[i] = _drivers[i]->getCurrent_mA(_measured[i]);
+        }
+        _phase = BIT;
+        _bit = TES_NUM_BITS - 1;
+        break;
+
+    case BIT:
+        for (uint8_t i = 0; i < _count; ++i) {
+            if (!_searching[i] || _statuses[i]) continue;
+            float candidateMeasured = 0.0f;
+            _statuses[i] = _drivers[i]->getCurrent_mA(candidateMeasured);
+            if (!_statuses[i] && candidateMeasured >= _targets[i]) {
+                _states[i] |= (uint32_t)1 << _bit;
+                _measured[i] = candidateMeasured;
+            }
+        }
+        _bit--;
+        break;
+
+    default:
+        break;
+    }
+}
@@ -11,12 +11,69 @@
 #define TES_INA_ADDR    0x40 // Address for INA219 behind TES driver
 #define TES_TCA_ADDR    0x22 // Address for TCA642ARGJR behind TES driver
 
+#define TES_NUM_BITS 20                 // TCA outputs that steer TES current
+#define TES_CAL_MIN_WEIGHT_MA 0.005f    // Smaller per-bit steps are lost in INA219 noise and derived from the bit above
+#define TES_CAL_DEFAULT_TOL_MA 0.01f    // Model-based SET falls back to the search beyond this verify error
+#define TES_ERR_NO_CALIBRATION 21       // Calibration saw no response, or no valid record is stored
+#define TES_MAX_INTERLEAVED 16          // Channels one setCurrents_mA() call can drive
+
+// Set TES_CAL_EEPROM to 1 to keep calibrations in EEPROM across resets.
+// Each channel uses one slot starting at TES_CAL_EEPROM_BASE.
+#ifndef TES_CAL_EEPROM
+#define TES_CAL_EEPROM 0
+#endif
+#ifndef TES_CAL_EEPROM_BASE
+#define TES_CAL_EEPROM_BASE 0
+#endif
+#define TES_CAL_EEPROM_SLOT_SIZE 96
+
+// One coherent set of TES readings, taken inside a single route session
+struct TesReading {
+    float shunt_mV;
+    float bus_V;
+    float current_mA;
+    float power_mW;
+    uint32_t tcaBits;       // 20-bit TCA output state
+    bool enabled;
+    uint32_t timestamp_us;  // micros() when the first register was read
+    uint32_t duration_us;   // Time from the first to the last register read
+};
+
+// Per-bit model of one TES channel: the current with every bit clear, and
+// the current each bit removes when set. SET predicts a bit pattern from it.
+struct TesCalibration {
+    float base_mA;
+    float weight_mA[TES_NUM_BITS];
+    uint8_t measuredBits;   // Bits at and above TES_NUM_BITS - measuredBits were measured directly
+    bool valid;
+};
+
+// How setCurrent_mA() arrived at its bit pattern
+enum TesSetMethod {
+    TES_SET_SEARCH,          // Greedy search, no calibration
+    TES_SET_MODEL,           // One write from the calibration, verified by one read
+    TES_SET_MODEL_FALLBACK   // Calibration missed the tolerance, greedy search used
+};
+
 class TESDriver {
 public:
-    TESDriver(LTC4302* tesLtc4302, Router* router); // Removed baseHubChannel
-    uint8_t begin();
+    TESDriver(LTC4302* tesLtc4302, Router* router,
+              uint8_t inaAddress = TES_INA_ADDR, uint8_t tcaAddress = TES_TCA_ADDR);
+    uint8_t begin();      // beginHub() and then beginParts()
     I2CRoute getRouteToTesLtc4302() { return _routeToTesLtc4302; } // Accessor for the route
 
+    // Boot in two steps. beginHub() is one write that disconnects the card's
+    // bus and disables its outputs; it fails on an empty slot. The TCA and
+    // INA219 are set up on the first connect() after it, or by beginParts().
+    uint8_t beginHub();
+    uint8_t beginParts();
+    bool get_ready() { return _ready; } // Parts set up since the last beginHub()
+
+    // Cleared when beginHub() or a topology scan gets no answer from the hub;
+    // connect() then fails with ROUTER_ERR_ABSENT without touching the bus
+    void setPresent(bool present);
+    bool get_present() { return _present; }
+
     // GPIO functionality at LTC4302
     uint8_t setOutEnable(bool state);
     uint8_t getOutEnable(bool& state);
@@ -27,7 +84,39 @@ public:
     uint8_t getCurrent_mA(float& current);
     uint8_t getPower_mW(float& power);
 
-    uint8_t setCurrent_mA(float target_mA, uint32_t* finalState = nullptr, float* finalMeasured = nullptr, int delayMs = 10);
+    // Everything above in one route session
+    uint8_t readAll(TesReading& reading);
+
+    // INA219 ADC profile. With INA219_PROFILE_FAST every read triggers its
+    // own conversion and the searches wait for CNVR instead of delayMs.
+    uint8_t setInaProfile(INA219Profile profile);
+    INA219Profile get_inaProfile() { return _ina.get_profile(); }
+
+    uint8_t setCurrent_mA(float target_mA, uint32_t* finalState = nullptr, float* finalMeasured = nullptr, int delayMs = 10,
+                          TesSetMethod* method = nullptr);
+
+    // setCurrent_mA() on several channels at once. Each round writes the next
+    // bit on every channel, waits one shared settle period and then reads
+    // them all, so the whole set costs about as many settle periods as one
+    // channel. statuses[i] is channel i's own result; a channel that fails
+    // drops out and the others carry on.
+    static uint8_t setCurrents_mA(TESDriver* const* drivers, const float* targets, uint8_t count,
+                                  uint32_t* finalStates, float* finalMeasured, TesSetMethod* methods,
+                                  uint8_t* statuses, int delayMs = 10);
+
+    // Bit-weight calibration. calibrate() disturbs the output while it runs
+    // and restores the previous bit pattern afterwards.
+    uint8_t calibrate(int delayMs = 10);
+    const TesCalibration& get_calibration() { return _cal; }
+    void setCalibration(const TesCalibration& cal) { _cal = cal; }
+    void clearCalibration() { _cal.valid = false; }
+    void setCalibrationTolerance(float tol_mA) { _calTol_mA = tol_mA; }
+    float get_calibrationTolerance() { return _calTol_mA; }
+    uint32_t predictBits(float target_mA); // Bit pattern the calibration picks for target_mA
+#if TES_CAL_EEPROM
+    uint8_t saveCalibration(uint8_t slot);
+    uint8_t loadCalibration(uint8_t slot);
+#endif
 
     // TCA functionality
     uint8_t setOutputPin(uint8_t pin, bool state);
@@ -43,6 +132,15 @@ private:
     // Route for the TES LTC4302 itself
     I2CRoute _routeToTesLtc4302;
 
+    TesCalibration _cal;
+    float _calTol_mA;
+    bool _ready;
+    bool _present;
+
+    uint8_t searchCurrent(float target_mA, uint32_t& state, float& measured_mA, int delayMs); // Route must be open
+    uint8_t settle(int delayMs); // Route must be open. Wait for a fresh conversion after a write
+    uint8_t measureCalibration(TesCalibration& cal, int delayMs); // Route must be open; leaves a test pattern on the outputs
+
     // Placeholder for TES device routes (e.g., if multiple devices are behind this LTC)
     // For 12 devices, these would likely be an array or a more complex structure.
     // For now, we'll keep it simple, assuming direct interaction through the LTC.
@@ -56,4 +154,37 @@ public:
     uint8_t disconnect();
 };
 
+// The interleaved setCurrents_mA() search as a resumable state machine. Each
+// round is writeRound(), one settle period, then readRound(); writeRound()
+// returns false once every channel is finished. Channels are accessed
+// through the TESDriver wrappers, so each access routes to its own card and
+// other work may use the bus between rounds.
+class TesCurrentSearch {
+public:
+    uint8_t begin(TESDriver* const* drivers, const float* targets, uint8_t count);
+    bool writeRound();
+    void readRound();
+
+    uint8_t get_count() { return _count; }
+    uint32_t get_state(uint8_t i) { return _states[i]; }
+    float get_measured(uint8_t i) { return _measured[i]; }
+    TesSetMethod get_method(uint8_t i) { return _methods[i]; }
+    uint8_t get_status(uint8_t i) { return _statuses[i]; }
+    bool uses(const TESDriver* driver);
+    bool needsSettle(); // False when every channel waits for its own conversion (INA219_PROFILE_FAST)
+
+private:
+    enum Phase { MODEL, BASELINE, BIT, DONE };
+    Phase _phase;
+    int8_t _bit;
+    uint8_t _count;
+    TESDriver* _drivers[TES_MAX_INTERLEAVED];
+    float _targets[TES_MAX_INTERLEAVED];
+    uint32_t _states[TES_MAX_INTERLEAVED];
+    float _measured[TES_MAX_INTERLEAVED];
+    TesSetMethod _methods[TES_MAX_INTERLEAVED];
+    uint8_t _statuses[TES_MAX_INTERLEAVED];
+    bool _searching[TES_MAX_INTERLEAVED];
+};
+
 #endif // TES_DRIVER_H
@@ -0,0 +1,121 @@
+#include "Topology.h"
+#include "../helpers/I2CStats.h"
+
+#define TOPOLOGY_FIRST_ADDRESS 0x08 // 7-bit addresses outside the reserved ranges
+#define TOPOLOGY_LAST_ADDRESS 0x77
+
+Topology::Topology(Router* router, DeviceMap* map, TESDriver* const* tes, LNADriver* const* lna)
+    : _router(router), _map(map), _tes(tes), _lna(lna), _scanUs(0) {
+    _numTes = map->get_numTes() < TOPOLOGY_MAX_BRANCHES ? map->get_numTes() : TOPOLOGY_MAX_BRANCHES;
+    _numLna = map->get_numLna() < TOPOLOGY_MAX_BRANCHES - _numTes ? map->get_numLna() : TOPOLOGY_MAX_BRANCHES - _numTes;
+    memset(_branches, 0, sizeof(_branches));
+}
+
+uint8_t Topology::probe(uint8_t address) {
+    I2C_STATS_START(t);
+    Wire.beginTransmission(address);
+    return I2C_STATS_WRITE(t, address, 0, Wire.endTransmission());
+}
+
+uint8_t Topology::get_hubAddress(uint8_t i) {
+    return isLna(i) ? _map->get_lna(get_channelIndex(i)).hub : _map->get_tes(i).hub;
+}
+
+uint8_t Topology::get_parts(uint8_t i, uint8_t* addresses) {
+    if (isLna(i)) {
+        const LnaCardAddress& card = _map->get_lna(get_channelIndex(i));
+        addresses[0] = card.dac;
+        addresses[1] = card.inaDrain;
+        addresses[2] = card.inaGate;
+        return 3;
+    }
+    const TesCardAddress& card = _map->get_tes(i);
+    addresses[0] = card.ina;
+    addresses[1] = card.tca;
+    return 2;
+}
+
+void Topology::seed() {
+    uint32_t now = millis() ? millis() : 1;
+    for (uint8_t i = 0; i < get_numBranches(); ++i) {
+        TopologyBranch& branch = _branches[i];
+        memset(&branch, 0, sizeof(branch));
+        branch.scannedMs = now;
+        uint8_t index = get_channelIndex(i);
+        branch.hubPresent = isLna(i) ? _lna[index]->get_present() : _tes[index]->get_present();
+    }
+}
+
+void Topology::scan() {
+    uint32_t start = micros();
+    for (uint8_t i = 0; i < get_numBranches(); ++i) {
+        scanBranch(i, false, false);
+    }
+    _scanUs = micros() - start;
+}
+
+uint8_t Topology::rescan(bool lna, uint8_t index, bool sweep, bool reset) {
+    if (index >= (lna ? _numLna : _numTes)) return 10;
+    uint32_t start = micros();
+    scanBranch(lna ? _numTes + index : index, sweep, reset);
+    _scanUs = micros() - start;
+    return 0;
+}
+
+void Topology::sweepBase(uint8_t* seen) {
+    // With every card disconnected, only the base hub's own bus answers
+    memset(seen, 0, 16);
+    _router->flush();
+    for (uint8_t address = TOPOLOGY_FIRST_ADDRESS; address <= TOPOLOGY_LAST_ADDRESS; ++address) {
+        if (probe(address) == 0) seen[address >> 3] |= 1 << (address & 7);
+    }
+}
+
+void Topology::scanBranch(uint8_t i, bool sweep, bool reset) {
+    TopologyBranch& branch = _branches[i];
+    memset(&branch, 0, sizeof(branch));
+    branch.scannedMs = millis() ? millis() : 1;
+
+    // Card hubs sit on the base hub's bus, which stays connected
+    bool lna = isLna(i);
+    uint8_t index = get_channelIndex(i);
+    branch.hubPresent = probe(get_hubAddress(i)) == 0;
+    bool wasPresent = lna ? _lna[index]->get_present() : _tes[index]->get_present();
+    if (!branch.hubPresent) {
+        if (lna) _lna[index]->setPresent(false);
+        else _tes[index]->setPresent(false);
+        return;
+    }
+    uint8_t baseSeen[16];
+    if (sweep) sweepBase(baseSeen);
+    if (!wasPresent || reset) {
+        // Fitted since it was last seen, or swapped as the caller says:
+        // quiet it, as at boot. Its parts are set up on first use.
+        _router->flush();
+        if (lna) _lna[index]->beginHub();
+        else _tes[index]->beginHub();
+    }
+
+    I2CRoute route = lna ? _lna[index]->getRouteToLnaLtc4302() : _tes[index]->getRouteToTesLtc4302();
+    if (_router->routeTo(&route)) return;
+    uint8_t parts[TOPOLOGY_MAX_PARTS];
+    uint8_t numParts = get_parts(i, parts);
+    for (uint8_t p = 0; p < numParts; ++p) {
+        if (probe(parts[p]) == 0) branch.partsPresent |= 1 << p;
+    }
+    branch.partsScanned = true;
+    if (sweep) {
+        // Everything else behind the hub: the base bus is visible through
+        // it too, so addresses that answered without it are left out
+        for (uint8_t address = TOPOLOGY_FIRST_ADDRESS; address <= TOPOLOGY_LAST_ADDRESS; ++address) {
+            if (baseSeen[address >> 3] & (1 << (address & 7))) continue;
+            bool expected = false;
+            for (uint8_t p = 0; p < numParts; ++p) expected = expected || parts[p] == address;
+            if (expected || probe(address) != 0) continue;
+            if (branch.numExtra < TOPOLOGY_MAX_EXTRA) branch.extra[branch.numExtra] = address;
+            branch.numExtra++;
+        }
+        branch.swept = true;
+    }
+    _router->endRoute(&route);
+}
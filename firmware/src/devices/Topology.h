@@ -0,0 +1,70 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <Arduino.h>
+#include "DeviceTable.h"
+#include "../routers/Router.h"
+
+#define TOPOLOGY_MAX_BRANCHES 24    // TES cards first, then LNA cards
+#define TOPOLOGY_MAX_PARTS 3        // Expected parts behind one hub
+#define TOPOLOGY_MAX_EXTRA 4        // Unexpected addresses kept per branch by a sweep
+
+// What the last scan of one card saw
+struct TopologyBranch {
+    uint32_t scannedMs;             // millis() of the last scan; 0 = not scanned since boot
+    bool hubPresent;
+    bool partsScanned;              // The card's bus was connected and its expected parts probed
+    uint8_t partsPresent;           // Bit i: expected part i answered (DeviceMap order after the hub)
+    bool swept;                     // The scan also swept every address behind the hub
+    uint8_t numExtra;               // Answering addresses no table names, up to TOPOLOGY_MAX_EXTRA kept
+    uint8_t extra[TOPOLOGY_MAX_EXTRA];
+};
+
+// The crate's I2C tree: the base hub, with one LTC4302 per card on its
+// downstream bus and the card's parts behind that. Scans probe the
+// addresses the DeviceMap expects, one address-only write each, so a
+// whole-crate scan costs a few transactions per card instead of a sweep of
+// 112 addresses behind every hub. rescan() redoes a single branch, after a
+// card is swapped, and can sweep that branch for unexpected devices.
+//
+// Scans keep the drivers' presence flags current: a card whose hub does not
+// answer is marked absent, so its commands fail at once, and a card that
+// answers again is brought back with beginHub(). A card that stayed present
+// keeps its state; rescan() with `reset` runs beginHub() on it anyway, for
+// a card swapped between scans. seed() fills the map from the boot probe
+// without touching the bus.
+class Topology {
+public:
+    Topology(Router* router, DeviceMap* map, TESDriver* const* tes, LNADriver* const* lna);
+
+    void seed();                                    // Hub presence from the drivers, as the boot probe left it
+    void scan();                                    // Every branch, expected addresses only
+    uint8_t rescan(bool lna, uint8_t index, bool sweep, bool reset);  // One branch; 10 for an unknown channel
+    bool isLna(uint8_t i) { return i >= _numTes; }
+    uint8_t get_channelIndex(uint8_t i) { return isLna(i) ? i - _numTes : i; }
+
+    uint8_t get_numBranches() { return _numTes + _numLna; }
+    uint8_t get_numTes() { return _numTes; }
+    const TopologyBranch& get_branch(uint8_t i) { return _branches[i]; }
+    uint8_t get_hubAddress(uint8_t i);
+    uint8_t get_parts(uint8_t i, uint8_t* addresses);      // Expected part addresses; returns the count
+    uint32_t get_scanUs() { return _scanUs; }              // Duration of the last scan() or rescan()
+
+    // Probe an address on the bus as currently routed: 0 if it answered
+    static uint8_t probe(uint8_t address);
+
+private:
+    Router* _router;
+    DeviceMap* _map;
+    TESDriver* const* _tes;
+    LNADriver* const* _lna;
+    uint8_t _numTes;
+    uint8_t _numLna;
+    uint32_t _scanUs;
+    TopologyBranch _branches[TOPOLOGY_MAX_BRANCHES];
+
+    void scanBranch(uint8_t i, bool sweep, bool reset);
+    void sweepBase(uint8_t* seen);                  // 128-bit map of addresses answering with no card connected
+};
+
+#endif // TOPOLOGY_H
@@ -1,84 +1,218 @@
 #include "INA219.h"
+#include "../helpers/I2CStats.h"
 
-// Configuration Register Bits
-#define INA219_CONFIG_BVOLTAGERANGE_32V (0x01 << 13) // 0-32V Range
-#define INA219_CONFIG_GAIN_8_320MV      (0x04 << 11) // Gain 8, 320mV shunt voltage range
-#define INA219_CONFIG_BADCRES_12BIT     (0x03 << 7)  // 12-bit bus ADC resolution
-#define INA219_CONFIG_SADCRES_12BIT_128S (0x09 << 3) // 12-bit shunt ADC resolution, 128 samples
-#define INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS (0x07) // Shunt and Bus, Continuous
+#define INA219_CONFIG_RANGES (INA219_CONFIG_BVOLTAGERANGE_32V | INA219_CONFIG_GAIN_8_320MV)
 
-INA219::INA219(uint8_t i2cAddress) : _i2cAddress(i2cAddress), _currentDivider_mA(0), _powerMultiplier_mW(0) {}
+// Config register value and shunt-plus-bus conversion time per INA219Profile
+static const uint16_t profileConfig[] = {
+    INA219_CONFIG_RANGES | INA219_CONFIG_BADCRES_12BIT | INA219_CONFIG_SADCRES_12BIT | INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS,
+    INA219_CONFIG_RANGES | INA219_CONFIG_BADCRES_12BIT_128S | INA219_CONFIG_SADCRES_12BIT_128S | INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS,
+    INA219_CONFIG_RANGES | INA219_CONFIG_BADCRES_9BIT | INA219_CONFIG_SADCRES_9BIT | INA219_CONFIG_MODE_SANDBVOLT_TRIGGERED,
+};
+static const uint32_t profileConversion_us[] = { 1064, 136200, 168 };
+
+// Scale factor for value / 32768 as (count * mul) >> shift. mul stays within
+// 16 bits so a 16-bit count times mul cannot overflow 32 bits; low bits are
+// dropped only when they cannot all be kept.
+static void fixedScale(uint32_t value, int32_t& mul, uint8_t& shift) {
+    shift = 15;
+    while (value > 0xFFFF && shift > 0) {
+        value >>= 1;
+        shift--;
+    }
+    mul = (int32_t)value;
+}
+
+INA219::INA219(uint8_t i2cAddress)
+    : _i2cAddress(i2cAddress), _profile(INA219_PROFILE_DEFAULT),
+      _currentMul(0), _currentShift(0), _powerMul(0), _powerShift(0), _currentLsb_mA(0), _powerLsb_mW(0) {}
 
 uint8_t INA219::begin() {
     Wire.begin();
-    return calibrate(INA219_RSHUNT, INA219_MAX_EXPECTED_CURRENT); // Default calibration: 10 ohm shunt, 32mA max current
+    RETURN_IF_ERROR(calibrate(INA219_RSHUNT, INA219_MAX_EXPECTED_CURRENT)); // Default calibration: 10 ohm shunt, 32mA max current
+    return setProfile(_profile); // The device may keep an old profile across an MCU reset
 }
 
 uint8_t INA219::begin(float shuntResistance, float maxCurrent) {
     Wire.begin();
-    return calibrate(shuntResistance, maxCurrent); // Default calibration: 10 ohm shunt, 32mA max current
+    RETURN_IF_ERROR(calibrate(shuntResistance, maxCurrent)); // Default calibration: 10 ohm shunt, 32mA max current
+    return setProfile(_profile);
 }
 
 uint8_t INA219::calibrate(float shuntResistance, float maxCurrent) {
+    return calibrate_uA((uint32_t)(shuntResistance * 1000.0f + 0.5f), (uint32_t)(maxCurrent * 1000000.0f + 0.5f));
+}
+
+uint8_t INA219::calibrate_uA(uint32_t shunt_mOhm, uint32_t maxCurrent_uA) {
     // Calculate calibration register value
     // Calibration value = trunc (0.04096 / (Current_LSB * R_Shunt))
     // Current_LSB = maxCurrent / 32768 (for 12-bit ADC)
     // Simplified: Cal = (0.04096 * 32768) / (maxCurrent * R_Shunt)
-    // Cal = 1342.17728 / (maxCurrent * R_Shunt)
-
-    float current_LSB = maxCurrent / 32768.0; // Amps per LSB
-    uint16_t calValue = (uint16_t)(0.04096 / (current_LSB * shuntResistance));
+    // In uA and mOhm: Cal = 1342177280000 / (maxCurrent_uA * R_Shunt_mOhm) = (625 << 31) / ...
+    uint64_t product = (uint64_t)maxCurrent_uA * shunt_mOhm;
+    if (product == 0) {
+        return 10; // invalid argument
+    }
+    uint16_t calValue = (uint16_t)((625ULL << 31) / product);
 
     RETURN_IF_ERROR(writeRegister(INA219_REG_CALIBRATION, calValue));
 
     // These values are used for converting raw register values to meaningful units
-    _currentDivider_mA = 1 / (current_LSB * 1000.0) ; // Current LSB in mA
-    _powerMultiplier_mW = 20.0 * _currentDivider_mA; // Power LSB in mW (Power LSB = 20 * Current LSB)
+    // Current LSB = maxCurrent / 32768; Power LSB = 20 * Current LSB
+    fixedScale(maxCurrent_uA, _currentMul, _currentShift);
+    int32_t powerMul;
+    fixedScale(20 * maxCurrent_uA, powerMul, _powerShift);
+    _powerMul = (uint32_t)powerMul;
+    _currentLsb_mA = maxCurrent_uA / 32768000.0f;
+    _powerLsb_mW = 20.0f * _currentLsb_mA;
     return 0;
 }
 
-uint8_t INA219::getShuntVoltage_mV(float &shuntVoltage) {
+uint8_t INA219::getShuntVoltageRaw(int16_t& raw) {
     uint16_t value;
     RETURN_IF_ERROR(readRegister(INA219_REG_SHUNTVOLTAGE, value));
-    shuntVoltage = (int16_t)value * 0.01; // LSB = 10 uV = 0.01 mV
+    raw = (int16_t)value;
     return 0;
 }
 
-uint8_t INA219::getBusVoltage_V(float &busVoltage) {
+uint8_t INA219::getBusVoltageRaw(uint16_t& raw) {
     uint16_t value;
     RETURN_IF_ERROR(readRegister(INA219_REG_BUSVOLTAGE, value));
-    value >>= 3; // Shift to get rid of CNVR and OVF bits
-    busVoltage = (float)value * 0.004; // LSB = 4 mV = 0.004 V
+    raw = value >> 3; // Shift to get rid of CNVR and OVF bits
     return 0;
 }
 
-uint8_t INA219::getCurrent_mA(float &current) {
+uint8_t INA219::getCurrentRaw(int16_t& raw) {
     uint16_t value;
     RETURN_IF_ERROR(readRegister(INA219_REG_CURRENT, value));
-    current = (int16_t)value / _currentDivider_mA;
+    raw = (int16_t)value;
+    return 0;
+}
+
+uint8_t INA219::getPowerRaw(uint16_t& raw) {
+    return readRegister(INA219_REG_POWER, raw);
+}
+
+uint8_t INA219::readSample(INA219Sample& sample) {
+    uint16_t bus, shunt, current;
+    RETURN_IF_ERROR(readRegister(INA219_REG_BUSVOLTAGE, bus, false));
+    RETURN_IF_ERROR(readRegister(INA219_REG_SHUNTVOLTAGE, shunt, false));
+    RETURN_IF_ERROR(readRegister(INA219_REG_CURRENT, current, false));
+    RETURN_IF_ERROR(readRegister(INA219_REG_POWER, sample.power));
+    sample.bus = bus >> 3;
+    sample.conversionReady = (bus & INA219_BUSVOLTAGE_CNVR) != 0;
+    sample.overflow = (bus & INA219_BUSVOLTAGE_OVF) != 0;
+    sample.shunt = (int16_t)shunt;
+    sample.current = (int16_t)current;
+    return 0;
+}
+
+uint8_t INA219::getShuntVoltage_uV(int32_t& shuntVoltage) {
+    int16_t raw;
+    RETURN_IF_ERROR(getShuntVoltageRaw(raw));
+    shuntVoltage = toShunt_uV(raw);
+    return 0;
+}
+
+uint8_t INA219::getBusVoltage_uV(int32_t& busVoltage) {
+    uint16_t raw;
+    RETURN_IF_ERROR(getBusVoltageRaw(raw));
+    busVoltage = toBus_uV(raw);
+    return 0;
+}
+
+uint8_t INA219::getCurrent_uA(int32_t& current) {
+    int16_t raw;
+    RETURN_IF_ERROR(getCurrentRaw(raw));
+    current = toCurrent_uA(raw);
+    return 0;
+}
+
+uint8_t INA219::getPower_uW(int32_t& power) {
+    uint16_t raw;
+    RETURN_IF_ERROR(getPowerRaw(raw));
+    power = toPower_uW(raw);
+    return 0;
+}
+
+uint8_t INA219::getShuntVoltage_mV(float &shuntVoltage) {
+    int16_t raw;
+    RETURN_IF_ERROR(getShuntVoltageRaw(raw));
+    shuntVoltage = toShunt_mV(raw);
+    return 0;
+}
+
+uint8_t INA219::getBusVoltage_V(float &busVoltage) {
+    uint16_t raw;
+    RETURN_IF_ERROR(getBusVoltageRaw(raw));
+    busVoltage = toBus_V(raw);
+    return 0;
+}
+
+uint8_t INA219::getCurrent_mA(float &current) {
+    int16_t raw;
+    RETURN_IF_ERROR(getCurrentRaw(raw));
+    current = toCurrent_mA(raw);
     return 0;
 }
 
 uint8_t INA219::getPower_mW(float &power) {
-    uint16_t value;
-    RETURN_IF_ERROR(readRegister(INA219_REG_POWER, value));
-    power = (int16_t)value / _powerMultiplier_mW;
+    uint16_t raw;
+    RETURN_IF_ERROR(getPowerRaw(raw));
+    power = toPower_mW(raw);
+    return 0;
+}
+
+uint8_t INA219::setProfile(INA219Profile profile) {
+    RETURN_IF_ERROR(writeRegister(INA219_REG_CONFIG, profileConfig[profile]));
+    _profile = profile;
     return 0;
 }
 
+uint32_t INA219::get_conversionTime_us() {
+    return profileConversion_us[_profile];
+}
+
+uint8_t INA219::startConversion() {
+    // Writing the operating mode clears CNVR and restarts the ADC, in
+    // triggered and continuous modes alike
+    return writeRegister(INA219_REG_CONFIG, profileConfig[_profile]);
+}
+
+uint8_t INA219::waitConversion() {
+    // The datasheet times are typical; allow twice as long before giving up
+    uint32_t timeout_us = 2 * get_conversionTime_us() + 1000;
+    uint32_t start = micros();
+    uint16_t value;
+    do {
+        RETURN_IF_ERROR(readRegister(INA219_REG_BUSVOLTAGE, value));
+        if (value & INA219_BUSVOLTAGE_CNVR) return 0;
+    } while (micros() - start < timeout_us);
+    return INA219_ERR_CONVERSION_TIMEOUT;
+}
+
+uint8_t INA219::refresh() {
+    if (!isTriggered()) return 0;
+    RETURN_IF_ERROR(startConversion());
+    return waitConversion();
+}
+
 uint8_t INA219::writeRegister(uint8_t reg, uint16_t value) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_i2cAddress);
     Wire.write(reg);
     Wire.write((value >> 8) & 0xFF); // High byte
     Wire.write(value & 0xFF);       // Low byte
-    return Wire.endTransmission();
+    return I2C_STATS_WRITE(t, _i2cAddress, 3, Wire.endTransmission());
 }
 
-uint8_t INA219::readRegister(uint8_t reg, uint16_t& value) {
+uint8_t INA219::readRegister(uint8_t reg, uint16_t& value, bool stop) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_i2cAddress);
     Wire.write(reg);
-    RETURN_IF_ERROR(Wire.endTransmission(false)); // Send restart
-    Wire.requestFrom(_i2cAddress, (uint8_t)2);
+    RETURN_IF_ERROR(I2C_STATS_WRITE(t, _i2cAddress, 1, Wire.endTransmission(false))); // Send restart
+    uint8_t received = Wire.requestFrom(_i2cAddress, (uint8_t)2, (uint8_t)stop); // Without a stop the next access is a restart
+    I2C_STATS_READ(t, _i2cAddress, 2, received);
     
     value = 0;
     if (Wire.available() == 2) {
@@ -17,6 +17,45 @@
 #define INA219_REG_CURRENT      0x04
 #define INA219_REG_CALIBRATION  0x05
 
+// Configuration Register Bits
+#define INA219_CONFIG_RESET             (0x8000)     // Reset all registers to power-on values
+#define INA219_CONFIG_BVOLTAGERANGE_32V (0x01 << 13) // 0-32V Range
+#define INA219_CONFIG_GAIN_8_320MV      (0x03 << 11) // Gain 8, 320mV shunt voltage range
+#define INA219_CONFIG_BADCRES_9BIT      (0x00 << 7)  // 9-bit bus ADC resolution, 84 us
+#define INA219_CONFIG_BADCRES_12BIT     (0x03 << 7)  // 12-bit bus ADC resolution, 532 us
+#define INA219_CONFIG_BADCRES_12BIT_128S (0x0F << 7) // 12-bit bus ADC resolution, 128 samples, 68.10 ms
+#define INA219_CONFIG_SADCRES_9BIT      (0x00 << 3)  // 9-bit shunt ADC resolution, 84 us
+#define INA219_CONFIG_SADCRES_12BIT     (0x03 << 3)  // 12-bit shunt ADC resolution, 532 us
+#define INA219_CONFIG_SADCRES_12BIT_128S (0x0F << 3) // 12-bit shunt ADC resolution, 128 samples, 68.10 ms
+#define INA219_CONFIG_MODE_SANDBVOLT_TRIGGERED  (0x03) // Shunt and Bus, one conversion per config write
+#define INA219_CONFIG_MODE_SANDBVOLT_CONTINUOUS (0x07) // Shunt and Bus, Continuous
+#define INA219_CONFIG_MODE_MASK         (0x07)
+
+// Bus Voltage Register Bits
+#define INA219_BUSVOLTAGE_CNVR          (0x02)       // Conversion ready; cleared by a config write or a power read
+#define INA219_BUSVOLTAGE_OVF           (0x01)       // Math overflow
+
+#define INA219_ERR_CONVERSION_TIMEOUT 22 // CNVR did not set within twice the conversion time
+
+// ADC set-ups for the two kinds of reader. Every profile keeps the 32 V bus
+// range and the 320 mV shunt range, so calibrations are unaffected.
+enum INA219Profile {
+    INA219_PROFILE_DEFAULT,  // Power-on configuration: 12-bit, continuous, 1.06 ms per conversion
+    INA219_PROFILE_MONITOR,  // 12-bit averaged over 128 samples, continuous, 136 ms per conversion
+    INA219_PROFILE_FAST      // 9-bit, one conversion per trigger, 168 us; for search loops
+};
+
+// Raw register contents from one readSample() call. The to*() conversions
+// turn counts into fixed-point micro-units or floats.
+struct INA219Sample {
+    int16_t shunt;          // 10 uV per count
+    uint16_t bus;           // 4 mV per count, CNVR and OVF stripped
+    int16_t current;        // maxCurrent / 32768 per count
+    uint16_t power;         // 20 current counts times 1 V per count
+    bool conversionReady;   // CNVR was set when the bus register was read
+    bool overflow;          // OVF: the current or power calculation overflowed
+};
+
 class INA219 {
 public:
     INA219(uint8_t i2cAddress);
@@ -24,20 +63,67 @@ public:
     uint8_t begin();
     uint8_t begin(float shuntResistance, float maxCurrent);
     uint8_t calibrate(float shuntResistance, float maxCurrent); // shuntResistance in ohms, maxCurrent in Amps
+    uint8_t calibrate_uA(uint32_t shunt_mOhm, uint32_t maxCurrent_uA); // Integer form of calibrate()
 
     uint8_t getShuntVoltage_mV(float& shuntVoltage);
     uint8_t getBusVoltage_V(float& busVoltage);
     uint8_t getCurrent_mA(float& current);
     uint8_t getPower_mW(float& power);
 
+    // Fixed-point readings in integer arithmetic only
+    uint8_t getShuntVoltage_uV(int32_t& shuntVoltage);
+    uint8_t getBusVoltage_uV(int32_t& busVoltage);
+    uint8_t getCurrent_uA(int32_t& current);
+    uint8_t getPower_uW(int32_t& power);
+
+    // Register counts. Reading power clears CNVR.
+    uint8_t getShuntVoltageRaw(int16_t& raw);
+    uint8_t getBusVoltageRaw(uint16_t& raw);
+    uint8_t getCurrentRaw(int16_t& raw);
+    uint8_t getPowerRaw(uint16_t& raw);
+
+    // Bus, shunt, current and power in one bus transaction (repeated starts,
+    // one stop), power last so CNVR is cleared only after the rest
+    uint8_t readSample(INA219Sample& sample);
+
+    // Count conversions, using the scale factors calibrate() precomputes.
+    // Fixed-point results round towards minus infinity.
+    int32_t toShunt_uV(int16_t raw) { return (int32_t)raw * 10; }
+    int32_t toBus_uV(uint16_t raw) { return (int32_t)raw * 4000; }
+    int32_t toCurrent_uA(int16_t raw) { return ((int32_t)raw * _currentMul) >> _currentShift; }
+    int32_t toPower_uW(uint16_t raw) { return (int32_t)(((uint32_t)raw * _powerMul) >> _powerShift); }
+    float toShunt_mV(int16_t raw) { return raw * 0.01; }   // LSB = 10 uV = 0.01 mV
+    float toBus_V(uint16_t raw) { return raw * 0.004; }    // LSB = 4 mV = 0.004 V
+    float toCurrent_mA(int16_t raw) { return raw * _currentLsb_mA; }
+    float toPower_mW(uint16_t raw) { return raw * _powerLsb_mW; }
+
+    // ADC profile. In FAST the device converts only when triggered, so
+    // readers call refresh() (or startConversion() and waitConversion())
+    // before reading.
+    uint8_t setProfile(INA219Profile profile);
+    INA219Profile get_profile() { return _profile; }
+    bool isTriggered() { return _profile == INA219_PROFILE_FAST; }
+    uint32_t get_conversionTime_us(); // Shunt plus bus conversion time of the current profile
+
+    uint8_t startConversion();        // Rewrite the config: clears CNVR and starts a fresh conversion
+    uint8_t waitConversion();         // Poll CNVR until the conversion finishes
+    uint8_t refresh();                // Triggered profile: start a conversion and wait for it; otherwise nothing
+
 private:
     uint8_t _i2cAddress;
+    INA219Profile _profile;
 
     uint8_t writeRegister(uint8_t reg, uint16_t value);
-    uint8_t readRegister(uint8_t reg, uint16_t& value);
+    uint8_t readRegister(uint8_t reg, uint16_t& value, bool stop = true);
 
-    float _currentDivider_mA;
-    float _powerMultiplier_mW;
+    // Fixed point: micro-units = (count * mul) >> shift
+    int32_t _currentMul;
+    uint8_t _currentShift;
+    uint32_t _powerMul;
+    uint8_t _powerShift;
+    // Float getters
+    float _currentLsb_mA;
+    float _powerLsb_mW;
 };
 
 #endif // INA219_H
@@ -1,19 +1,28 @@
 #include "LTC4302.h"
+#include "../helpers/I2CStats.h"
 
-LTC4302::LTC4302(uint8_t i2cAddress) : _i2cAddress(i2cAddress) {}
+LTC4302::LTC4302(uint8_t i2cAddress)
+    : _i2cAddress(i2cAddress),
+      _control(0),
+      _shadowValid(false),
+      _verifyIntervalMs(0),
+      _lastVerifyMs(0),
+      _verifyMismatches(0) {}
 
 uint8_t LTC4302::begin() {
     Wire.begin();
-    RETURN_IF_ERROR(disableBus()); // Start with bus disabled
-    RETURN_IF_ERROR(setGPIO(1, true)); // Set GPIO1 HIGH
-    RETURN_IF_ERROR(setGPIO(2, true)); // Set GPIO2 HIGH
+    // Start with bus disabled, GPIO1 and GPIO2 HIGH. Writing every control
+    // bit also loads the shadow.
+    return writeControl(LTC4302_CONTROL_MASK, LTC4302_GPIO1 | LTC4302_GPIO2);
 }
 
 uint8_t LTC4302::readRegister(uint8_t reg, uint8_t& value) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_i2cAddress);
     Wire.write(reg);
-    RETURN_IF_ERROR(Wire.endTransmission(false)); // Send restart
-    Wire.requestFrom(_i2cAddress, (uint8_t)1);
+    RETURN_IF_ERROR(I2C_STATS_WRITE(t, _i2cAddress, 1, Wire.endTransmission(false))); // Send restart
+    uint8_t received = Wire.requestFrom(_i2cAddress, (uint8_t)1);
+    I2C_STATS_READ(t, _i2cAddress, 1, received);
     if (Wire.available()) {
         value = Wire.read();
     } else {
@@ -23,16 +32,56 @@ uint8_t LTC4302::readRegister(uint8_t reg, uint8_t& value) {
 }
 
 uint8_t LTC4302::writeRegister(uint8_t reg, uint8_t value) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_i2cAddress);
     Wire.write(reg);
     Wire.write(value);
-    return Wire.endTransmission();
+    return I2C_STATS_WRITE(t, _i2cAddress, 2, Wire.endTransmission());
 }
 
 uint8_t LTC4302::writeRegister(uint8_t value) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_i2cAddress);
     Wire.write(value);
-    return Wire.endTransmission();
+    return I2C_STATS_WRITE(t, _i2cAddress, 1, Wire.endTransmission());
+}
+
+uint8_t LTC4302::verify() {
+    uint8_t regValue;
+    RETURN_IF_ERROR(readRegister(LTC4302_REG_CONTROL, regValue));
+    regValue &= LTC4302_CONTROL_MASK;
+    if (_shadowValid && regValue != _control) {
+        _verifyMismatches++;
+    }
+    _control = regValue;
+    _shadowValid = true;
+    _lastVerifyMs = millis();
+    return 0;
+}
+
+uint8_t LTC4302::writeControl(uint8_t mask, uint8_t value) {
+    bool verifyDue = _verifyIntervalMs != 0 && (uint32_t)(millis() - _lastVerifyMs) >= _verifyIntervalMs;
+    bool partial = (mask & LTC4302_CONTROL_MASK) != LTC4302_CONTROL_MASK;
+    if ((!_shadowValid && partial) || verifyDue) {
+        RETURN_IF_ERROR(verify());
+    }
+    uint8_t regValue = (uint8_t)((_control & ~mask) | (value & mask)) & LTC4302_CONTROL_MASK;
+    uint8_t status = writeRegister(regValue);
+    if (status) {
+        _shadowValid = false; // Unknown whether the write landed
+        return status;
+    }
+    _control = regValue;
+    _shadowValid = true;
+    return 0;
+}
+
+uint8_t LTC4302::getControl(uint8_t& value) {
+    if (!_shadowValid) {
+        RETURN_IF_ERROR(verify());
+    }
+    value = _control;
+    return 0;
 }
 
 uint8_t LTC4302::setGPIO(uint8_t gpioPin, bool state) {
@@ -41,17 +90,13 @@ uint8_t LTC4302::setGPIO(uint8_t gpioPin, bool state) {
         Serial.println("LTC4302: Invalid GPIO pin (use 1 or 2)");
         return 10;
     }
-    uint8_t bit = (gpioPin == 1) ? (1 << 5) : (1 << 6);
-    uint8_t regValue;
-    RETURN_IF_ERROR(readRegister(0x01, regValue));
-    if (state) {
-        // Serial.println("LTC4302: Setting GPIO" + String(gpioPin) + " HIGH on address 0x" + String(_i2cAddress, HEX));
-        regValue |= bit;
-    } else {
-        // Serial.println("LTC4302: Setting GPIO" + String(gpioPin) + " LOW on address 0x" + String(_i2cAddress, HEX));
-        regValue &= ~bit;
-    }
-    return writeRegister(regValue);
+    uint8_t bit = (gpioPin == 1) ? LTC4302_GPIO1 : LTC4302_GPIO2;
+    return writeControl(bit, state ? bit : 0);
+}
+
+uint8_t LTC4302::setGPIOs(bool gpio1, bool gpio2) {
+    return writeControl(LTC4302_GPIO1 | LTC4302_GPIO2,
+                        (gpio1 ? LTC4302_GPIO1 : 0) | (gpio2 ? LTC4302_GPIO2 : 0));
 }
 
 uint8_t LTC4302::getGPIO(uint8_t gpioPin, bool& state) {
@@ -61,31 +106,17 @@ uint8_t LTC4302::getGPIO(uint8_t gpioPin, bool& state) {
         state = false;
         return 10;
     }
-    uint8_t bit = (gpioPin == 1) ? (1 << 5) : (1 << 6);
+    uint8_t bit = (gpioPin == 1) ? LTC4302_GPIO1 : LTC4302_GPIO2;
     uint8_t regValue;
-    RETURN_IF_ERROR(readRegister(0x01, regValue));
+    RETURN_IF_ERROR(getControl(regValue));
     state = (regValue & bit) != 0;
     return 0;
 }
 
 uint8_t LTC4302::enableBus() {
-    // Assuming a specific register and bit for enabling the bus.
-    // This needs to be confirmed with the LTC4302 datasheet.
-    // For now, let's assume register 0x01 controls the bus enable,
-    // and setting bit 0 enables it.
-    // Serial.println("LTC4302: Enabling bus on address 0x" + String(_i2cAddress, HEX));
-    uint8_t regValue;
-    RETURN_IF_ERROR(readRegister(0x01, regValue));
-    return writeRegister(regValue | 1 << 7); // Set bit 7
+    return writeControl(LTC4302_BUS_ENABLE, LTC4302_BUS_ENABLE); // Set bit 7
 }
 
 uint8_t LTC4302::disableBus() {
-    // Assuming a specific register and bit for disabling the bus.
-    // This needs to be confirmed with the LTC4302 datasheet.
-    // For now, let's assume register 0x01 controls the bus enable,
-    // and clearing bit 0 disables it.
-    // Serial.println("LTC4302: Disabling bus on address 0x" + String(_i2cAddress, HEX));
-    uint8_t regValue; 
-    RETURN_IF_ERROR(readRegister(0x01, regValue));
-    return writeRegister(regValue & ~(1 << 7)); // Clear bit 7
+    return writeControl(LTC4302_BUS_ENABLE, 0); // Clear bit 7
 }
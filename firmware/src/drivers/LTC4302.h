@@ -5,21 +5,50 @@
 #include <Wire.h>
 #include "../helpers/error.h"
 
+// Control register (0x01) bits
+#define LTC4302_REG_CONTROL      0x01
+#define LTC4302_BUS_ENABLE       (1 << 7) // Connect the downstream bus
+#define LTC4302_GPIO2            (1 << 6)
+#define LTC4302_GPIO1            (1 << 5)
+#define LTC4302_CONTROL_MASK     (LTC4302_BUS_ENABLE | LTC4302_GPIO2 | LTC4302_GPIO1)
+
+// The driver keeps a shadow of the control register, so bit changes are a
+// single write instead of a read-modify-write. begin() writes every control
+// bit, which sets the shadow without a read. After a failed write the shadow
+// is invalid, and the next change of only some bits reads the register
+// first. With a verify interval set, the first change after each interval
+// re-reads the register to catch a hub that was reset behind our back.
 class LTC4302 {
 public:
     LTC4302(uint8_t i2cAddress);
     uint8_t begin();
     uint8_t setGPIO(uint8_t gpioPin, bool state);
     uint8_t getGPIO(uint8_t gpioPin, bool& state);
+    uint8_t setGPIOs(bool gpio1, bool gpio2); // Both GPIOs in one write
     uint8_t enableBus();
     uint8_t disableBus();
     uint8_t get_i2cAddress() { return _i2cAddress; }
 
+    // Apply the LTC4302_* bits in `mask` from `value` in a single write
+    uint8_t writeControl(uint8_t mask, uint8_t value);
+    uint8_t getControl(uint8_t& value); // Shadowed control bits
+
+    // Shadow verification
+    void setVerifyInterval(uint32_t intervalMs) { _verifyIntervalMs = intervalMs; } // 0 = never
+    uint8_t verify(); // Re-read the register now and adopt the hardware state
+    uint32_t get_verifyMismatches() { return _verifyMismatches; }
+
 private:
     uint8_t _i2cAddress;
+    uint8_t _control;          // Shadow of the LTC4302_CONTROL_MASK bits
+    bool _shadowValid;
+    uint32_t _verifyIntervalMs;
+    uint32_t _lastVerifyMs;
+    uint32_t _verifyMismatches;
+
     uint8_t readRegister(uint8_t reg, uint8_t& value);
     uint8_t writeRegister(uint8_t reg, uint8_t value);
     uint8_t writeRegister(uint8_t value);
 };
 
-#endif // LTC4302_H
\ No newline at end of file
+#endif // LTC4302_H
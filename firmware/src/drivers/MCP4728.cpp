@@ -1,4 +1,5 @@
 #include "MCP4728.h"
+#include "../helpers/I2CStats.h"
 
 MCP4728::MCP4728(uint8_t i2cAddress) : _i2cAddress(i2cAddress) {}
 
@@ -12,14 +13,20 @@ uint8_t MCP4728::begin() {
 
 uint8_t MCP4728::writeDAC(MCP4728_channel_t channel, uint16_t value, bool useVDD) {
     value = value & 0x0FFF; // Ensure value is 12-bit
+    // The Adafruit library does the I2C itself, so each call is counted as
+    // the single transaction it issues: a 3-byte multi-write...
+    I2C_STATS_START(t);
     if (useVDD) {
-        return mcp.setChannelValue(channel, value) == true ? 0 : 1;
+        return I2C_STATS_WRITE(t, _i2cAddress, 3, mcp.setChannelValue(channel, value) == true ? 0 : 1);
     } else {
-        return mcp.setChannelValue(channel, value, MCP4728_VREF_INTERNAL) == true ? 0 : 1;
+        return I2C_STATS_WRITE(t, _i2cAddress, 3, mcp.setChannelValue(channel, value, MCP4728_VREF_INTERNAL) == true ? 0 : 1);
     }
 }
 
 uint8_t MCP4728::readDAC(MCP4728_channel_t channel, uint16_t& value) {
+    // ...or the 24-byte status read, which reports no failure
+    I2C_STATS_START(t);
     value = mcp.getChannelValue(channel);
+    I2C_STATS_READ(t, _i2cAddress, 24, 24);
     return 0;
 }
\ No newline at end of file
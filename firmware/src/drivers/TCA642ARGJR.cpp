@@ -1,6 +1,10 @@
 #include "TCA642ARGJR.h"
+#include "../helpers/I2CStats.h"
 
-TCA642ARGJR::TCA642ARGJR(uint8_t address): _address(address) {}
+TCA642ARGJR::TCA642ARGJR(uint8_t address)
+    : _address(address),
+      _outputShadow{0xFF, 0xFF, 0xFF},
+      _outputShadowValid(false) {}
 
 uint8_t TCA642ARGJR::begin() {
     Wire.begin();
@@ -8,9 +12,7 @@ uint8_t TCA642ARGJR::begin() {
     uint8_t config[3] = {0x00, 0x00, 0x00};
     RETURN_IF_ERROR(writeRegisters(TCA642ARGJR_CONFIG_PORT0, config, 3));
 
-    uint8_t outputs[3] = {0xFF, 0xFF, 0xFF};
-    RETURN_IF_ERROR(writeRegisters(TCA642ARGJR_OUTPUT_PORT0, outputs, 3));
-    return 0;
+    return setAllOutputPins(0xFFFFFFu);
 }
 
 uint8_t TCA642ARGJR::setOutputPin(uint8_t pin, bool state) {
@@ -18,14 +20,23 @@ uint8_t TCA642ARGJR::setOutputPin(uint8_t pin, bool state) {
     uint8_t port = pin / 8;
     uint8_t bit = pin % 8;
     uint8_t reg = TCA642ARGJR_OUTPUT_PORT0 + port;
-    uint8_t currentValue;
 
-    RETURN_IF_ERROR(readRegister(reg, currentValue));
+    if (!_outputShadowValid) {
+        RETURN_IF_ERROR(readRegisters(TCA642ARGJR_OUTPUT_PORT0, _outputShadow, 3));
+        _outputShadowValid = true;
+    }
+    uint8_t currentValue = _outputShadow[port];
 
     if (state) currentValue |= (1 << bit);
     else currentValue &= ~(1 << bit);
 
-    return writeRegister(reg, currentValue);
+    uint8_t status = writeRegister(reg, currentValue);
+    if (status) {
+        _outputShadowValid = false;
+        return status;
+    }
+    _outputShadow[port] = currentValue;
+    return 0;
 }
 
 uint8_t TCA642ARGJR::getOutputPin(uint8_t pin, bool& state) {
@@ -44,31 +55,43 @@ uint8_t TCA642ARGJR::setAllOutputPins(uint32_t state) {
     out[0] = state & 0xFF;
     out[1] = (state >> 8) & 0xFF;
     out[2] = (state >> 16) & 0xFF;
-    return writeRegisters(TCA642ARGJR_OUTPUT_PORT0, out, 3);
+    uint8_t status = writeRegisters(TCA642ARGJR_OUTPUT_PORT0, out, 3);
+    if (status) {
+        _outputShadowValid = false;
+        return status;
+    }
+    memcpy(_outputShadow, out, 3);
+    _outputShadowValid = true;
+    return 0;
 }
 
 uint8_t TCA642ARGJR::getAllOutputPins(uint32_t& state) {
     uint8_t out[3];
     RETURN_IF_ERROR(readRegisters(TCA642ARGJR_OUTPUT_PORT0, out, 3));
+    memcpy(_outputShadow, out, 3);
+    _outputShadowValid = true;
     state = ((uint32_t)out[2] << 16) | ((uint32_t)out[1] << 8) | out[0];
     return 0;
 }
 
 uint8_t TCA642ARGJR::writeRegister(uint8_t reg, uint8_t value) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_address);
     Wire.write(reg);
     Wire.write(value);
-    return Wire.endTransmission();
+    return I2C_STATS_WRITE(t, _address, 2, Wire.endTransmission());
 }
 
 uint8_t TCA642ARGJR::readRegister(uint8_t reg, uint8_t& value) {
+    I2C_STATS_START(t);
     Wire.beginTransmission(_address);
     Wire.write(reg);
     // Use repeated-start (no stop) to transition directly to read without releasing the bus.
-    RETURN_IF_ERROR(Wire.endTransmission(false));
+    RETURN_IF_ERROR(I2C_STATS_WRITE(t, _address, 1, Wire.endTransmission(false)));
 
     // Disambiguate overloaded requestFrom by casting to the exact types expected.
-    Wire.requestFrom((uint8_t)_address, (size_t)1);
+    uint8_t received = Wire.requestFrom((uint8_t)_address, (size_t)1);
+    I2C_STATS_READ(t, _address, 1, received);
     if (Wire.available()) {
         value = Wire.read();
         return 0;
@@ -78,19 +101,26 @@ uint8_t TCA642ARGJR::readRegister(uint8_t reg, uint8_t& value) {
 }
 
 uint8_t TCA642ARGJR::writeRegisters(uint8_t startReg, const uint8_t* data, size_t length) {
+    // One transaction: the auto-increment flag steps through the bank.
+    I2C_STATS_START(t);
+    Wire.beginTransmission(_address);
+    Wire.write(startReg | TCA642ARGJR_AUTO_INCREMENT);
     for (size_t i = 0; i < length; ++i) {
-        RETURN_IF_ERROR(writeRegister(startReg + i, data[i]));
+        Wire.write(data[i]);
     }
-    return 0;
+    return I2C_STATS_WRITE(t, _address, 1 + length, Wire.endTransmission());
 }
 
 uint8_t TCA642ARGJR::readRegisters(uint8_t startReg, uint8_t* data, size_t length) {
     // Optimize by writing the start register once and then requesting all bytes in one read.
+    // Without the auto-increment flag every byte would come from startReg.
+    I2C_STATS_START(t);
     Wire.beginTransmission(_address);
-    Wire.write(startReg);
-    RETURN_IF_ERROR(Wire.endTransmission(false)); // repeated start
+    Wire.write(startReg | TCA642ARGJR_AUTO_INCREMENT);
+    RETURN_IF_ERROR(I2C_STATS_WRITE(t, _address, 1, Wire.endTransmission(false))); // repeated start
 
-    Wire.requestFrom((uint8_t)_address, (size_t)length);
+    uint8_t received = Wire.requestFrom((uint8_t)_address, (size_t)length);
+    I2C_STATS_READ(t, _address, length, received);
     size_t i = 0;
     while (Wire.available() && i < length) {
         data[i++] = Wire.read();
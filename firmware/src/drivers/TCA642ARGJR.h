@@ -26,6 +26,8 @@
 #define TCA642ARGJR_CONFIG_PORT0 0x0C
 #define TCA642ARGJR_CONFIG_PORT1 0x0D
 #define TCA642ARGJR_CONFIG_PORT2 0x0E
+// Command byte flag: auto-increment the register pointer within a bank
+#define TCA642ARGJR_AUTO_INCREMENT 0x80
 
 class TCA642ARGJR {
 public:
@@ -41,6 +43,12 @@ public:
 private:
     uint8_t _address;
 
+    // Last value written to (or read from) the three output port registers,
+    // so single-pin updates need no read. Invalid until begin() or after a
+    // failed write.
+    uint8_t _outputShadow[3];
+    bool _outputShadowValid;
+
     uint8_t writeRegister(uint8_t reg, uint8_t value);
     uint8_t readRegister(uint8_t reg, uint8_t& value);
     uint8_t writeRegisters(uint8_t startReg, const uint8_t* data, size_t length);
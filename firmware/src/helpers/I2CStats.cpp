@@ -0,0 +1,96 @@
+#include "I2CStats.h"
+
+#if I2C_STATS
+
+I2CStats i2cStats;
+
+static void addCounters(I2CCounters& to, const I2CCounters& now, const I2CCounters& before) {
+    to.transactions += now.transactions - before.transactions;
+    to.bytes += now.bytes - before.bytes;
+    to.errors += now.errors - before.errors;
+    to.micros += now.micros - before.micros;
+}
+
+I2CStats::I2CStats() : _depth(0) {
+    reset();
+}
+
+void I2CStats::reset() {
+    _totals = I2CCounters();
+    for (uint8_t i = 0; i < I2C_STATS_NUM_CODES; ++i) _errorCodes[i] = 0;
+    _resetMs = millis();
+    _deviceCount = 0;
+    _commandCount = 0;
+}
+
+void I2CStats::record(uint8_t address, uint8_t bytes, uint8_t status, uint32_t& start) {
+    uint32_t now = micros();
+    uint32_t elapsed = now - start;
+    start = now;
+
+    _totals.transactions++;
+    _totals.bytes += bytes;
+    _totals.micros += elapsed;
+    if (status) {
+        _totals.errors++;
+        _errorCodes[status < I2C_STATS_NUM_CODES ? status : 4]++; // Unknown codes count as "other" (4)
+    }
+
+    // Linear search: a crate has about twenty distinct addresses
+    uint8_t i = 0;
+    while (i < _deviceCount && _devices[i].address != address) ++i;
+    if (i == _deviceCount) {
+        if (_deviceCount == I2C_STATS_MAX_DEVICES) return;
+        _devices[i] = I2CDeviceStats();
+        _devices[i].address = address;
+        _deviceCount++;
+    }
+    I2CDeviceStats& device = _devices[i];
+    device.counters.transactions++;
+    device.counters.bytes += bytes;
+    device.counters.micros += elapsed;
+    if (status) {
+        device.counters.errors++;
+        device.lastError = status;
+    }
+}
+
+uint8_t I2CStats::recordWrite(uint8_t address, uint8_t bytes, uint8_t status, uint32_t& start) {
+    record(address, bytes, status, start);
+    return status;
+}
+
+void I2CStats::recordRead(uint8_t address, uint8_t requested, uint8_t received, uint32_t& start) {
+    record(address, received, received == requested ? 0 : I2C_STATS_SHORT_READ, start);
+}
+
+void I2CStats::charge(const char* name, const I2CCounters& before) {
+    uint8_t i = 0;
+    while (i < _commandCount && _commands[i].name != name) ++i;
+    if (i == _commandCount) {
+        if (_commandCount == I2C_STATS_MAX_COMMANDS) {
+            i = I2C_STATS_MAX_COMMANDS - 1;
+            _commands[i].name = "(other)";
+        } else {
+            _commands[i] = I2CCommandStats();
+            _commands[i].name = name;
+            _commandCount++;
+        }
+    }
+    _commands[i].calls++;
+    addCounters(_commands[i].counters, _totals, before);
+}
+
+I2CStatsScope::I2CStatsScope(const char* name, bool countIdle)
+    : _name(name), _before(i2cStats.get_totals()), _countIdle(countIdle) {
+    _outer = i2cStats.enter();
+}
+
+I2CStatsScope::~I2CStatsScope() {
+    i2cStats.leave();
+    if (!_outer) return;
+    if (!_countIdle && i2cStats.get_totals().transactions == _before.transactions) return;
+    i2cStats.charge(_name, _before);
+}
+
+#endif // I2C_STATS
@@ -0,0 +1,112 @@
+#ifndef I2C_STATS_H
+#define I2C_STATS_H
+
+#include <Arduino.h>
+
+// I2C transaction counters, per device address and per serial command.
+// Set I2C_STATS to 0 to compile the instrumentation out entirely: the macros
+// below then reduce to the bare Wire calls.
+#ifndef I2C_STATS
+#define I2C_STATS 1
+#endif
+
+#define I2C_STATS_MAX_DEVICES 24    // Addresses tracked; further ones are only in the totals
+#define I2C_STATS_MAX_COMMANDS 24   // Commands tracked; further ones share the last row
+#define I2C_STATS_SHORT_READ 6      // Pseudo status: requestFrom() returned fewer bytes than asked
+#define I2C_STATS_NUM_CODES 7       // Status 1-5 from endTransmission(), plus I2C_STATS_SHORT_READ
+
+struct I2CCounters {
+    uint32_t transactions;  // endTransmission() and requestFrom() calls
+    uint32_t bytes;         // Payload bytes written or received, excluding the address byte
+    uint32_t errors;        // Transactions with a non-zero status
+    uint32_t micros;        // Time spent inside the Wire calls
+};
+
+struct I2CDeviceStats {
+    uint8_t address;
+    uint8_t lastError;      // Most recent non-zero status, 0 if none
+    I2CCounters counters;
+};
+
+struct I2CCommandStats {
+    const char* name;       // Handler name (__func__), or a fixed label such as "jobs"
+    uint16_t calls;
+    I2CCounters counters;
+};
+
+#if I2C_STATS
+
+class I2CStats {
+public:
+    I2CStats();
+
+    // Record one transaction that started at `start` (micros()). `start` is
+    // moved on to now, so the phases of a repeated-start access are timed
+    // separately. recordWrite() passes `status` through.
+    uint8_t recordWrite(uint8_t address, uint8_t bytes, uint8_t status, uint32_t& start);
+    void recordRead(uint8_t address, uint8_t requested, uint8_t received, uint32_t& start);
+    void reset();
+
+    const I2CCounters& get_totals() { return _totals; }
+    uint32_t get_errorCount(uint8_t status) { return status < I2C_STATS_NUM_CODES ? _errorCodes[status] : 0; }
+    uint32_t get_elapsedMs() { return millis() - _resetMs; }
+    uint8_t get_deviceCount() { return _deviceCount; }
+    const I2CDeviceStats& get_device(uint8_t i) { return _devices[i]; }
+    uint8_t get_commandCount() { return _commandCount; }
+    const I2CCommandStats& get_command(uint8_t i) { return _commands[i]; }
+
+    // Used by I2CStatsScope. enter() is true for the outermost scope, which
+    // charge()s the traffic since `before` to its command; nested scopes
+    // count towards the outermost one.
+    bool enter() { return _depth++ == 0; }
+    void leave() { _depth--; }
+    void charge(const char* name, const I2CCounters& before);
+
+private:
+    I2CCounters _totals;
+    uint32_t _errorCodes[I2C_STATS_NUM_CODES];
+    uint32_t _resetMs;
+    I2CDeviceStats _devices[I2C_STATS_MAX_DEVICES];
+    uint8_t _deviceCount;
+    I2CCommandStats _commands[I2C_STATS_MAX_COMMANDS];
+    uint8_t _commandCount;
+    uint8_t _depth;
+
+    void record(uint8_t address, uint8_t bytes, uint8_t status, uint32_t& start);
+};
+
+extern I2CStats i2cStats;
+
+// Charges the I2C traffic of its lifetime to `name`. With countIdle false,
+// a pass that did no I2C is not counted as a call (for loop() services).
+class I2CStatsScope {
+public:
+    I2CStatsScope(const char* name, bool countIdle = true);
+    ~I2CStatsScope();
+
+private:
+    const char* _name;
+    I2CCounters _before;
+    bool _outer;
+    bool _countIdle;
+};
+
+#define I2C_STATS_START(t) uint32_t t = micros()
+#define I2C_STATS_WRITE(t, address, bytes, status) i2cStats.recordWrite((address), (bytes), (status), t)
+#define I2C_STATS_READ(t, address, requested, received) i2cStats.recordRead((address), (requested), (received), t)
+#define I2C_STATS_SCOPE(name) I2CStatsScope _i2cStatsScope(name)
+#define I2C_STATS_COMMAND() I2C_STATS_SCOPE(__func__)
+#define I2C_STATS_SERVICE(name) I2CStatsScope _i2cStatsScope(name, false)
+
+#else
+
+#define I2C_STATS_START(t)
+#define I2C_STATS_WRITE(t, address, bytes, status) (status)
+#define I2C_STATS_READ(t, address, requested, received) ((void)(received))
+#define I2C_STATS_SCOPE(name)
+#define I2C_STATS_COMMAND()
+#define I2C_STATS_SERVICE(name)
+
+#endif // I2C_STATS
+
+#endif // I2C_STATS_H
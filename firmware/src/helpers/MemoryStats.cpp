@@ -0,0 +1,49 @@
+#include "MemoryStats.h"
+
+MemoryStats memoryStats;
+
+#if defined(__AVR__)
+extern char __heap_start;
+extern char* __brkval;
+
+static uint32_t freeBytes() {
+    char top;
+    return (uint32_t)(&top - (__brkval ? __brkval : &__heap_start));
+}
+#define MEMORY_STATS_SUPPORTED 1
+#elif defined(__arm__)
+extern "C" char* sbrk(int increment);
+
+static uint32_t freeBytes() {
+    char top;
+    return (uint32_t)(&top - sbrk(0));
+}
+#define MEMORY_STATS_SUPPORTED 1
+#else
+static uint32_t freeBytes() {
+    return 0;
+}
+#define MEMORY_STATS_SUPPORTED 0
+#endif
+
+MemoryStats::MemoryStats() : _minFree(UINT32_MAX) {}
+
+bool MemoryStats::get_supported() {
+    return MEMORY_STATS_SUPPORTED;
+}
+
+uint32_t MemoryStats::get_free() {
+    return freeBytes();
+}
+
+void MemoryStats::sample() {
+    uint32_t free = freeBytes();
+    if (free < _minFree) {
+        _minFree = free;
+    }
+}
+
+void MemoryStats::resetMark() {
+    _minFree = UINT32_MAX;
+    sample();
+}
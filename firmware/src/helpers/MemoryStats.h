@@ -0,0 +1,31 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <Arduino.h>
+
+// Free RAM between the top of the heap and the stack, and its low-water
+// mark. sample() is cheap and is called from loop() and from each response
+// header, so the mark includes the stack depth of the command handlers. A
+// mark that keeps falling over days of uptime points at heap growth.
+//
+// Measured on AVR and ARM cores; elsewhere (the host simulator)
+// get_supported() is false and both values read 0.
+
+class MemoryStats {
+public:
+    MemoryStats();
+
+    void sample();
+    void resetMark();
+
+    bool get_supported();
+    uint32_t get_free();
+    uint32_t get_minFree() { return _minFree; }
+
+private:
+    uint32_t _minFree;
+};
+
+extern MemoryStats memoryStats;
+
+#endif // MEMORY_STATS_H
@@ -0,0 +1,168 @@
+#include "YAMLWriter.h"
+
+static const uint32_t POWERS_OF_TEN[] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+size_t LineBuffer::write(uint8_t c) {
+    if (_length == sizeof(_buffer)) {
+        flush();
+    }
+    _buffer[_length++] = (char)c;
+    return 1;
+}
+
+size_t LineBuffer::write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+void LineBuffer::flush() {
+    if (_length) {
+        _out.write((const uint8_t*)_buffer, _length);
+        _length = 0;
+    }
+}
+
+// Writes the digits of `value` right-aligned into `end`, padded with zeros
+// to at least `width`; returns the first digit.
+static char* formatDecimal(char* end, unsigned long value, uint8_t width = 1) {
+    char* p = end;
+    do {
+        *--p = (char)('0' + value % 10);
+        value /= 10;
+    } while (value || end - p < width);
+    return p;
+}
+
+void printInt(Print& out, unsigned long value) {
+    char buffer[20];
+    char* end = buffer + sizeof(buffer);
+    char* p = formatDecimal(end, value);
+    out.write((const uint8_t*)p, end - p);
+}
+
+void printInt(Print& out, long value) {
+    char buffer[21];
+    char* end = buffer + sizeof(buffer);
+    // Negate as unsigned so LONG_MIN survives
+    char* p = formatDecimal(end, value < 0 ? 0UL - (unsigned long)value : (unsigned long)value);
+    if (value < 0) *--p = '-';
+    out.write((const uint8_t*)p, end - p);
+}
+
+void printFixed(Print& out, float value, uint8_t decimals) {
+    if (decimals > 9) decimals = 9;
+    // Scaled in double where the core has one, so large readings keep their last digit
+    double scaled = fabs((double)value) * POWERS_OF_TEN[decimals] + 0.5;
+    if (!(scaled < 4294967295.0)) {
+        out.print(value, decimals);  // NaN, infinite or out of range: Print's own formatting
+        return;
+    }
+    uint32_t units = (uint32_t)scaled;
+    char buffer[22];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    if (decimals) {
+        p = formatDecimal(p, units % POWERS_OF_TEN[decimals], decimals);
+        *--p = '.';
+    }
+    p = formatDecimal(p, units / POWERS_OF_TEN[decimals]);
+    if (value < 0 && units) *--p = '-';
+    out.write((const uint8_t*)p, end - p);
+}
+
+void printHex(Print& out, uint32_t value, uint8_t width) {
+    char buffer[8];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    if (width > sizeof(buffer)) width = sizeof(buffer);
+    do {
+        *--p = "0123456789ABCDEF"[value & 0xF];
+        value >>= 4;
+    } while (value || end - p < width);
+    out.write((const uint8_t*)p, end - p);
+}
+
+void printBool(Print& out, bool value) {
+    out.write(value ? "true" : "false");
+}
+
+void printQuoted(Print& out, const char* value) {
+    out.write('"');
+    for (const char* p = value; *p; ++p) {
+        if (*p == '\\' || *p == '"') out.write('\\');
+        out.write((uint8_t)*p);
+    }
+    out.write('"');
+}
+
+void printIndent(Print& out, int indent) {
+    for (int i = 0; i < indent; ++i) out.write(' ');
+}
+
+void printYAMLKey(Print& out, const char* key, int indent) {
+    printIndent(out, indent);
+    out.write(key);
+    out.write(": ");
+}
+
+void printYAMLSection(Print& out, const char* key, int indent) {
+    LineBuffer line(out);
+    printIndent(line, indent);
+    line.write(key);
+    line.println(":");
+}
+
+void printYAMLString(Print& out, const char* key, const char* value, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    printQuoted(line, value);
+    line.println();
+}
+
+void printYAMLPlain(Print& out, const char* key, const char* value, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    line.write(value);
+    line.println();
+}
+
+void printYAMLInt(Print& out, const char* key, long value, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    printInt(line, value);
+    line.println();
+}
+
+void printYAMLInt(Print& out, const char* key, unsigned long value, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    printInt(line, value);
+    line.println();
+}
+
+void printYAMLFloat(Print& out, const char* key, float value, uint8_t decimals, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    printFixed(line, value, decimals);
+    line.println();
+}
+
+void printYAMLBool(Print& out, const char* key, bool value, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    printBool(line, value);
+    line.println();
+}
+
+void printYAMLHex(Print& out, const char* key, uint32_t value, uint8_t width, int indent) {
+    LineBuffer line(out);
+    printYAMLKey(line, key, indent);
+    line.write("\"0x");
+    printHex(line, value, width);
+    line.write('"');
+    line.println();
+}
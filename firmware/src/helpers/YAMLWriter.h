@@ -0,0 +1,62 @@
+#ifndef YAML_WRITER_H
+#define YAML_WRITER_H
+
+#include <Arduino.h>
+
+// Response formatting without heap allocation. Values are formatted into
+// small stack buffers, and each YAML line is assembled in a LineBuffer and
+// handed to the port in one write(), so a response neither allocates a
+// String nor makes a write() call per token.
+
+#ifndef YAML_LINE_BUFFER_SIZE
+#define YAML_LINE_BUFFER_SIZE 64  // Longer lines are written in several parts
+#endif
+
+// Print that collects output on the stack and passes it on in blocks:
+// when full, on flush() and when it goes out of scope.
+class LineBuffer : public Print {
+public:
+    explicit LineBuffer(Print& out) : _out(out), _length(0) {}
+    ~LineBuffer() { flush(); }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void flush();
+
+private:
+    Print& _out;
+    uint8_t _length;
+    char _buffer[YAML_LINE_BUFFER_SIZE];
+};
+
+// Single values. printFixed() rounds to `decimals` places (at most 9) in
+// integer arithmetic; printHex() pads to `width` upper-case digits.
+void printInt(Print& out, long value);
+void printInt(Print& out, unsigned long value);
+inline void printInt(Print& out, int value) { printInt(out, (long)value); }
+inline void printInt(Print& out, unsigned int value) { printInt(out, (unsigned long)value); }
+void printFixed(Print& out, float value, uint8_t decimals);
+void printHex(Print& out, uint32_t value, uint8_t width);
+void printBool(Print& out, bool value);
+void printQuoted(Print& out, const char* value);  // Double quoted, with \ and " escaped
+
+// "<indent>key: value" lines
+void printIndent(Print& out, int indent);
+void printYAMLKey(Print& out, const char* key, int indent = 2);  // Starts a line: "  key: "
+void printYAMLSection(Print& out, const char* key, int indent = 2);  // "  key:" above a nested block
+void printYAMLString(Print& out, const char* key, const char* value, int indent = 2);
+void printYAMLPlain(Print& out, const char* key, const char* value, int indent = 2);  // Unquoted
+void printYAMLInt(Print& out, const char* key, long value, int indent = 2);
+void printYAMLInt(Print& out, const char* key, unsigned long value, int indent = 2);
+inline void printYAMLInt(Print& out, const char* key, int value, int indent = 2) {
+    printYAMLInt(out, key, (long)value, indent);
+}
+inline void printYAMLInt(Print& out, const char* key, unsigned int value, int indent = 2) {
+    printYAMLInt(out, key, (unsigned long)value, indent);
+}
+void printYAMLFloat(Print& out, const char* key, float value, uint8_t decimals = 4, int indent = 2);
+void printYAMLBool(Print& out, const char* key, bool value, int indent = 2);
+void printYAMLHex(Print& out, const char* key, uint32_t value, uint8_t width, int indent = 2);  // "0x..." quoted
+
+#endif // YAML_WRITER_H
@@ -0,0 +1,36 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include <Arduino.h>
+#include "../helpers/error.h"
+
+enum JobState {
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_FAILED,
+    JOB_CANCELLED
+};
+
+// A long operation broken into short steps. step() does one slice of work
+// and either finishes or calls sleepFor() and returns JOB_RUNNING; the engine
+// calls it again once that time has passed. Steps must not block.
+class Job {
+public:
+    virtual ~Job() {}
+    virtual const char* get_kind() = 0;            // e.g. "TES_SET"
+    virtual JobState step() = 0;
+    virtual bool uses(const void* device) = 0;     // True if the job drives this TESDriver/LNADriver
+    virtual void printResult(Stream& out, uint8_t indent) = 0; // YAML keys for JOB STATUS
+
+    uint8_t get_status() { return _status; }       // Error code once a step has failed
+    uint32_t get_wakeMs() { return _wakeMs; }
+
+protected:
+    void sleepFor(uint32_t ms) { _wakeMs = millis() + ms; }
+    JobState fail(uint8_t status) { _status = status; return JOB_FAILED; }
+
+    uint8_t _status = 0;
+    uint32_t _wakeMs = 0;
+};
+
+#endif // JOB_H
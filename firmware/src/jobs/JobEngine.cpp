@@ -0,0 +1,96 @@
+#include "JobEngine.h"
+
+JobEngine::JobEngine() : _nextId(1) {
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        _slots[i].id = 0;
+        _slots[i].state = JOB_DONE;
+        _slots[i].job = nullptr;
+        _slots[i].startMs = 0;
+        _slots[i].endMs = 0;
+    }
+}
+
+JobSlot* JobEngine::reserve() {
+    // Prefer a free slot, otherwise recycle the job that finished first
+    JobSlot* target = nullptr;
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        JobSlot& s = _slots[i];
+        if (s.id == 0) {
+            target = &s;
+            break;
+        }
+        if (s.state != JOB_RUNNING && (!target || s.endMs - target->endMs > 0x80000000u)) {
+            target = &s;
+        }
+    }
+    if (!target) return nullptr;
+    if (target->job) {
+        target->job->~Job();
+        target->job = nullptr;
+        target->id = 0;
+    }
+    return target;
+}
+
+uint16_t JobEngine::start(JobSlot* target, Job* job) {
+    uint16_t id = _nextId++;
+    if (_nextId == 0) _nextId = 1;
+    target->id = id;
+    target->state = JOB_RUNNING;
+    target->job = job;
+    target->startMs = millis();
+    target->endMs = 0;
+    return id;
+}
+
+void JobEngine::service() {
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        JobSlot& s = _slots[i];
+        if (s.id == 0 || s.state != JOB_RUNNING) continue;
+        if ((int32_t)(millis() - s.job->get_wakeMs()) < 0) continue;
+        s.state = s.job->step();
+        if (s.state != JOB_RUNNING) s.endMs = millis();
+    }
+}
+
+bool JobEngine::cancel(uint16_t id) {
+    JobSlot* s = find(id);
+    if (!s || s->state != JOB_RUNNING) return false;
+    s->state = JOB_CANCELLED;
+    s->endMs = millis();
+    return true;
+}
+
+JobSlot* JobEngine::find(uint16_t id) {
+    if (id == 0) return nullptr;
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        if (_slots[i].id == id) return &_slots[i];
+    }
+    return nullptr;
+}
+
+bool JobEngine::busy(const void* device) {
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        const JobSlot& s = _slots[i];
+        if (s.id && s.state == JOB_RUNNING && s.job->uses(device)) return true;
+    }
+    return false;
+}
+
+uint8_t JobEngine::get_running() {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < JOB_MAX; ++i) {
+        if (_slots[i].id && _slots[i].state == JOB_RUNNING) n++;
+    }
+    return n;
+}
+
+const char* jobStateName(JobState state) {
+    switch (state) {
+    case JOB_RUNNING: return "running";
+    case JOB_DONE: return "done";
+    case JOB_FAILED: return "failed";
+    case JOB_CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
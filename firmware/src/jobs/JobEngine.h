@@ -0,0 +1,56 @@
+#ifndef JOB_ENGINE_H
+#define JOB_ENGINE_H
+
+#include <Arduino.h>
+#include <new>
+#include "Job.h"
+#include "Jobs.h"
+
+#define JOB_MAX 8                // Jobs held at once, running or finished
+#define JOB_ERR_TABLE_FULL 30    // Every slot holds a running job
+
+// Room in each slot for the largest job in Jobs.h. submit() builds the job
+// in place, so jobs never come from the heap.
+#define JOB_STORAGE_SIZE (sizeof(TesSetJob) > sizeof(LnaSetJob) ? sizeof(TesSetJob) : sizeof(LnaSetJob))
+
+struct JobSlot {
+    uint16_t id;        // 0 = free
+    JobState state;
+    Job* job;           // Points into storage while the slot holds a job
+    uint32_t startMs;
+    uint32_t endMs;
+    alignas(TesSetJob) alignas(LnaSetJob) uint8_t storage[JOB_STORAGE_SIZE];
+};
+
+// Fixed table of jobs driven from loop(). Finished jobs stay in the table so
+// their result can be polled, until their slot is needed for a new job.
+class JobEngine {
+public:
+    JobEngine();
+    // Build a T from args in a free (or the oldest finished) slot; returns
+    // the job ID, or 0 if every slot holds a running job
+    template <typename T, typename... A>
+    uint16_t submit(const A&... args) {
+        static_assert(sizeof(T) <= JOB_STORAGE_SIZE, "Job type larger than JOB_STORAGE_SIZE");
+        JobSlot* target = reserve();
+        if (!target) return 0;
+        return start(target, new (target->storage) T(args...));
+    }
+    void service();              // Call from loop(); steps every job that is due
+    bool cancel(uint16_t id);    // Stop a running job where it is
+    JobSlot* find(uint16_t id);
+    JobSlot* slot(uint8_t index) { return &_slots[index]; }
+    bool busy(const void* device); // A running job drives this device
+    uint8_t get_running();
+
+private:
+    JobSlot _slots[JOB_MAX];
+    uint16_t _nextId;
+
+    JobSlot* reserve();                     // Emptied slot for a new job, or nullptr
+    uint16_t start(JobSlot* target, Job* job);
+};
+
+const char* jobStateName(JobState state);
+
+#endif // JOB_ENGINE_H
@@ -0,0 +1,97 @@
+#include "Jobs.h"
+#include "../helpers/YAMLWriter.h"
+
+// Jobs print their results as plain YAML at the indent they are given.
+
+// --- TesSetJob ---------------------------------------------------------------
+
+TesSetJob::TesSetJob(TESDriver* const* drivers, const uint8_t* channels, const float* targets,
+                     uint8_t count, uint16_t settleMs)
+    : _settleMs(settleMs), _awaitingRead(false), _done(false) {
+    if (count > TES_MAX_INTERLEAVED) count = TES_MAX_INTERLEAVED;
+    _search.begin(drivers, targets, count);
+    for (uint8_t i = 0; i < count; ++i) _channels[i] = channels[i];
+}
+
+JobState TesSetJob::step() {
+    if (_awaitingRead) {
+        _search.readRound();
+        _awaitingRead = false;
+    }
+    if (_search.writeRound()) {
+        _awaitingRead = true;
+        sleepFor(_search.needsSettle() ? _settleMs : 0);
+        return JOB_RUNNING;
+    }
+    _done = true;
+    return JOB_DONE;
+}
+
+void TesSetJob::printResult(Stream& out, uint8_t indent) {
+    if (!_done) return; // Patterns are still moving
+    printYAMLSection(out, "channels", indent);
+    for (uint8_t i = 0; i < _search.get_count(); ++i) {
+        LineBuffer line(out);
+        printIndent(line, indent + 2);
+        line.print("- {channel: ");
+        printInt(line, _channels[i]);
+        if (_search.get_status(i)) {
+            line.print(", error: \"TES_SET_CURRENT_ERROR\", code: ");
+            printInt(line, _search.get_status(i));
+        } else {
+            line.print(", current_mA: ");
+            printFixed(line, _search.get_measured(i), 4);
+            line.print(", tca_bits: \"0x");
+            printHex(line, _search.get_state(i), 5);
+            line.print("\", method: ");
+            TesSetMethod method = _search.get_method(i);
+            line.print(method == TES_SET_MODEL ? "\"model\"" : (method == TES_SET_MODEL_FALLBACK ? "\"model_fallback\"" : "\"search\""));
+        }
+        line.println("}");
+    }
+}
+
+// --- LnaSetJob ---------------------------------------------------------------
+
+LnaSetJob::LnaSetJob(LNADriver* driver, uint8_t channel, LnaSide side, bool voltage, float target,
+                     LnaSearchMode mode, uint16_t settleMs)
+    : _driver(driver), _channel(channel), _side(side), _voltage(voltage), _target(target),
+      _mode(mode), _settleMs(settleMs), _awaitingRead(false), _settling(false), _dacValue(0), _result(0.0f) {
+    _search.begin(target, voltage, mode);
+}
+
+JobState LnaSetJob::step() {
+    if (_awaitingRead) {
+        float progress;
+        uint8_t status = _driver->readSearchProgress(_side, _voltage, progress);
+        if (status) return fail(status);
+        _awaitingRead = false;
+        if (_settling) {
+            _result = (_side == LNA_GATE) ? -progress : progress; // Gate current and voltage are negative
+            return JOB_DONE;
+        }
+        _search.feed(progress);
+    }
+
+    // Probe the next code, or settle on the result once the search is over
+    uint16_t code;
+    if (!_search.next(code)) {
+        code = _dacValue = _search.get_result();
+        _settling = true;
+    }
+    uint8_t status = _driver->writeSearchCode(_side, code);
+    if (status) return fail(status);
+    _awaitingRead = true;
+    sleepFor(_driver->get_inaProfile(_side) == INA219_PROFILE_FAST ? 0 : _settleMs);
+    return JOB_RUNNING;
+}
+
+void LnaSetJob::printResult(Stream& out, uint8_t indent) {
+    printYAMLInt(out, "channel", _channel, indent);
+    printYAMLString(out, "target", _side == LNA_GATE ? "GATE" : "DRAIN", indent);
+    printYAMLInt(out, "iterations", _search.get_iterations() + (_settling ? 1 : 0), indent);
+    if (!_settling || _awaitingRead) return; // No result yet
+    printYAMLFloat(out, _voltage ? "voltage_V" : "current_mA", _result, 4, indent);
+    printYAMLInt(out, "dac_value", _dacValue, indent);
+    printYAMLString(out, "search", _mode == LNA_SEARCH_LINEAR ? "linear" : (_search.get_fellBack() ? "linear_fallback" : "bracket"), indent);
+}
@@ -0,0 +1,53 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <Arduino.h>
+#include "Job.h"
+#include "../devices/TESDriver.h"
+#include "../devices/LNADriver.h"
+
+// TES SET on one or more channels, as TESDriver::setCurrents_mA() does it
+class TesSetJob : public Job {
+public:
+    // channels are the 1-based numbers reported back, one per driver
+    TesSetJob(TESDriver* const* drivers, const uint8_t* channels, const float* targets,
+              uint8_t count, uint16_t settleMs = 10);
+    const char* get_kind() override { return "TES_SET"; }
+    JobState step() override;
+    bool uses(const void* device) override { return _search.uses((const TESDriver*)device); }
+    void printResult(Stream& out, uint8_t indent) override;
+
+private:
+    TesCurrentSearch _search;
+    uint8_t _channels[TES_MAX_INTERLEAVED];
+    uint16_t _settleMs;
+    bool _awaitingRead;
+    bool _done;
+};
+
+// LNA SETMA/SETV, one probe per step
+class LnaSetJob : public Job {
+public:
+    LnaSetJob(LNADriver* driver, uint8_t channel, LnaSide side, bool voltage, float target,
+              LnaSearchMode mode = LNA_SEARCH_BRACKET, uint16_t settleMs = 10);
+    const char* get_kind() override { return "LNA_SET"; }
+    JobState step() override;
+    bool uses(const void* device) override { return device == _driver; }
+    void printResult(Stream& out, uint8_t indent) override;
+
+private:
+    LNADriver* _driver;
+    uint8_t _channel;
+    LnaSide _side;
+    bool _voltage;
+    float _target;
+    LnaSearchMode _mode;
+    uint16_t _settleMs;
+    LnaDacSearch _search;
+    bool _awaitingRead;
+    bool _settling;      // The final code is written; its reading is the result
+    uint16_t _dacValue;
+    float _result;
+};
+
+#endif // JOBS_H
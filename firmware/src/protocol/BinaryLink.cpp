@@ -0,0 +1,145 @@
+#include "BinaryLink.h"
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+size_t cobsEncode(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t codePos = 0;
+    size_t pos = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; ++i) {
+        if (in[i] == 0) {
+            out[codePos] = code;
+            codePos = pos++;
+            code = 1;
+            continue;
+        }
+        out[pos++] = in[i];
+        if (++code == 0xFF) {
+            out[codePos] = code;
+            codePos = pos++;
+            code = 1;
+        }
+    }
+    out[codePos] = code;
+    return pos;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t length, uint8_t* out) {
+    size_t pos = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; ++k) {
+            out[pos++] = in[i++];
+        }
+        // A full block (0xFF) carries no implied zero, nor does the last block
+        if (code != 0xFF && i < length) {
+            out[pos++] = 0;
+        }
+    }
+    return pos;
+}
+
+uint8_t BinaryReader::u8() {
+    if (_pos >= _length) {
+        _overrun = true;
+        return 0;
+    }
+    return _data[_pos++];
+}
+
+uint16_t BinaryReader::u16() {
+    uint16_t lo = u8();
+    return lo | ((uint16_t)u8() << 8);
+}
+
+uint32_t BinaryReader::u32() {
+    uint32_t lo = u16();
+    return lo | ((uint32_t)u16() << 16);
+}
+
+void BinaryWriter::u8(uint8_t value) {
+    if (_length < BIN_MAX_PAYLOAD) {
+        _data[_length++] = value;
+    }
+}
+
+void BinaryWriter::u16(uint16_t value) {
+    u8(value & 0xFF);
+    u8(value >> 8);
+}
+
+void BinaryWriter::u32(uint32_t value) {
+    u16(value & 0xFFFF);
+    u16(value >> 16);
+}
+
+bool BinaryLink::poll(uint8_t& opcode, uint8_t& seq, BinaryReader& payload) {
+    while (_stream.available() > 0) {
+        uint8_t c = _stream.read();
+        if (c != 0) {
+            if (_rxLength < sizeof(_rx)) {
+                _rx[_rxLength++] = c;
+            } else {
+                _rxOverflow = true;
+            }
+            continue;
+        }
+
+        // Delimiter: decode what came before it
+        size_t length = 0;
+        if (!_rxOverflow && _rxLength > 0) {
+            // Decoding never grows the data, so a frame that fits _rx but not
+            // _frame is rejected before it is written
+            length = (_rxLength - 1 <= BIN_MAX_FRAME) ? cobsDecode(_rx, _rxLength, _frame) : 0;
+        }
+        bool empty = _rxLength == 0 && !_rxOverflow;
+        reset();
+        if (empty) {
+            continue; // Back-to-back delimiters, e.g. a host flushing the line
+        }
+        // A request holds at least opcode, seq and the CRC
+        if (length < 4 || crc16Ccitt(_frame, length - 2) != (_frame[length - 2] | ((uint16_t)_frame[length - 1] << 8))) {
+            BinaryWriter none;
+            send(0, 0, BIN_ERR_BAD_FRAME, none);
+            continue;
+        }
+        opcode = _frame[0];
+        seq = _frame[1];
+        payload = BinaryReader(_frame + 2, length - 4);
+        return true;
+    }
+    return false;
+}
+
+void BinaryLink::send(uint8_t opcode, uint8_t seq, uint8_t status, BinaryWriter& payload) {
+    uint8_t frame[BIN_MAX_FRAME];
+    uint8_t length = 0;
+    frame[length++] = opcode;
+    frame[length++] = seq;
+    frame[length++] = status;
+    if (!status) {
+        memcpy(frame + length, payload.get_data(), payload.get_length());
+        length += payload.get_length();
+    }
+    uint16_t crc = crc16Ccitt(frame, length);
+    frame[length++] = crc & 0xFF;
+    frame[length++] = crc >> 8;
+
+    uint8_t encoded[BIN_MAX_ENCODED];
+    size_t n = cobsEncode(frame, length, encoded);
+    encoded[n++] = 0;
+    _stream.write(encoded, n); // One write, so a response is never interleaved
+}
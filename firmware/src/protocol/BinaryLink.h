@@ -0,0 +1,106 @@
+#ifndef BINARY_LINK_H
+#define BINARY_LINK_H
+
+#include <Arduino.h>
+
+// Compact framed alternative to the YAML responses, entered with the BINARY
+// command. Each frame is COBS-encoded and ends in a 0x00 byte, so a receiver
+// resynchronises at the next zero after any corruption. Decoded, a frame is
+//
+//   request:  opcode, seq, payload..., crc16
+//   response: opcode, seq, status, payload..., crc16
+//
+// Multi-byte fields are little-endian. The CRC is CRC-16/CCITT-FALSE over
+// everything before it. Responses echo the request's opcode and seq; status
+// is 0 or an error code, and an error response carries no payload.
+//
+// Physical quantities are fixed-point integers: int32 microvolts, microamps
+// and microwatts.
+
+#define BIN_PROTOCOL_VERSION 1
+#define BIN_MAX_PAYLOAD 40                        // Largest request or response payload
+#define BIN_MAX_FRAME (BIN_MAX_PAYLOAD + 5)       // opcode, seq, status, payload, crc16
+#define BIN_MAX_ENCODED (BIN_MAX_FRAME + BIN_MAX_FRAME / 254 + 2) // COBS overhead and the delimiter
+
+#define BIN_ERR_UNKNOWN_OPCODE 40   // No handler for the opcode
+#define BIN_ERR_BAD_LENGTH 41       // Payload shorter or longer than the opcode expects
+#define BIN_ERR_BAD_FRAME 42        // CRC mismatch, bad COBS, or frame too long; sent with opcode and seq 0
+#define BIN_ERR_CHANNEL_BUSY 43     // A running job drives the channel (CHANNEL_BUSY in text mode)
+
+// Opcodes. TES and LNA requests start with the 1-based channel; LNA requests
+// then give the side, 0 drain or 1 gate.
+#define BIN_OP_PING         0x01    // -> u8 protocol version
+#define BIN_OP_TEXT         0x02    // Back to YAML once the response is sent
+#define BIN_OP_TES_GET      0x10    // ch -> u8 enabled, u32 bits, i32 shunt_uV, bus_uV, current_uA, power_uW, u32 timestamp_us, duration_us
+#define BIN_OP_TES_SET      0x11    // ch, i32 target_uA -> i32 current_uA, u32 bits, u8 method, u32 elapsed_ms
+#define BIN_OP_TES_SETBITS  0x12    // ch, u32 bits -> u32 bits
+#define BIN_OP_TES_BITS     0x13    // ch -> u32 bits
+#define BIN_OP_TES_CURRENT  0x14    // ch -> i32 current_uA
+#define BIN_OP_TES_ENABLE   0x15    // ch, u8 enabled -> u8 enabled
+#define BIN_OP_LNA_GET      0x20    // ch, side -> u8 enabled, u16 dac, i32 shunt_uV, bus_uV, current_uA, power_uW, u32 timestamp_us, duration_us
+#define BIN_OP_LNA_SETMA    0x21    // ch, side, i32 target_uA -> i32 current_uA, u16 dac, u16 iterations, u32 elapsed_ms
+#define BIN_OP_LNA_SETV     0x22    // ch, side, i32 target_uV -> i32 voltage_uV, u16 dac, u16 iterations, u32 elapsed_ms
+#define BIN_OP_LNA_SETDAC   0x23    // ch, side, u16 dac -> u16 dac
+#define BIN_OP_LNA_CURRENT  0x24    // ch, side -> i32 current_uA
+#define BIN_OP_LNA_ENABLE   0x25    // ch, side, u8 enabled -> u8 enabled
+#define BIN_OP_DAC_SET      0x30    // u16 value -> u16 value
+#define BIN_OP_DAC_GET      0x31    // -> u16 value
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t length);
+size_t cobsEncode(const uint8_t* in, size_t length, uint8_t* out);  // Returns the encoded length, without the delimiter
+size_t cobsDecode(const uint8_t* in, size_t length, uint8_t* out);  // Returns the decoded length, or 0 if malformed
+
+// Reads a request payload front to back. Reading past the end yields zeros
+// and makes done() false, as does leaving bytes unread.
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* data, uint8_t length) : _data(data), _length(length), _pos(0), _overrun(false) {}
+    uint8_t u8();
+    uint16_t u16();
+    uint32_t u32();
+    int32_t i32() { return (int32_t)u32(); }
+    bool done() { return !_overrun && _pos == _length; }
+
+private:
+    const uint8_t* _data;
+    uint8_t _length;
+    uint8_t _pos;
+    bool _overrun;
+};
+
+// Builds a response payload. Writes beyond BIN_MAX_PAYLOAD are dropped.
+class BinaryWriter {
+public:
+    BinaryWriter() : _length(0) {}
+    void u8(uint8_t value);
+    void u16(uint16_t value);
+    void u32(uint32_t value);
+    void i32(int32_t value) { u32((uint32_t)value); }
+    void clear() { _length = 0; }
+    const uint8_t* get_data() { return _data; }
+    uint8_t get_length() { return _length; }
+
+private:
+    uint8_t _data[BIN_MAX_PAYLOAD];
+    uint8_t _length;
+};
+
+// Frame transport over a Stream. poll() collects bytes until a delimiter and
+// hands back each valid request; malformed frames are answered with
+// BIN_ERR_BAD_FRAME and dropped.
+class BinaryLink {
+public:
+    BinaryLink(Stream& stream) : _stream(stream), _rxLength(0), _rxOverflow(false) {}
+    bool poll(uint8_t& opcode, uint8_t& seq, BinaryReader& payload); // payload is valid until the next poll()
+    void send(uint8_t opcode, uint8_t seq, uint8_t status, BinaryWriter& payload);
+    void reset() { _rxLength = 0; _rxOverflow = false; }
+
+private:
+    Stream& _stream;
+    uint8_t _rx[BIN_MAX_ENCODED];
+    uint8_t _rxLength;
+    bool _rxOverflow;
+    uint8_t _frame[BIN_MAX_FRAME];
+};
+
+#endif // BINARY_LINK_H
@@ -0,0 +1,76 @@
+#include "RequestStream.h"
+
+RequestStream::RequestStream(Stream& port)
+    : _port(port), _head(0), _count(0), _idHead(0), _idCount(0),
+      _state(LINE_START), _parsingId(0), _readLineStart(true), _currentId(REQUEST_NO_ID) {}
+
+void RequestStream::push(uint8_t c) {
+    _buffer[(_head + _count) % REQUEST_RX_BUFFER_SIZE] = c;
+    _count++;
+}
+
+void RequestStream::startLine(int32_t id) {
+    _ids[(_idHead + _idCount) % REQUEST_MAX_LINES] = id;
+    _idCount++;
+    _state = LINE_TEXT;
+}
+
+void RequestStream::pump() {
+    while (_count < REQUEST_RX_BUFFER_SIZE && _port.available() > 0) {
+        if (_state == LINE_START && _idCount == REQUEST_MAX_LINES) {
+            break; // Leave further lines in the port until a queued one is read
+        }
+        int c = _port.read();
+        if (c < 0) break;
+        switch (_state) {
+            case LINE_START:
+                if (c == '@') {
+                    _state = PREFIX_ID;
+                    _parsingId = 0;
+                    continue;
+                }
+                startLine(REQUEST_NO_ID);
+                break;
+            case PREFIX_ID:
+                if (c >= '0' && c <= '9' && _parsingId < 100000000) {
+                    _parsingId = _parsingId * 10 + (c - '0');
+                    continue;
+                }
+                // "@<id> " ends at the space; anything else leaves the line unidentified
+                startLine(c == ' ' ? _parsingId : REQUEST_NO_ID);
+                if (c == ' ') continue;
+                break;
+            default:
+                break;
+        }
+        push((uint8_t)c);
+        if (c == '\n') _state = LINE_START;
+    }
+}
+
+int RequestStream::available() {
+    pump();
+    return _count;
+}
+
+int RequestStream::peek() {
+    pump();
+    return _count ? _buffer[_head] : -1;
+}
+
+int RequestStream::read() {
+    pump();
+    if (!_count) {
+        return -1;
+    }
+    uint8_t c = _buffer[_head];
+    _head = (_head + 1) % REQUEST_RX_BUFFER_SIZE;
+    _count--;
+    if (_readLineStart && _idCount) {
+        _currentId = _ids[_idHead];
+        _idHead = (_idHead + 1) % REQUEST_MAX_LINES;
+        _idCount--;
+    }
+    _readLineStart = c == '\n';
+    return c;
+}
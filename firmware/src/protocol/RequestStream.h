@@ -0,0 +1,57 @@
+#ifndef REQUEST_STREAM_H
+#define REQUEST_STREAM_H
+
+#include <Arduino.h>
+
+// Input queue in front of the serial port for the text commands. A line may
+// start with "@<id> "; the prefix is removed before the command parser sees
+// the line, and get_requestId() returns the id while that line's command
+// runs, so responses can echo it. This lets a host keep several commands in
+// flight and match each response to its request.
+//
+// Bytes are moved from the port into the queue by pump(), which runs on
+// every read and may also be called while a command blocks, so a pipelined
+// host does not overrun the port's own (often 64-byte) receive buffer.
+
+#ifndef REQUEST_RX_BUFFER_SIZE
+#define REQUEST_RX_BUFFER_SIZE 512  // Queued command bytes
+#endif
+#define REQUEST_MAX_LINES 32        // Queued line starts (ids) at once
+#define REQUEST_NO_ID -1
+
+class RequestStream : public Stream {
+public:
+    explicit RequestStream(Stream& port);
+
+    void pump();                                    // Move waiting port bytes into the queue
+    int32_t get_requestId() { return _currentId; }  // Id of the line being read, or REQUEST_NO_ID
+    uint16_t get_queued() { return _count; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override { return _port.write(c); }
+    size_t write(const uint8_t* buffer, size_t size) override { return _port.write(buffer, size); }
+    using Print::write;
+
+private:
+    enum PrefixState : uint8_t { LINE_START, PREFIX_ID, LINE_TEXT };
+
+    Stream& _port;
+    uint8_t _buffer[REQUEST_RX_BUFFER_SIZE];
+    uint16_t _head;
+    uint16_t _count;
+    int32_t _ids[REQUEST_MAX_LINES];  // One per queued line, in order
+    uint8_t _idHead;
+    uint8_t _idCount;
+
+    PrefixState _state;     // Of the incoming side
+    int32_t _parsingId;
+    bool _readLineStart;    // The next read() begins a line
+    int32_t _currentId;
+
+    void push(uint8_t c);
+    void startLine(int32_t id);
+};
+
+#endif // REQUEST_STREAM_H
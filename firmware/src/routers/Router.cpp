@@ -1,6 +1,13 @@
 #include "Router.h"
 
-Router::Router(LTC4302* baseHub) : _baseHub(baseHub) {}
+Router::Router(LTC4302* baseHub)
+    : _baseHub(baseHub),
+      _openDepth(0),
+      _sticky(true),
+      _idleTimeoutMs(ROUTER_DEFAULT_IDLE_TIMEOUT_MS),
+      _lastUseMs(0),
+      _requestedOps(0),
+      _issuedOps(0) {}
 
 uint8_t Router::begin() {
     // The base hub should already be initialized in setup, but we can ensure it here.
@@ -8,12 +15,30 @@ uint8_t Router::begin() {
 }
 
 uint8_t Router::routeTo(I2CRoute* route) {
-    I2CRoute* current = route;
-    while (current != nullptr) {
-        if (current->hub != nullptr) {
-            RETURN_IF_ERROR(current->hub->enableBus()); // Enable the bus for the current hub
-        }
-        current = current->next;
+    // Flatten the requested route into its hubs, upstream first
+    LTC4302* hubs[ROUTER_MAX_DEPTH];
+    uint8_t depth = 0;
+    for (I2CRoute* current = route; current != nullptr; current = current->next) {
+        if (current->hub == nullptr) continue;
+        if (depth >= ROUTER_MAX_DEPTH) return ROUTER_ERR_ROUTE_TOO_DEEP;
+        hubs[depth++] = current->hub;
+    }
+    _requestedOps += depth;
+    _lastUseMs = millis();
+
+    // Keep the prefix shared with the open route, close the rest of it
+    uint8_t shared = 0;
+    while (shared < depth && shared < _openDepth && _openHubs[shared] == hubs[shared]) {
+        shared++;
+    }
+    RETURN_IF_ERROR(closeTo(shared));
+
+    // Enable the remaining hubs of the new route
+    for (uint8_t i = shared; i < depth; ++i) {
+        _issuedOps++;
+        RETURN_IF_ERROR(hubs[i]->enableBus()); // Enable the bus for the current hub
+        _openHubs[i] = hubs[i];
+        _openDepth = i + 1;
     }
     return 0;
 }
@@ -64,13 +89,37 @@ void Router::scanDevicesAtEndpoint(I2CRoute* route) {
 }
 
 uint8_t Router::endRoute(I2CRoute* route) {
-    if (route == nullptr) return;
+    for (I2CRoute* current = route; current != nullptr; current = current->next) {
+        if (current->hub != nullptr) _requestedOps++;
+    }
+    _lastUseMs = millis();
+
+    // Sticky routes stay open until another route, flush() or the idle timeout
+    if (_sticky) return 0;
+    return flush();
+}
+
+uint8_t Router::flush() {
+    return closeTo(0);
+}
+
+void Router::invalidate() {
+    _openDepth = 0;
+}
+
+uint8_t Router::service() {
+    if (_openDepth == 0 || _idleTimeoutMs == 0) return 0;
+    if ((uint32_t)(millis() - _lastUseMs) < _idleTimeoutMs) return 0;
+    return flush();
+}
 
-    // Recurse to the end of the chain first
-    endRoute(route->next);
-    // Then disable this hub on the way back
-    if (route->hub != nullptr) {
-        RETURN_IF_ERROR(route->hub->disableBus());
+uint8_t Router::closeTo(uint8_t depth) {
+    while (_openDepth > depth) {
+        // Drop the hub from the cache even if the write fails; an unreachable
+        // hub cannot be disabled later either.
+        LTC4302* hub = _openHubs[--_openDepth];
+        _issuedOps++;
+        RETURN_IF_ERROR(hub->disableBus());
     }
     return 0;
 }
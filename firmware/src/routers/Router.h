@@ -5,12 +5,23 @@
 #include "../drivers/LTC4302.h"
 #include "../helpers/error.h"
 
+#define ROUTER_MAX_DEPTH 4                   // Maximum number of hubs in one I2CRoute
+#define ROUTER_DEFAULT_IDLE_TIMEOUT_MS 1000  // Close a sticky route after this long unused (0 = never)
+#define ROUTER_ERR_ROUTE_TOO_DEEP 20         // Route has more than ROUTER_MAX_DEPTH hubs
+#define ROUTER_ERR_ABSENT 23                 // The card's hub did not answer at boot or the last topology scan
+
 // Define a structure to represent a route to a device
 struct I2CRoute {
     LTC4302* hub;       // Pointer to the LTC4302 hub at this level
     I2CRoute* next;     // Pointer to the next hop in the route (for cascaded hubs)
 };
 
+// The router caches the chain of hubs it last enabled. In sticky mode (the
+// default) endRoute() leaves that chain open, and the next routeTo() only
+// tears down and enables the hubs that differ from it, so back-to-back
+// accesses to the same card cost no hub traffic at all. The open route is
+// closed by flush(), by the idle timeout in service(), or by switching to
+// another route.
 class Router {
 public:
     Router(LTC4302* baseHub);
@@ -19,8 +30,33 @@ public:
     uint8_t endRoute(I2CRoute* route);
     void scanDevicesAtEndpoint(I2CRoute* route); // New method to scan devices at the endpoint of a route
     LTC4302* get_baseHub() { return _baseHub; }
+
+    // Route cache control
+    uint8_t flush();      // Disable every hub on the open route
+    void invalidate();    // Forget the open route without touching the bus (e.g. after a hub reset)
+    void setSticky(bool sticky) { _sticky = sticky; }
+    bool get_sticky() { return _sticky; }
+    void setIdleTimeout(uint32_t timeoutMs) { _idleTimeoutMs = timeoutMs; }
+    uint8_t service();    // Call from loop(); flushes a route idle for longer than the timeout
+
+    // Hub enable/disable operations requested by callers but not issued on the bus
+    uint32_t get_avoidedTransactions() { return _requestedOps > _issuedOps ? _requestedOps - _issuedOps : 0; }
+    uint32_t get_issuedTransactions() { return _issuedOps; }
+    void resetTransactionCounters() { _requestedOps = 0; _issuedOps = 0; }
+
 private:
     LTC4302* _baseHub;
+
+    LTC4302* _openHubs[ROUTER_MAX_DEPTH]; // Hubs currently enabled, upstream first
+    uint8_t _openDepth;
+    bool _sticky;
+    uint32_t _idleTimeoutMs;
+    uint32_t _lastUseMs;
+
+    uint32_t _requestedOps;
+    uint32_t _issuedOps;
+
+    uint8_t closeTo(uint8_t depth); // Disable open hubs deeper than `depth`, deepest first
 };
 
 #endif // ROUTER_H
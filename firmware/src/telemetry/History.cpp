@@ -0,0 +1,126 @@
+#include "History.h"
+
+#if HISTORY_SAMPLE_MS < 100
+#error "HISTORY_SAMPLE_MS below 100 ms can overflow the hourly sums"
+#endif
+
+static void clearAccumulator(HistoryAccumulator& acc) {
+    acc.sum = 0;
+    acc.count = 0;
+    acc.min = INT16_MAX;
+    acc.max = INT16_MIN;
+}
+
+// Micro-units to stored int16 steps, saturating
+static int16_t toStored(int32_t value) {
+    int32_t v = (value >= 0 ? value + HISTORY_UNIT_UA / 2 : value - HISTORY_UNIT_UA / 2) / HISTORY_UNIT_UA;
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+History::History()
+    : _seriesCount(0), _next(0), _nextReadMs(0), _secondEndMs(1000), _seconds(0), _readErrors(0) {
+    for (uint8_t l = 0; l < HISTORY_LEVELS; ++l) {
+        _head[l] = 0;
+        _filled[l] = 0;
+    }
+    for (uint8_t s = 0; s < HISTORY_MAX_SERIES; ++s) {
+        for (uint8_t l = 0; l < HISTORY_LEVELS; ++l) clearAccumulator(_open[s][l]);
+    }
+}
+
+uint8_t History::addSeries(SampleKind kind, uint8_t channel, void* driver) {
+    if (_seriesCount >= HISTORY_MAX_SERIES || !driver) {
+        return 10; // invalid argument
+    }
+    _series[_seriesCount].kind = kind;
+    _series[_seriesCount].channel = channel;
+    _series[_seriesCount].driver = driver;
+    _seriesCount++;
+    return 0;
+}
+
+int8_t History::find(SampleKind kind, uint8_t channel) {
+    for (uint8_t i = 0; i < _seriesCount; ++i) {
+        if (_series[i].kind == kind && _series[i].channel == channel) return i;
+    }
+    return -1;
+}
+
+uint32_t History::get_resolution_s(uint8_t level) {
+    return level == 0 ? 1 : (level == 1 ? 60 : 3600);
+}
+
+uint8_t History::capacity(uint8_t level) {
+    return level == 0 ? HISTORY_SECOND_BUCKETS : (level == 1 ? HISTORY_MINUTE_BUCKETS : HISTORY_HOUR_BUCKETS);
+}
+
+HistoryBucket* History::level(uint8_t series, uint8_t level) {
+    return level == 0 ? _secondBuckets[series] : (level == 1 ? _minuteBuckets[series] : _hourBuckets[series]);
+}
+
+HistoryBucket History::get_bucket(uint8_t series, uint8_t lvl, uint8_t i) {
+    uint8_t cap = capacity(lvl);
+    return level(series, lvl)[(_head[lvl] + cap - _filled[lvl] + i) % cap];
+}
+
+void History::service() {
+    uint32_t now = millis();
+
+    // Close every second boundary passed since the last call. After a stall
+    // (a blocking command) the missed seconds close as empty buckets.
+    while ((int32_t)(now - _secondEndMs) >= 0) {
+        closeSecond();
+        _secondEndMs += 1000;
+    }
+
+    if (!_seriesCount || (int32_t)(now - _nextReadMs) < 0) {
+        return;
+    }
+    uint32_t step = HISTORY_SAMPLE_MS / _seriesCount;
+    _nextReadMs += step ? step : 1;
+    if ((int32_t)(now - _nextReadMs) > HISTORY_SAMPLE_MS) {
+        _nextReadMs = now; // Fell behind; restart the schedule
+    }
+
+    int32_t value;
+    if (readSampleSource(_series[_next], value)) {
+        _readErrors++;
+    } else {
+        HistoryAccumulator& acc = _open[_next][0];
+        int16_t v = toStored(value);
+        acc.sum += v;
+        acc.count++;
+        if (v < acc.min) acc.min = v;
+        if (v > acc.max) acc.max = v;
+    }
+    _next = (_next + 1) % _seriesCount;
+}
+
+void History::closeSecond() {
+    close(0);
+    _seconds++;
+    if (_seconds % 60 == 0) close(1);
+    if (_seconds % 3600 == 0) close(2);
+}
+
+void History::close(uint8_t lvl) {
+    for (uint8_t s = 0; s < _seriesCount; ++s) {
+        HistoryAccumulator& acc = _open[s][lvl];
+        HistoryBucket& bucket = level(s, lvl)[_head[lvl]];
+        bucket.min = acc.min;
+        bucket.max = acc.max;
+        bucket.mean = acc.count ? (int16_t)lroundf((float)acc.sum / acc.count) : 0;
+        if (lvl + 1 < HISTORY_LEVELS && acc.count) {
+            HistoryAccumulator& up = _open[s][lvl + 1];
+            up.sum += acc.sum;
+            up.count += acc.count;
+            if (acc.min < up.min) up.min = acc.min;
+            if (acc.max > up.max) up.max = acc.max;
+        }
+        clearAccumulator(acc);
+    }
+    _head[lvl] = (_head[lvl] + 1) % capacity(lvl);
+    if (_filled[lvl] < capacity(lvl)) _filled[lvl]++;
+}
@@ -0,0 +1,111 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "Sampler.h"
+
+// Bucket counts per resolution, and with them the RAM budget: each bucket
+// is 6 bytes per series. The defaults take 16 x 144 x 6 = 13.8 kB plus
+// 480 bytes of running aggregates. On AVR, whose SRAM cannot hold that,
+// they shrink to 16 x 20 x 6 = 1.9 kB: the last 10 s, 6 min and 4 h.
+// sizeof(History) is checked against HISTORY_RAM_BUDGET at compile time;
+// override the counts or the budget before this header for another part.
+#ifndef HISTORY_MAX_SERIES
+#define HISTORY_MAX_SERIES 16
+#endif
+#if defined(__AVR__)
+#ifndef HISTORY_SECOND_BUCKETS
+#define HISTORY_SECOND_BUCKETS 10
+#endif
+#ifndef HISTORY_MINUTE_BUCKETS
+#define HISTORY_MINUTE_BUCKETS 6
+#endif
+#ifndef HISTORY_HOUR_BUCKETS
+#define HISTORY_HOUR_BUCKETS 4
+#endif
+#ifndef HISTORY_RAM_BUDGET
+#define HISTORY_RAM_BUDGET ((RAMEND - RAMSTART + 1) / 3) // Leaves two thirds of SRAM to the rest
+#endif
+#endif
+#ifndef HISTORY_SECOND_BUCKETS
+#define HISTORY_SECOND_BUCKETS 60   // 1 s buckets: the last minute
+#endif
+#ifndef HISTORY_MINUTE_BUCKETS
+#define HISTORY_MINUTE_BUCKETS 60   // 1 min buckets: the last hour
+#endif
+#ifndef HISTORY_HOUR_BUCKETS
+#define HISTORY_HOUR_BUCKETS 24     // 1 h buckets: the last day
+#endif
+#ifndef HISTORY_RAM_BUDGET
+#define HISTORY_RAM_BUDGET 16384
+#endif
+#ifndef HISTORY_SAMPLE_MS
+#define HISTORY_SAMPLE_MS 250       // Each series is read this often
+#endif
+
+#define HISTORY_LEVELS 3
+#define HISTORY_UNIT_UA 2           // Stored values are int16 in 2 uA (or uV) steps: +/-65 mA
+
+// min > max marks a bucket with no readings (e.g. while a blocking command ran)
+struct HistoryBucket {
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+};
+
+// Running aggregate of the bucket still being filled at one resolution
+struct HistoryAccumulator {
+    int32_t sum;        // Of the raw readings, so every level's mean is exact
+    uint16_t count;
+    int16_t min;
+    int16_t max;
+};
+
+// Multi-resolution min/max/mean history of a set of sources. service()
+// reads one series per call, spreading HISTORY_SAMPLE_MS over the series,
+// and folds the reading into the open 1 s bucket. At each second boundary
+// the 1 s buckets close into their rings and into the open 1 min bucket,
+// which closes the same way into the 1 h level.
+class History {
+public:
+    History();
+    uint8_t addSeries(SampleKind kind, uint8_t channel, void* driver); // 10 if full
+    void service();     // Call from loop()
+
+    uint8_t get_seriesCount() { return _seriesCount; }
+    const SampleSource& get_series(uint8_t i) { return _series[i]; }
+    int8_t find(SampleKind kind, uint8_t channel);  // Series index, or -1
+
+    // Buckets of one level (0 = seconds, 1 = minutes, 2 = hours), oldest first
+    static uint32_t get_resolution_s(uint8_t level);
+    uint8_t get_bucketCount(uint8_t level) { return _filled[level]; }
+    HistoryBucket get_bucket(uint8_t series, uint8_t level, uint8_t i);
+    uint32_t get_seconds() { return _seconds; }  // Seconds closed since boot
+    uint32_t get_end_s(uint8_t level) { return _seconds - _seconds % get_resolution_s(level); } // Newest closed bucket's end
+    uint32_t get_readErrors() { return _readErrors; }
+
+private:
+    SampleSource _series[HISTORY_MAX_SERIES];
+    uint8_t _seriesCount;
+    uint8_t _next;              // Series read on the next service()
+    uint32_t _nextReadMs;
+    uint32_t _secondEndMs;      // millis() at which the open 1 s bucket closes
+    uint32_t _seconds;
+    uint32_t _readErrors;
+
+    HistoryBucket _secondBuckets[HISTORY_MAX_SERIES][HISTORY_SECOND_BUCKETS];
+    HistoryBucket _minuteBuckets[HISTORY_MAX_SERIES][HISTORY_MINUTE_BUCKETS];
+    HistoryBucket _hourBuckets[HISTORY_MAX_SERIES][HISTORY_HOUR_BUCKETS];
+    HistoryAccumulator _open[HISTORY_MAX_SERIES][HISTORY_LEVELS];
+    uint8_t _head[HISTORY_LEVELS];      // Next slot written, shared by all series
+    uint8_t _filled[HISTORY_LEVELS];
+
+    HistoryBucket* level(uint8_t series, uint8_t level);
+    static uint8_t capacity(uint8_t level);
+    void closeSecond();
+    void close(uint8_t level);
+};
+
+static_assert(sizeof(History) <= HISTORY_RAM_BUDGET, "History buckets exceed HISTORY_RAM_BUDGET; lower the HISTORY_*_BUCKETS counts");
+
+#endif // HISTORY_H
@@ -0,0 +1,138 @@
+#include "Sampler.h"
+#include "../helpers/YAMLWriter.h"
+
+// Readings travel as integer micro-units, like the binary protocol
+static int32_t toMicro(float milli) {
+    return (int32_t)lroundf(milli * 1000.0f);
+}
+
+Sampler::Sampler()
+    : _sourceCount(0), _period_ms(100), _nextMs(0), _running(false),
+      _taken(0), _dropped(0), _head(0), _count(0) {}
+
+void Sampler::clearSources() {
+    _sourceCount = 0;
+}
+
+uint8_t Sampler::addSource(SampleKind kind, uint8_t channel, void* driver) {
+    if (_sourceCount >= SAMPLER_MAX_SOURCES || !driver) {
+        return 10; // invalid argument
+    }
+    _sources[_sourceCount].kind = kind;
+    _sources[_sourceCount].channel = channel;
+    _sources[_sourceCount].driver = driver;
+    _sourceCount++;
+    return 0;
+}
+
+uint8_t Sampler::setPeriod_ms(uint32_t period_ms) {
+    if (period_ms < SAMPLER_MIN_PERIOD_MS || period_ms > SAMPLER_MAX_PERIOD_MS) {
+        return 10; // invalid argument
+    }
+    _period_ms = period_ms;
+    return 0;
+}
+
+void Sampler::start() {
+    _taken = 0;
+    _dropped = 0;
+    _head = 0;
+    _count = 0;
+    _nextMs = millis();
+    _running = _sourceCount > 0;
+}
+
+void Sampler::service() {
+    if (!_running || (int32_t)(millis() - _nextMs) < 0) {
+        return;
+    }
+    // Keep to the fixed grid; after a stall (a blocking command) restart it
+    // rather than firing a burst of catch-up rows
+    _nextMs += _period_ms;
+    if ((int32_t)(millis() - _nextMs) >= 0) {
+        _nextMs = millis() + _period_ms;
+    }
+
+    if (_count == SAMPLER_RING_SIZE) {
+        _count--;
+        _dropped++;
+    }
+    SampleRow& row = _ring[_head];
+    _head = (_head + 1) % SAMPLER_RING_SIZE;
+    _count++;
+
+    row.seq = _taken++;
+    row.timestamp_us = micros();
+    row.failed = 0;
+    for (uint8_t i = 0; i < _sourceCount; ++i) {
+        if (readSampleSource(_sources[i], row.values[i])) {
+            row.values[i] = 0;
+            row.failed |= 1 << i;
+        }
+    }
+}
+
+bool Sampler::pop(SampleRow& row) {
+    if (_count == 0) {
+        return false;
+    }
+    uint8_t tail = (_head + SAMPLER_RING_SIZE - _count) % SAMPLER_RING_SIZE;
+    row = _ring[tail];
+    _count--;
+    return true;
+}
+
+uint8_t readSampleSource(const SampleSource& source, int32_t& value) {
+    float reading;
+    uint8_t status;
+    switch (source.kind) {
+        case SAMPLE_TES_CURRENT:
+            status = ((TESDriver*)source.driver)->getCurrent_mA(reading);
+            break;
+        case SAMPLE_LNA_DRAIN_CURRENT:
+            status = ((LNADriver*)source.driver)->getDrainCurrent_mA(reading);
+            break;
+        case SAMPLE_LNA_GATE_CURRENT:
+            status = ((LNADriver*)source.driver)->getGateCurrent_mA(reading);
+            break;
+        case SAMPLE_LNA_DRAIN_VOLTAGE:
+            status = ((LNADriver*)source.driver)->getDrainBusVoltage_V(reading);
+            reading *= 1000.0f;
+            break;
+        case SAMPLE_LNA_GATE_VOLTAGE:
+            status = ((LNADriver*)source.driver)->getGateBusVoltage_V(reading);
+            reading *= 1000.0f;
+            break;
+        default:
+            return 10;
+    }
+    RETURN_IF_ERROR(status);
+    value = toMicro(reading);
+    return 0;
+}
+
+void Sampler::printRow(Stream& out, const SampleRow& row, uint8_t sourceCount) {
+    LineBuffer line(out);
+    line.print("#STREAM ");
+    printInt(line, row.seq);
+    line.print(',');
+    printInt(line, row.timestamp_us);
+    for (uint8_t i = 0; i < sourceCount; ++i) {
+        line.print(',');
+        if (!(row.failed & (1 << i))) {
+            printInt(line, row.values[i]);
+        }
+    }
+    line.println();
+}
+
+const char* sampleKindName(SampleKind kind) {
+    switch (kind) {
+        case SAMPLE_TES_CURRENT: return "tes_current_uA";
+        case SAMPLE_LNA_DRAIN_CURRENT: return "drain_current_uA";
+        case SAMPLE_LNA_GATE_CURRENT: return "gate_current_uA";
+        case SAMPLE_LNA_DRAIN_VOLTAGE: return "drain_voltage_uV";
+        case SAMPLE_LNA_GATE_VOLTAGE: return "gate_voltage_uV";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <Arduino.h>
+#include "../devices/TESDriver.h"
+#include "../devices/LNADriver.h"
+
+#define SAMPLER_MAX_SOURCES 8       // Readings per row
+#define SAMPLER_RING_SIZE 16        // Rows buffered between sampling and output
+#define SAMPLER_MIN_PERIOD_MS 1
+#define SAMPLER_MAX_PERIOD_MS 60000
+
+enum SampleKind {
+    SAMPLE_TES_CURRENT,         // uA
+    SAMPLE_LNA_DRAIN_CURRENT,   // uA
+    SAMPLE_LNA_GATE_CURRENT,    // uA
+    SAMPLE_LNA_DRAIN_VOLTAGE,   // uV, bus voltage
+    SAMPLE_LNA_GATE_VOLTAGE     // uV, bus voltage with the gate sign flip
+};
+
+struct SampleSource {
+    SampleKind kind;
+    uint8_t channel;    // 1-based, as reported
+    void* driver;       // TESDriver or LNADriver, by kind
+};
+
+// One reading of every source, taken back to back
+struct SampleRow {
+    uint32_t seq;               // Rows taken since start(); a gap means rows were dropped
+    uint32_t timestamp_us;      // micros() before the first read
+    int32_t values[SAMPLER_MAX_SOURCES];
+    uint8_t failed;             // Bit i set: source i could not be read (values[i] is 0)
+};
+
+// Reads a configurable set of INA219 quantities at a fixed period from
+// loop(), into a ring buffer that the output side drains at its own pace.
+// When the ring is full the oldest row is overwritten and counted as
+// dropped. Each read goes through the driver wrappers, so it routes to its
+// own card and may interleave with jobs.
+class Sampler {
+public:
+    Sampler();
+    void clearSources();
+    uint8_t addSource(SampleKind kind, uint8_t channel, void* driver); // 10 if the list is full
+    uint8_t setPeriod_ms(uint32_t period_ms);                           // 10 if out of range
+
+    void start();
+    void stop() { _running = false; }
+    void service();                 // Call from loop(); takes a row when one is due
+    bool pop(SampleRow& row);       // Oldest buffered row, false if none
+
+    bool isRunning() { return _running; }
+    uint8_t get_sourceCount() { return _sourceCount; }
+    const SampleSource& get_source(uint8_t i) { return _sources[i]; }
+    uint32_t get_period_ms() { return _period_ms; }
+    uint32_t get_taken() { return _taken; }
+    uint32_t get_dropped() { return _dropped; }
+    uint8_t get_buffered() { return _count; }
+
+    // "#STREAM seq,timestamp_us,v1,v2,..." with an empty field per failed read
+    static void printRow(Stream& out, const SampleRow& row, uint8_t sourceCount);
+
+private:
+    SampleSource _sources[SAMPLER_MAX_SOURCES];
+    uint8_t _sourceCount;
+    uint32_t _period_ms;
+    uint32_t _nextMs;
+    bool _running;
+    uint32_t _taken;
+    uint32_t _dropped;
+
+    SampleRow _ring[SAMPLER_RING_SIZE];
+    uint8_t _head;      // Next row to write
+    uint8_t _count;
+};
+
+// One reading of a source in its micro-units, through the driver wrappers
+uint8_t readSampleSource(const SampleSource& source, int32_t& value);
+const char* sampleKindName(SampleKind kind);
+
+#endif // SAMPLER_H
@@ -0,0 +1,152 @@
+#include "Subscriptions.h"
+#include "../helpers/YAMLWriter.h"
+
+Subscriptions::Subscriptions() : _nextId(1), _next(0), _nextReadMs(0) {
+    clear();
+}
+
+uint8_t Subscriptions::add(const SampleSource& source, int32_t deadband, uint32_t heartbeat_ms, uint8_t& id) {
+    if (!source.driver || deadband < 0) {
+        return 10; // invalid argument
+    }
+    for (uint8_t i = 0; i < SUB_MAX; ++i) {
+        Subscription& sub = _slots[i];
+        if (sub.id) continue;
+        sub.id = allocateId();
+        sub.source = source;
+        sub.deadband = deadband;
+        sub.heartbeat_ms = heartbeat_ms;
+        sub.reportedMs = millis();
+        sub.failing = false;
+        sub.pending = false;
+        sub.reportedAny = false;
+        id = sub.id;
+        return 0;
+    }
+    return SUB_ERR_TABLE_FULL;
+}
+
+// Ids wrap at 255; skip any still held by a live subscription, so reports
+// are never ambiguous. SUB_MAX is far below 255, so a free id always exists.
+uint8_t Subscriptions::allocateId() {
+    for (;;) {
+        uint8_t id = _nextId++;
+        if (_nextId == 0) _nextId = 1;
+        bool used = false;
+        for (uint8_t i = 0; i < SUB_MAX; ++i) {
+            used = used || _slots[i].id == id;
+        }
+        if (!used) return id;
+    }
+}
+
+bool Subscriptions::remove(uint8_t id) {
+    for (uint8_t i = 0; i < SUB_MAX; ++i) {
+        if (id && _slots[i].id == id) {
+            _slots[i].id = 0;
+            _slots[i].pending = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Subscriptions::clear() {
+    for (uint8_t i = 0; i < SUB_MAX; ++i) {
+        _slots[i].id = 0;
+        _slots[i].pending = false;
+    }
+}
+
+uint8_t Subscriptions::get_count() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < SUB_MAX; ++i) {
+        if (_slots[i].id) count++;
+    }
+    return count;
+}
+
+void Subscriptions::service() {
+    uint32_t now = millis();
+    if ((int32_t)(now - _nextReadMs) < 0) {
+        return;
+    }
+    // Find the next active slot; with none there is nothing to schedule
+    uint8_t active = get_count();
+    if (!active) {
+        return;
+    }
+    while (!_slots[_next].id) _next = (_next + 1) % SUB_MAX;
+    Subscription& sub = _slots[_next];
+    _next = (_next + 1) % SUB_MAX;
+
+    // Spread the reads so each subscription comes round every SUB_POLL_MS
+    _nextReadMs += SUB_POLL_MS / active;
+    if ((int32_t)(now - _nextReadMs) > SUB_POLL_MS) {
+        _nextReadMs = now;
+    }
+
+    int32_t value;
+    if (readSampleSource(sub.source, value)) {
+        if (!sub.failing) queue(sub, SUB_ERROR, 0, now);
+        sub.failing = true;
+        return;
+    }
+    sub.failing = false;
+    int32_t delta = value - sub.reported;
+    if (!sub.reportedAny) {
+        queue(sub, SUB_INITIAL, value, now);
+    } else if (delta > sub.deadband || delta < -sub.deadband) {
+        queue(sub, SUB_CHANGE, value, now);
+    } else if (sub.heartbeat_ms && now - sub.reportedMs >= sub.heartbeat_ms) {
+        queue(sub, SUB_HEARTBEAT, value, now);
+    }
+}
+
+void Subscriptions::queue(Subscription& sub, SubReason reason, int32_t value, uint32_t now) {
+    sub.pending = true;
+    sub.pendingReason = reason;
+    sub.pendingValue = value;
+    sub.pendingMs = now;
+    // Changes are measured from what was last queued, so a slow reader
+    // still sees every step larger than the deadband reflected in the latest report
+    sub.reportedMs = now;
+    if (reason != SUB_ERROR) {
+        sub.reported = value;
+        sub.reportedAny = true;
+    }
+}
+
+Subscription* Subscriptions::popReport() {
+    for (uint8_t i = 0; i < SUB_MAX; ++i) {
+        Subscription& sub = _slots[i];
+        if (sub.id && sub.pending) {
+            sub.pending = false;
+            return &sub;
+        }
+    }
+    return nullptr;
+}
+
+void Subscriptions::printReport(Stream& out, const Subscription& sub) {
+    LineBuffer line(out);
+    line.print("#SUB ");
+    printInt(line, sub.id);
+    line.print(',');
+    printInt(line, sub.pendingMs);
+    line.print(',');
+    if (sub.pendingReason != SUB_ERROR) {
+        printInt(line, sub.pendingValue);
+    }
+    line.print(',');
+    line.println(subReasonName(sub.pendingReason));
+}
+
+const char* subReasonName(SubReason reason) {
+    switch (reason) {
+        case SUB_INITIAL: return "initial";
+        case SUB_CHANGE: return "change";
+        case SUB_HEARTBEAT: return "heartbeat";
+        default: return "error";
+    }
+}
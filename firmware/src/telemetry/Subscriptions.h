@@ -0,0 +1,65 @@
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include <Arduino.h>
+#include "Sampler.h"
+
+#define SUB_MAX 8               // Subscriptions held at once
+#define SUB_POLL_MS 100         // Each subscription is read this often
+#define SUB_ERR_TABLE_FULL 31   // Every subscription slot is in use
+
+enum SubReason {
+    SUB_INITIAL,    // First reading after SUB ADD
+    SUB_CHANGE,     // Moved by more than the deadband since the last report
+    SUB_HEARTBEAT,  // Unchanged, but the heartbeat interval passed
+    SUB_ERROR       // The read failed (reported once per failure streak)
+};
+
+struct Subscription {
+    uint8_t id;             // 0 = free
+    SampleSource source;
+    int32_t deadband;       // uA or uV
+    uint32_t heartbeat_ms;  // 0 = changes only
+    int32_t reported;       // Last value sent
+    uint32_t reportedMs;
+    bool reportedAny;       // False until the first reading is queued
+    bool failing;
+
+    // Next report, waiting for the output side; a newer one replaces it
+    bool pending;
+    SubReason pendingReason;
+    int32_t pendingValue;
+    uint32_t pendingMs;
+};
+
+// Report-on-change monitor. service() reads one subscription per call,
+// each every SUB_POLL_MS, and queues a report when its value leaves the
+// deadband around the last reported value or its heartbeat is due.
+class Subscriptions {
+public:
+    Subscriptions();
+    uint8_t add(const SampleSource& source, int32_t deadband, uint32_t heartbeat_ms, uint8_t& id);
+    bool remove(uint8_t id);
+    void clear();
+    void service();                     // Call from loop()
+    Subscription* popReport();          // Oldest-slot pending report, cleared; nullptr if none
+
+    const Subscription& get_slot(uint8_t index) { return _slots[index]; }  // id 0 = free
+    uint8_t get_count();
+
+    // "#SUB id,time_ms,value,reason"
+    static void printReport(Stream& out, const Subscription& sub);
+
+private:
+    Subscription _slots[SUB_MAX];
+    uint8_t _nextId;
+    uint8_t _next;          // Slot read on the next service()
+    uint32_t _nextReadMs;
+
+    void queue(Subscription& sub, SubReason reason, int32_t value, uint32_t now);
+    uint8_t allocateId();   // Next id after the last one given out that no slot holds
+};
+
+const char* subReasonName(SubReason reason);
+
+#endif // SUBSCRIPTIONS_H
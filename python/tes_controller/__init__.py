@@ -1,6 +1,9 @@
 """tes_controller Python client package"""
 from .serial_client import SerialClient
-from .drivers import TesController, LnaController
+from .drivers import TesController, LnaController, SystemController
 from .controller import DeviceController
+from .stream import StreamReader, SubReport
+from .aio import AsyncSerialClient, AsyncDeviceController
 
-__all__ = ["SerialClient", "TesController", "LnaController", "DeviceController"]
+__all__ = ["SerialClient", "TesController", "LnaController", "SystemController", "DeviceController", "StreamReader", "SubReport",
+           "AsyncSerialClient", "AsyncDeviceController"]
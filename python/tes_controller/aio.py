@@ -0,0 +1,512 @@
+"""asyncio client for the TES controller.
+
+AsyncSerialClient runs a single reader task per port that routes each
+response to the coroutine waiting for its request ID, so any number of tasks
+(monitoring, DAQ, bias control) can await commands on one port at once. The
+firmware runs commands in arrival order; the client keeps them in flight
+within the device's input queue (REQUEST_RX_BUFFER_SIZE).
+
+The serial port is driven through the event loop's add_reader(), so
+open() needs a POSIX system. from_streams() accepts any asyncio stream pair
+instead, e.g. a TCP bridge or the host simulator.
+"""
+import asyncio
+import collections
+from typing import Any, Callable, Dict, List, Optional, Union
+
+from .drivers import ADC_PROFILES, CommandError, response_result
+from .response import ResponseParser
+from .serial_client import REQUEST_RX_BUFFER_SIZE, _command_error
+from .stream import STREAM_KINDS, SubReport, parse_sub_report, sub_report_id
+
+
+class _SerialFeeder:
+    """Feeds bytes from a non-blocking pyserial port into a StreamReader."""
+
+    def __init__(self, ser, reader: asyncio.StreamReader):
+        self._serial = ser
+        self._reader = reader
+
+    def on_readable(self):
+        try:
+            data = self._serial.read(self._serial.in_waiting or 1)
+        except Exception as e:
+            self._reader.set_exception(e)
+            return
+        if data:
+            self._reader.feed_data(data)
+
+
+class _SerialWriter:
+    """The StreamWriter subset AsyncSerialClient uses, over a pyserial port."""
+
+    def __init__(self, ser):
+        self._serial = ser
+
+    def write(self, data: bytes):
+        self._serial.write(data)
+
+    async def drain(self):
+        pass
+
+    def close(self):
+        self._serial.close()
+
+
+class AsyncSerialClient:
+    """Request-ID multiplexed command client.
+
+    Usage:
+        client = await AsyncSerialClient.open('/dev/ttyACM0')
+        resp = await client.command('TES 1 GET')
+        await client.close()
+    """
+
+    def __init__(self, reader: asyncio.StreamReader, writer, timeout: float = 1.0,
+                 max_bytes_in_flight: int = REQUEST_RX_BUFFER_SIZE):
+        self.timeout = timeout
+        self._reader = reader
+        self._writer = writer
+        self._request_id = 0
+        self._pending: 'collections.OrderedDict[int, asyncio.Future]' = collections.OrderedDict()
+        self._push_handlers: Dict[str, Callable[[str], None]] = {}
+        self._max_bytes = max_bytes_in_flight
+        self._bytes_in_flight = 0
+        self._budget = asyncio.Condition()
+        self._on_close: Optional[Callable[[], None]] = None
+        self._reader_task = asyncio.get_running_loop().create_task(self._read_loop())
+
+    @classmethod
+    async def open(cls, port: str, baud: int = 115200, timeout: float = 1.0) -> 'AsyncSerialClient':
+        import serial
+        ser = serial.Serial(port, baud, timeout=0)
+        await asyncio.sleep(0.1)  # Let MCU boot banners settle
+        loop = asyncio.get_running_loop()
+        reader = asyncio.StreamReader()
+        feeder = _SerialFeeder(ser, reader)
+        loop.add_reader(ser.fileno(), feeder.on_readable)
+        client = cls(reader, _SerialWriter(ser), timeout=timeout)
+        client._on_close = lambda: loop.remove_reader(ser.fileno())
+        return client
+
+    @classmethod
+    def from_streams(cls, reader: asyncio.StreamReader, writer, timeout: float = 1.0) -> 'AsyncSerialClient':
+        return cls(reader, writer, timeout=timeout)
+
+    async def close(self):
+        self._reader_task.cancel()
+        try:
+            await self._reader_task
+        except (asyncio.CancelledError, Exception):
+            pass
+        if self._on_close:
+            self._on_close()
+        self._writer.close()
+        self._fail_pending(RuntimeError('client closed'))
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, exc_type, exc, tb):
+        await self.close()
+
+    def add_push_handler(self, tag: str, handler: Callable[[str], None]):
+        """Call handler(text) for each '<tag> text' line, e.g. tag '#SUB'.
+        Handlers run on the reader task and must not block."""
+        self._push_handlers[tag] = handler
+
+    def remove_push_handler(self, tag: str):
+        self._push_handlers.pop(tag, None)
+
+    async def command(self, cmd: str, timeout: Optional[float] = None) -> dict:
+        """Send one command and await its response envelope."""
+        line = cmd.strip()
+        size = len(line) + 14   # '@<id> ' and CRLF
+        async with self._budget:
+            await self._budget.wait_for(
+                lambda: not self._pending or self._bytes_in_flight + size <= self._max_bytes)
+            self._bytes_in_flight += size
+        self._request_id = self._request_id % 999999999 + 1
+        request_id = self._request_id
+        future = asyncio.get_running_loop().create_future()
+        self._pending[request_id] = future
+        try:
+            self._writer.write(f'@{request_id} {line}\r\n'.encode('utf-8'))
+            await self._writer.drain()
+            timeout = timeout if timeout is not None else self.timeout
+            while True:
+                try:
+                    return await asyncio.wait_for(asyncio.shield(future), timeout)
+                except asyncio.TimeoutError:
+                    # Only time out once the device has reached this request;
+                    # before that it is still working through earlier ones
+                    if next(iter(self._pending), request_id) == request_id:
+                        raise RuntimeError(f'No response from device to {line!r}') from None
+        finally:
+            self._pending.pop(request_id, None)
+            async with self._budget:
+                self._bytes_in_flight -= size
+                self._budget.notify_all()
+
+    async def request(self, cmd: str, timeout: Optional[float] = None) -> Dict[str, Any]:
+        """command() returning the 'result' mapping; raises CommandError on error."""
+        return response_result(await self.command(cmd, timeout=timeout))
+
+    async def _read_loop(self):
+        parser = None
+        try:
+            while True:
+                raw = await self._reader.readline()
+                if not raw:
+                    raise RuntimeError('serial port closed')
+                line = raw.decode('utf-8', errors='ignore').rstrip('\r\n')
+                if parser is not None:
+                    if parser.feed(line):
+                        self._deliver(parser.response())
+                        parser = None
+                elif line.strip() == '---':
+                    parser = ResponseParser()
+                    parser.feed(line)
+                elif line.startswith('ERROR'):
+                    # Rejected by the command parser; responses are in order,
+                    # so it answers the oldest outstanding request
+                    self._resolve_oldest(_command_error(line))
+                elif line.startswith('#'):
+                    tag, _, text = line.partition(' ')
+                    handler = self._push_handlers.get(tag)
+                    if handler:
+                        handler(text)
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            self._fail_pending(e)
+
+    def _deliver(self, resp):
+        if not isinstance(resp, dict):
+            return
+        request_id = resp.get('id')
+        if request_id not in self._pending:
+            return  # Late response to a timed-out request
+        # Requests ahead of this one have been answered or lost
+        while self._pending:
+            pending_id, future = next(iter(self._pending.items()))
+            if pending_id == request_id:
+                break
+            self._pending.popitem(last=False)
+            if not future.done():
+                future.set_result({'status': 'error', 'result': {'error': 'NO_RESPONSE'}})
+        future = self._pending.pop(request_id)
+        if not future.done():
+            future.set_result(resp)
+
+    def _resolve_oldest(self, resp: dict):
+        while self._pending:
+            _, future = self._pending.popitem(last=False)
+            if not future.done():
+                future.set_result(resp)
+                return
+
+    def _fail_pending(self, error: Exception):
+        while self._pending:
+            _, future = self._pending.popitem(last=False)
+            if not future.done():
+                future.set_exception(error)
+
+
+Channels = Union[int, List[int], None]
+
+
+class AsyncDeviceController:
+    """asyncio counterpart of DeviceController.
+
+    The tes_* and lna_* coroutines take the same arguments and return the
+    same results as DeviceController's methods. Multi-channel calls send
+    every channel's command at once and gather the responses.
+
+    Usage:
+        async with await AsyncDeviceController.open('/dev/ttyACM0') as ctrl:
+            readings, snapshot = await asyncio.gather(ctrl.tes_get_all(), ctrl.snapshot())
+    """
+
+    def __init__(self, client: AsyncSerialClient, num_tes: int = 6, num_lna: int = 6):
+        self.client = client
+        self.num_tes = num_tes
+        self.num_lna = num_lna
+        # SUB id -> (source, scale to mA or V, callback)
+        self._subscriptions: Dict[int, Any] = {}
+        self._early_reports: List[str] = []
+
+    @classmethod
+    async def open(cls, port: str = '/dev/ttyACM0', baud: int = 115200, timeout: float = 1.0,
+                   num_tes: int = 6, num_lna: int = 6) -> 'AsyncDeviceController':
+        client = await AsyncSerialClient.open(port, baud=baud, timeout=timeout)
+        return cls(client, num_tes=num_tes, num_lna=num_lna)
+
+    async def close(self):
+        await self.client.close()
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, exc_type, exc, tb):
+        await self.close()
+
+    # ========== Helpers ==========
+    def _check_tes_channel(self, channel: int) -> None:
+        if not isinstance(channel, int):
+            raise TypeError(f"TES channel must be int, got {type(channel).__name__}")
+        if channel < 1 or channel > self.num_tes:
+            raise ValueError(f"TES channel {channel} out of range (1..{self.num_tes})")
+
+    def _check_lna_channel(self, channel: int) -> None:
+        if not isinstance(channel, int):
+            raise TypeError(f"LNA channel must be int, got {type(channel).__name__}")
+        if channel < 1 or channel > self.num_lna:
+            raise ValueError(f"LNA channel {channel} out of range (1..{self.num_lna})")
+
+    @staticmethod
+    def _check_target(target: Optional[str]) -> str:
+        if target is None:
+            raise ValueError("target must be provided ('GATE' or 'DRAIN')")
+        if not isinstance(target, str) or target.upper() not in ('GATE', 'DRAIN'):
+            raise ValueError("target must be 'GATE' or 'DRAIN'")
+        return target.upper()
+
+    @staticmethod
+    def _check_profile(profile: str) -> str:
+        if profile.upper() not in ADC_PROFILES:
+            raise ValueError(f"profile must be one of {ADC_PROFILES}")
+        return profile.upper()
+
+    def _pairs(self, channel: Channels, value, count: int, check, name: str):
+        """(channel, value) pairs for the channel/value combinations the
+        DeviceController setters accept, and whether one dict is returned."""
+        if value is None:
+            raise ValueError(f"{name} must be provided")
+        if isinstance(channel, int) and not isinstance(value, list):
+            check(channel)
+            return [(channel, value)], True
+        if channel is None:
+            channel = list(range(1, count + 1))
+            if isinstance(value, list) and len(value) != count:
+                raise ValueError(f"{name} list length {len(value)} must match "
+                                 f"{'num_tes' if count == self.num_tes else 'num_lna'} {count}")
+        elif not isinstance(channel, list):
+            raise ValueError(f"Invalid combination of channel and {name} arguments")
+        elif isinstance(value, list) and len(channel) != len(value):
+            raise ValueError(f"channel and {name} lists must have same length")
+        for ch in channel:
+            check(ch)
+        values = value if isinstance(value, list) else [value] * len(channel)
+        return list(zip(channel, values)), False
+
+    def _channels(self, channel: Channels, count: int, check):
+        if channel is None:
+            return list(range(1, count + 1)), False
+        if isinstance(channel, list):
+            for ch in channel:
+                check(ch)
+            return channel, False
+        check(channel)
+        return [channel], True
+
+    async def _run(self, cmds: List[str], single: bool, timeout: Optional[float] = None):
+        results = await asyncio.gather(*(self.client.request(cmd, timeout=timeout) for cmd in cmds))
+        return results[0] if single else list(results)
+
+    async def _tes(self, channel: Channels, verb: str):
+        channels, single = self._channels(channel, self.num_tes, self._check_tes_channel)
+        return await self._run([f"TES {ch} {verb}" for ch in channels], single)
+
+    async def _lna(self, channel: Channels, target: Optional[str], verb: str):
+        target = self._check_target(target)
+        channels, single = self._channels(channel, self.num_lna, self._check_lna_channel)
+        return await self._run([f"LNA {ch} {target} {verb}" for ch in channels], single)
+
+    # ========== DAC and Crate-wide Methods ==========
+    async def flux_ramp_set(self, value: int) -> Dict[str, Any]:
+        assert 0 <= value <= 1024, "value must be between 0 and 0xFFFF"
+        return await self.client.request(f"DAC SET {value}")
+
+    async def flux_ramp_get(self) -> Dict[str, Any]:
+        return await self.client.request("DAC GET")
+
+    async def snapshot(self) -> Dict[str, Any]:
+        """As DeviceController.snapshot()."""
+        result = await self.client.request("SNAPSHOT")
+        result['tes'] = (result.get('tes') or [])[:self.num_tes]
+        result['lna'] = (result.get('lna') or [])[:self.num_lna]
+        return result
+
+    async def history(self, kind: str, channel: int) -> Dict[str, Any]:
+        """As DeviceController.history()."""
+        return await self.client.request(f"HISTORY {kind.upper()}:{channel}")
+
+    async def subscribe(self, source: str, deadband: float, callback: Callable[[SubReport], None],
+                        heartbeat_s: float = 0.0) -> int:
+        """As DeviceController.subscribe(); callback runs on the reader task
+        and must not block (schedule a task for any follow-up commands)."""
+        keyword = source.split(':')[0].upper()
+        voltage = keyword in ('DRAINV', 'GATEV')
+        self.client.add_push_handler('#SUB', self._on_sub_report)
+        deadband = deadband * 1e3 if voltage else deadband
+        result = await self.client.request(
+            f"SUB ADD {source.upper()} {deadband:.4f} {int(round(heartbeat_s * 1e3))}")
+        _, scale = STREAM_KINDS[result['kind']]
+        self._subscriptions[result['id']] = (source.upper(), scale, callback)
+        early = [t for t in self._early_reports if sub_report_id(t) == result['id']]
+        self._early_reports = [t for t in self._early_reports if sub_report_id(t) != result['id']]
+        for text in early:
+            callback(parse_sub_report(text, source.upper(), scale))
+        return result['id']
+
+    async def unsubscribe(self, sub_id: Optional[int] = None) -> None:
+        """Remove one subscription, or every one when sub_id is None."""
+        if sub_id is None:
+            await self.client.request("SUB CLEAR")
+            self._subscriptions.clear()
+            self._early_reports = []
+        else:
+            await self.client.request(f"SUB REMOVE {sub_id}")
+            self._subscriptions.pop(sub_id, None)
+            self._early_reports = [t for t in self._early_reports if sub_report_id(t) != sub_id]
+        if not self._subscriptions:
+            self.client.remove_push_handler('#SUB')
+
+    def _on_sub_report(self, text: str):
+        entry = self._subscriptions.get(sub_report_id(text))
+        if entry is None:
+            self._early_reports.append(text)  # Arrived before SUB ADD's response
+            return
+        source, scale, callback = entry
+        callback(parse_sub_report(text, source, scale))
+
+    async def job_wait(self, job_id: int, timeout: float = 30.0, poll_s: float = 0.05) -> Dict[str, Any]:
+        """As DeviceController.job_wait(), sleeping without blocking the loop."""
+        deadline = asyncio.get_running_loop().time() + timeout
+        while True:
+            result = await self.client.request(f"JOB STATUS {job_id}")
+            state = result.get('state')
+            if state == 'done':
+                return result
+            if state != 'running':
+                raise CommandError({'status': 'error', 'result': result})
+            if asyncio.get_running_loop().time() > deadline:
+                raise TimeoutError(f"job {job_id} still running after {timeout} s")
+            await asyncio.sleep(poll_s)
+
+    # ========== TES Methods ==========
+    async def tes_get_all(self, channel: Channels = None):
+        return await self._tes(channel, "GET")
+
+    async def tes_enable(self, channel: Channels = None):
+        return await self._tes(channel, "ENABLE")
+
+    async def tes_disable(self, channel: Channels = None):
+        return await self._tes(channel, "DISABLE")
+
+    async def tes_set_current(self, channel: Channels = None, current_mA: Union[float, List[float], None] = None):
+        """Several channels go in one TESSET, as in DeviceController."""
+        pairs, single = self._pairs(channel, current_mA, self.num_tes, self._check_tes_channel, "current_mA")
+        for _, mA in pairs:
+            assert 0 <= mA <= 20.0, "current_mA must be between 0 and 20.0"
+        if single:
+            return await self.client.request(f"TES {pairs[0][0]} SET {pairs[0][1]}")
+        result = await self.client.request("TESSET " + ",".join(f"{ch}:{mA:.4f}" for ch, mA in pairs), timeout=5.0)
+        entries = result.get('channels') or []
+        if any('error' in entry for entry in entries):
+            raise CommandError({'status': 'error', 'result': result})
+        return entries
+
+    async def tes_inc_current(self, channel: Channels = None, delta: Union[int, List[int], None] = None):
+        pairs, single = self._pairs(channel, delta, self.num_tes, self._check_tes_channel, "delta")
+        return await self._run([f"TES {ch} INC {d}" for ch, d in pairs], single)
+
+    async def tes_dec_current(self, channel: Channels = None, delta: Union[int, List[int], None] = None):
+        pairs, single = self._pairs(channel, delta, self.num_tes, self._check_tes_channel, "delta")
+        return await self._run([f"TES {ch} DEC {d}" for ch, d in pairs], single)
+
+    async def tes_set_bits(self, channel: Channels = None, value: Union[int, List[int], None] = None):
+        pairs, single = self._pairs(channel, value, self.num_tes, self._check_tes_channel, "value")
+        for _, v in pairs:
+            assert 0 <= v <= 0xFFFFF, "value must be between 0 and 0xFFFFF"
+        return await self._run([f"TES {ch} SETINT {v}" for ch, v in pairs], single)
+
+    async def tes_get_bits(self, channel: Channels = None):
+        return await self._tes(channel, "BIT")
+
+    async def tes_get_shunt(self, channel: Channels = None):
+        return await self._tes(channel, "SHUNT")
+
+    async def tes_get_bus(self, channel: Channels = None):
+        return await self._tes(channel, "BUS")
+
+    async def tes_get_current(self, channel: Channels = None):
+        return await self._tes(channel, "CURRENT")
+
+    async def tes_get_power(self, channel: Channels = None):
+        return await self._tes(channel, "POWER")
+
+    async def tes_calibrate(self, channel: Channels = None):
+        return await self._tes(channel, "CAL")
+
+    async def tes_get_calibration(self, channel: Channels = None):
+        return await self._tes(channel, "CALGET")
+
+    async def tes_clear_calibration(self, channel: Channels = None):
+        return await self._tes(channel, "CALCLEAR")
+
+    async def tes_set_adc_profile(self, channel: Channels = None, profile: str = 'DEFAULT'):
+        return await self._tes(channel, f"ADC {self._check_profile(profile)}")
+
+    # ========== LNA Methods ==========
+    async def lna_get_all(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "GET")
+
+    async def lna_enable(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "ENABLE")
+
+    async def lna_disable(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "DISABLE")
+
+    async def lna_set_adc_profile(self, channel: Channels = None, target: Optional[str] = None,
+                                  profile: str = 'DEFAULT'):
+        return await self._lna(channel, target, f"ADC {self._check_profile(profile)}")
+
+    async def lna_set_dac(self, channel: Channels = None, target: Optional[str] = None,
+                          value: Union[int, List[int], None] = None):
+        target = self._check_target(target)
+        pairs, single = self._pairs(channel, value, self.num_lna, self._check_lna_channel, "value")
+        for _, v in pairs:
+            assert 0 <= v <= 0xFFFF, "value must be between 0 and 0xFFFF"
+        return await self._run([f"LNA {ch} {target} SET {v}" for ch, v in pairs], single)
+
+    async def lna_set_voltage(self, channel: Channels = None, target: Optional[str] = None,
+                              voltage_V: Union[float, List[float], None] = None, linear: bool = False):
+        target = self._check_target(target)
+        pairs, single = self._pairs(channel, voltage_V, self.num_lna, self._check_lna_channel, "voltage_V")
+        for _, v in pairs:
+            assert 0.0 <= v <= 5.0, "voltage must be between 0.0 and 5.0V"
+        verb = "SETVLIN" if linear else "SETV"
+        return await self._run([f"LNA {ch} {target} {verb} {v}" for ch, v in pairs], single)
+
+    async def lna_set_current(self, channel: Channels = None, target: Optional[str] = None,
+                              current_mA: Union[float, List[float], None] = None, linear: bool = False):
+        target = self._check_target(target)
+        pairs, single = self._pairs(channel, current_mA, self.num_lna, self._check_lna_channel, "current_mA")
+        for _, mA in pairs:
+            assert 0.0 <= mA <= 64.0, "current must be between 0.0 and 64.0 mA"
+        verb = "SETMALIN" if linear else "SETMA"
+        return await self._run([f"LNA {ch} {target} {verb} {mA}" for ch, mA in pairs], single)
+
+    async def lna_get_shunt(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "SHUNT")
+
+    async def lna_get_bus(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "BUS")
+
+    async def lna_get_current(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "CURRENT")
+
+    async def lna_get_power(self, channel: Channels = None, target: Optional[str] = None):
+        return await self._lna(channel, target, "POWER")
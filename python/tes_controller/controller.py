@@ -1,7 +1,10 @@
+import threading
+import time
 import yaml
-from typing import Optional, Dict, Any, Union, List
+from typing import Optional, Dict, Any, Union, List, Callable
 from .serial_client import SerialClient
-from .drivers import TesController, LnaController, FluxRampController
+from .drivers import TesController, LnaController, FluxRampController, SystemController, CommandError, response_result
+from .stream import StreamReader, STREAM_KINDS, SubReport, parse_sub_report, sub_report_id
 
 class DeviceController:
     """High-level controller that encapsulates SerialClient, TesController and LnaController.
@@ -42,6 +45,14 @@ class DeviceController:
         # DAC controller (single instance, no channel binding)
         self.dac = FluxRampController(self.client)
 
+        # Crate-wide commands (snapshot, ...)
+        self.system = SystemController(self.client)
+
+        # SUB id -> (source, scale to mA or V, callback)
+        self._subscriptions: Dict[int, Any] = {}
+        self._early_reports: List[str] = []   # Reports read before their SUB ADD returned
+        self._sub_lock = threading.Lock()
+
     @classmethod
     def from_config(cls, path: str, auto_open: bool = True) -> 'DeviceController':
         """Load controller config from a YAML file.
@@ -78,6 +89,132 @@ class DeviceController:
         """Get current DAC value."""
         return self.dac.get_dac()
 
+    # ========== Crate-wide Methods ==========
+    def snapshot(self) -> Dict[str, Any]:
+        """Read every TES and LNA channel with a single SNAPSHOT command.
+
+        Returns:
+            Dict with 'dac_value', 'tes' (one dict per TES channel), 'lna'
+            (one dict per LNA channel with 'drain' and 'gate' sub-dicts) and
+            'elapsed_ms'. Lists are trimmed to num_tes/num_lna. A channel that
+            failed to read carries 'error' and 'code' instead of readings.
+        """
+        result = self.system.snapshot()
+        result['tes'] = (result.get('tes') or [])[:self.num_tes]
+        result['lna'] = (result.get('lna') or [])[:self.num_lna]
+        return result
+
+    def history(self, kind: str, channel: int) -> Dict[str, Any]:
+        """On-device current history of one rail.
+
+        kind is 'TES', 'DRAIN' or 'GATE'. Returns the HISTORY result, whose
+        'seconds', 'minutes' and 'hours' lists hold [min, max, mean] in mA
+        per bucket (None for a bucket without readings), oldest first; the
+        newest bucket of each level ends at its 'seconds_end_s',
+        'minutes_end_s' or 'hours_end_s' (seconds after boot).
+        """
+        return self.system.history(kind, channel)
+
+    def stream(self, period_ms: int, sources: List[str]) -> StreamReader:
+        """Configure and start the firmware sampler; returns the running reader.
+
+        sources are STREAM CONFIG items such as 'TES:1', 'DRAIN:2' or
+        'GATEV:2' (up to 8). No other command may be sent until
+        reader.stop() returns; reader.arrays() then holds the columns.
+        """
+        reader = StreamReader(self.client)
+        reader.configure(period_ms, sources)
+        reader.start()
+        return reader
+
+    def subscribe(self, source: str, deadband: float, callback: Callable[[SubReport], None],
+                  heartbeat_s: float = 0.0) -> int:
+        """Report one quantity on change: callback(report) runs for the
+        first reading, whenever the value moves more than deadband from the
+        last report, and after heartbeat_s without one (0 = never).
+
+        source is a STREAM-style item such as 'TES:1', 'DRAIN:2' or
+        'GATEV:2'; deadband and report values are in mA for currents and V
+        for voltages. The first subscription starts the client's listener
+        thread, on which callbacks run; they must not send commands. Up to
+        8 subscriptions; returns the id for unsubscribe().
+        """
+        keyword = source.split(':')[0].upper()
+        voltage = keyword in ('DRAINV', 'GATEV')
+        self.client.add_push_handler('#SUB', self._on_sub_report)
+        self.client.start_listener()
+        try:
+            result = self.system.sub_add(source, deadband * 1e3 if voltage else deadband,
+                                         int(round(heartbeat_s * 1e3)))
+        except Exception:
+            with self._sub_lock:
+                idle = not self._subscriptions
+            if idle:
+                self.client.stop_listener()
+            raise
+        _, scale = STREAM_KINDS[result['kind']]
+        with self._sub_lock:
+            self._subscriptions[result['id']] = (source.upper(), scale, callback)
+            early = [t for t in self._early_reports if sub_report_id(t) == result['id']]
+            self._early_reports = [t for t in self._early_reports if sub_report_id(t) != result['id']]
+        for text in early:
+            callback(parse_sub_report(text, source.upper(), scale))
+        return result['id']
+
+    def unsubscribe(self, sub_id: Optional[int] = None) -> None:
+        """Remove one subscription, or every one when sub_id is None. The
+        listener thread stops with the last one."""
+        if sub_id is None:
+            self.system.sub_clear()
+            with self._sub_lock:
+                self._subscriptions.clear()
+                self._early_reports = []
+                idle = True
+        else:
+            self.system.sub_remove(sub_id)
+            with self._sub_lock:
+                self._subscriptions.pop(sub_id, None)
+                self._early_reports = [t for t in self._early_reports if sub_report_id(t) != sub_id]
+                idle = not self._subscriptions
+        if idle:
+            self.client.stop_listener()
+            self.client.remove_push_handler('#SUB')
+
+    def _on_sub_report(self, text: str):
+        sub_id = sub_report_id(text)
+        with self._sub_lock:
+            entry = self._subscriptions.get(sub_id)
+            if entry is None:
+                # Read before subscribe() registered the id (or after removal)
+                self._early_reports.append(text)
+                return
+        source, scale, callback = entry
+        callback(parse_sub_report(text, source, scale))
+
+    def job_wait(self, job_id: int, timeout: float = 30.0, poll_s: float = 0.05) -> Dict[str, Any]:
+        """Poll JOB STATUS until the job leaves the running state.
+
+        Returns the final JOB STATUS result. Raises CommandError if the job
+        failed or was cancelled, and TimeoutError if it is still running
+        after timeout seconds. Other commands may be sent between polls.
+        """
+        deadline = time.monotonic() + timeout
+        while True:
+            result = self.system.job_status(job_id)
+            state = result.get('state')
+            if state == 'done':
+                return result
+            if state != 'running':
+                raise CommandError({'status': 'error', 'result': result})
+            if time.monotonic() > deadline:
+                raise TimeoutError(f"job {job_id} still running after {timeout} s")
+            time.sleep(poll_s)
+
+    def _pipelined(self, cmds: List[str]) -> List[Dict[str, Any]]:
+        """Run per-channel commands through the client pipeline and return
+        their results in order; raises CommandError on the first failure."""
+        return [response_result(resp) for resp in self.client.pipeline(cmds)]
+
     # ========== TES Convenience Methods ==========
     def tes_get_all(self, channel: Union[int, List[int], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
         """Get all TES channel data.
@@ -89,9 +226,11 @@ class DeviceController:
             Single dict if channel is int, list of dicts otherwise
         """
         if channel is None:
-            return [self.tes[i].get_all() for i in range(self.num_tes)]
+            return self._pipelined([f"TES {i + 1} GET" for i in range(self.num_tes)])
         elif isinstance(channel, list):
-            return [self.tes[ch - 1].get_all() for ch in channel]
+            for ch in channel:
+                self._check_tes_channel(ch)
+            return self._pipelined([f"TES {ch} GET" for ch in channel])
         else:
             self._check_tes_channel(channel)
             return self.tes[channel - 1].get_all()
@@ -146,6 +285,9 @@ class DeviceController:
             tes_set_current([1, 3, 5], 5.0)  # Set channels 1, 3, 5 to 5.0 mA
             tes_set_current([1, 3, 5], [1.0, 2.0, 3.0])  # Set channels to different values
             
+        Several channels are set with one TESSET command, which interleaves
+        their searches so the whole set takes about as long as one channel.
+
         Returns:
             Single dict if setting one channel, list of dicts otherwise
         """
@@ -159,26 +301,41 @@ class DeviceController:
         
         # Case 2: All channels, single value
         if channel is None and not isinstance(current_mA, list):
-            return [self.tes[i].set_current(current_mA) for i in range(self.num_tes)]
+            return self._tes_set_many({i + 1: current_mA for i in range(self.num_tes)})
         
         # Case 3: All channels, array of values
         if channel is None and isinstance(current_mA, list):
             if len(current_mA) != self.num_tes:
                 raise ValueError(f"current_mA list length {len(current_mA)} must match num_tes {self.num_tes}")
-            return [self.tes[i].set_current(current_mA[i]) for i in range(self.num_tes)]
+            return self._tes_set_many({i + 1: current_mA[i] for i in range(self.num_tes)})
         
         # Case 4: Array of channels, single value
         if isinstance(channel, list) and not isinstance(current_mA, list):
-            return [self.tes[ch - 1].set_current(current_mA) for ch in channel]
+            self._check_unique_channels(channel)
+            return self._tes_set_many({ch: current_mA for ch in channel})
         
         # Case 5: Array of channels, array of values
         if isinstance(channel, list) and isinstance(current_mA, list):
             if len(channel) != len(current_mA):
                 raise ValueError(f"channel and current_mA lists must have same length")
-            return [self.tes[ch - 1].set_current(curr) for ch, curr in zip(channel, current_mA)]
+            self._check_unique_channels(channel)
+            return self._tes_set_many(dict(zip(channel, current_mA)))
         
         raise ValueError("Invalid combination of channel and current_mA arguments")
 
+    def _tes_set_many(self, targets: Dict[int, float]) -> List[Dict[str, Any]]:
+        """Run TESSET and return one dict per channel, in request order.
+
+        Raises CommandError carrying the whole result if any channel failed.
+        """
+        for ch in targets:
+            self._check_tes_channel(ch)
+        result = self.system.tes_set_currents(targets)
+        entries = result.get('channels') or []
+        if any('error' in entry for entry in entries):
+            raise CommandError({'status': 'error', 'result': result})
+        return entries
+
     def tes_inc_current(self, 
                        channel: Union[int, List[int], None] = None,
                        delta: Union[int, List[int], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
@@ -375,6 +532,80 @@ class DeviceController:
             self._check_tes_channel(channel)
             return self.tes[channel - 1].get_power()
 
+    def tes_calibrate(self, channel: Union[int, List[int], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+        """Measure TES bit weights so later SETs are a single write.
+
+        Args:
+            channel: int for single channel, list of ints for multiple, None for all channels
+
+        Returns:
+            Single dict if channel is int, list of dicts otherwise
+        """
+        if channel is None:
+            return [self.tes[i].calibrate() for i in range(self.num_tes)]
+        elif isinstance(channel, list):
+            return [self.tes[ch - 1].calibrate() for ch in channel]
+        else:
+            self._check_tes_channel(channel)
+            return self.tes[channel - 1].calibrate()
+
+    def tes_get_calibration(self, channel: Union[int, List[int], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+        """Get the TES bit-weight calibration.
+
+        Args:
+            channel: int for single channel, list of ints for multiple, None for all channels
+
+        Returns:
+            Single dict if channel is int, list of dicts otherwise
+        """
+        if channel is None:
+            return [self.tes[i].get_calibration() for i in range(self.num_tes)]
+        elif isinstance(channel, list):
+            return [self.tes[ch - 1].get_calibration() for ch in channel]
+        else:
+            self._check_tes_channel(channel)
+            return self.tes[channel - 1].get_calibration()
+
+    def tes_clear_calibration(self, channel: Union[int, List[int], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+        """Discard the TES calibration; SET falls back to the search.
+
+        Args:
+            channel: int for single channel, list of ints for multiple, None for all channels
+
+        Returns:
+            Single dict if channel is int, list of dicts otherwise
+        """
+        if channel is None:
+            return [self.tes[i].clear_calibration() for i in range(self.num_tes)]
+        elif isinstance(channel, list):
+            return [self.tes[ch - 1].clear_calibration() for ch in channel]
+        else:
+            self._check_tes_channel(channel)
+            return self.tes[channel - 1].clear_calibration()
+
+    def tes_set_adc_profile(self,
+                            channel: Union[int, List[int], None] = None,
+                            profile: str = 'DEFAULT') -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+        """Select the INA219 profile ('DEFAULT', 'MONITOR' or 'FAST').
+
+        FAST lets SET, TESSET and CAL wait for each conversion instead of a
+        fixed settle time; MONITOR averages 128 samples for quiet readings.
+
+        Args:
+            channel: int for single channel, list of ints for multiple, None for all channels
+            profile: profile name
+
+        Returns:
+            Single dict if channel is int, list of dicts otherwise
+        """
+        if channel is None:
+            return [self.tes[i].set_adc_profile(profile) for i in range(self.num_tes)]
+        elif isinstance(channel, list):
+            return [self.tes[ch - 1].set_adc_profile(profile) for ch in channel]
+        else:
+            self._check_tes_channel(channel)
+            return self.tes[channel - 1].set_adc_profile(profile)
+
     # ========== LNA Convenience Methods ==========
     def lna_get_all(self, 
                    channel: Union[int, List[int], None] = None,
@@ -390,11 +621,15 @@ class DeviceController:
         """
         if target is None:
             raise ValueError("target must be provided ('GATE' or 'DRAIN')")
+        if str(target).upper() not in ('GATE', 'DRAIN'):
+            raise ValueError("target must be 'GATE' or 'DRAIN'")
             
         if channel is None:
-            return [self.lna[i].get_all(target) for i in range(self.num_lna)]
+            return self._pipelined([f"LNA {i + 1} {target.upper()} GET" for i in range(self.num_lna)])
         elif isinstance(channel, list):
-            return [self.lna[ch - 1].get_all(target) for ch in channel]
+            for ch in channel:
+                self._check_lna_channel(ch)
+            return self._pipelined([f"LNA {ch} {target.upper()} GET" for ch in channel])
         else:
             self._check_lna_channel(channel)
             return self.lna[channel - 1].get_all(target)
@@ -445,6 +680,31 @@ class DeviceController:
             self._check_lna_channel(channel)
             return self.lna[channel - 1].disable(target)
 
+    def lna_set_adc_profile(self,
+                            channel: Union[int, List[int], None] = None,
+                            target: Union[str, None] = None,
+                            profile: str = 'DEFAULT') -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+        """Select the INA219 profile ('DEFAULT', 'MONITOR' or 'FAST') for target.
+
+        Args:
+            channel: int for single channel, list of ints for multiple, None for all channels
+            target: 'GATE' or 'DRAIN' (required)
+            profile: profile name
+
+        Returns:
+            Single dict if channel is int, list of dicts otherwise
+        """
+        if target is None:
+            raise ValueError("target must be provided ('GATE' or 'DRAIN')")
+
+        if channel is None:
+            return [self.lna[i].set_adc_profile(target, profile) for i in range(self.num_lna)]
+        elif isinstance(channel, list):
+            return [self.lna[ch - 1].set_adc_profile(target, profile) for ch in channel]
+        else:
+            self._check_lna_channel(channel)
+            return self.lna[channel - 1].set_adc_profile(target, profile)
+
     def lna_set_dac(self, 
                    channel: Union[int, List[int], None] = None,
                    target: Union[str, None] = None,
@@ -501,12 +761,14 @@ class DeviceController:
     def lna_set_voltage(self,
                         channel: Union[int, List[int], None] = None,
                         target: Union[str, None] = None,
-                        voltage_V: Union[float, List[float], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+                        voltage_V: Union[float, List[float], None] = None,
+                        linear: bool = False) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
         """Set LNA voltage for target (0.0-5.0 V).
         Args:
             channel: int for single, list for multiple, None for all channels
             target: 'GATE' or 'DRAIN' (required)
             voltage_V: float for single value, list for multiple values
+            linear: use the firmware's linear DAC sweep instead of the bracketing search
         Returns:
             Single dict if setting one channel, list of dicts otherwise
         """
@@ -517,38 +779,40 @@ class DeviceController:
         # Case 1: Single channel, single value
         if isinstance(channel, int) and not isinstance(voltage_V, list):
             self._check_lna_channel(channel)
-            return self.lna[channel - 1].set_voltage(target, voltage_V)
+            return self.lna[channel - 1].set_voltage(target, voltage_V, linear)
         
         # Case 2: All channels, single value
         if channel is None and not isinstance(voltage_V, list):
-            return [self.lna[i].set_voltage(target, voltage_V) for i in range(self.num_lna)]
+            return [self.lna[i].set_voltage(target, voltage_V, linear) for i in range(self.num_lna)]
         
         # Case 3: All channels, array of values
         if channel is None and isinstance(voltage_V, list):
             if len(voltage_V) != self.num_lna:
                 raise ValueError(f"voltage_V list length {len(voltage_V)} must match num_lna {self.num_lna}")
-            return [self.lna[i].set_voltage(target, voltage_V[i]) for i in range(self.num_lna)]
+            return [self.lna[i].set_voltage(target, voltage_V[i], linear) for i in range(self.num_lna)]
         
         # Case 4: Array of channels, single value
         if isinstance(channel, list) and not isinstance(voltage_V, list):
-            return [self.lna[ch - 1].set_voltage(target, voltage_V) for ch in channel]
+            return [self.lna[ch - 1].set_voltage(target, voltage_V, linear) for ch in channel]
         
         # Case 5: Array of channels, array of values
         if isinstance(channel, list) and isinstance(voltage_V, list):
             if len(channel) != len(voltage_V):
                 raise ValueError(f"channel and voltage_V lists must have same length")
-            return [self.lna[ch - 1].set_voltage(target, v) for ch, v in zip(channel, voltage_V)]
+            return [self.lna[ch - 1].set_voltage(target, v, linear) for ch, v in zip(channel, voltage_V)]
         raise ValueError("Invalid combination of channel and voltage_V arguments")
 
     def lna_set_current(self,
                         channel: Union[int, List[int], None] = None,
                         target: Union[str, None] = None,
-                        current_mA: Union[float, List[float], None] = None) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
+                        current_mA: Union[float, List[float], None] = None,
+                        linear: bool = False) -> Union[Dict[str, Any], List[Dict[str, Any]]]:
         """Set LNA current for target (0.0-64.0 mA).
         Args:
             channel: int for single, list for multiple, None for all channels
             target: 'GATE' or 'DRAIN' (required)
             current_mA: float for single value, list for multiple values
+            linear: use the firmware's linear DAC sweep instead of the bracketing search
         Returns:
             Single dict if setting one channel, list of dicts otherwise
         """
@@ -559,27 +823,27 @@ class DeviceController:
         # Case 1: Single channel, single value
         if isinstance(channel, int) and not isinstance(current_mA, list):
             self._check_lna_channel(channel)
-            return self.lna[channel - 1].set_current(target, current_mA)
+            return self.lna[channel - 1].set_current(target, current_mA, linear)
         
         # Case 2: All channels, single value
         if channel is None and not isinstance(current_mA, list):
-            return [self.lna[i].set_current(target, current_mA) for i in range(self.num_lna)]
+            return [self.lna[i].set_current(target, current_mA, linear) for i in range(self.num_lna)]
         
         # Case 3: All channels, array of values
         if channel is None and isinstance(current_mA, list):
             if len(current_mA) != self.num_lna:
                 raise ValueError(f"current_mA list length {len(current_mA)} must match num_lna {self.num_lna}")
-            return [self.lna[i].set_current(target, current_mA[i]) for i in range(self.num_lna)]
+            return [self.lna[i].set_current(target, current_mA[i], linear) for i in range(self.num_lna)]
         
         # Case 4: Array of channels, single value
         if isinstance(channel, list) and not isinstance(current_mA, list):
-            return [self.lna[ch - 1].set_current(target, current_mA) for ch in channel]
+            return [self.lna[ch - 1].set_current(target, current_mA, linear) for ch in channel]
         
         # Case 5: Array of channels, array of values
         if isinstance(channel, list) and isinstance(current_mA, list):
             if len(channel) != len(current_mA):
                 raise ValueError(f"channel and current_mA lists must have same length")
-            return [self.lna[ch - 1].set_current(target, curr) for ch, curr in zip(channel, current_mA)]
+            return [self.lna[ch - 1].set_current(target, curr, linear) for ch, curr in zip(channel, current_mA)]
         
         raise ValueError("Invalid combination of channel and current_mA arguments")
 
@@ -686,6 +950,12 @@ class DeviceController:
         self._check_lna_channel(channel)
         return self.lna[channel - 1]
 
+    def _check_unique_channels(self, channels: List[int]) -> None:
+        """Reject a channel list that names a channel twice; a batch sets each channel once."""
+        duplicates = sorted({ch for ch in channels if channels.count(ch) > 1})
+        if duplicates:
+            raise ValueError(f"channel list repeats {duplicates}")
+
     def _check_tes_channel(self, channel: int) -> None:
         """Validate a TES channel is within configured bounds (1-based)."""
         if not isinstance(channel, int):
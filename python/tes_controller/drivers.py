@@ -3,6 +3,26 @@ from typing import Optional, Dict, Any
 class CommandError(RuntimeError):
     pass
 
+ADC_PROFILES = ('DEFAULT', 'MONITOR', 'FAST')
+
+def response_result(resp) -> Dict[str, Any]:
+    """The 'result' of a response envelope; raises CommandError for an error response."""
+    if not isinstance(resp, dict):
+        raise CommandError('Invalid response type')
+    status = resp.get('status')
+    if status == 'error' or (isinstance(status, str) and status.lower() == 'error'):
+        raise CommandError({'status': status, 'result': resp.get('result')})
+    return resp.get('result') or {}
+
+def _address_list(*addresses: Optional[int]) -> str:
+    """HUB[:PART...] in hex for ADDR; parts are positional, so only trailing ones may be None."""
+    given = list(addresses)
+    while given and given[-1] is None:
+        given.pop()
+    if None in given:
+        raise ValueError("only trailing addresses may be left out")
+    return ":".join(f"{a:02X}" for a in given)
+
 class FluxRampController:
     def __init__(self, client):
         self.client = client
@@ -30,6 +50,142 @@ class FluxRampController:
         cmd = "DAC GET"
         return self._req(cmd)
     
+class SystemController:
+    """Wrapper for crate-wide commands that are not bound to a channel."""
+
+    def __init__(self, client):
+        self.client = client
+
+    def _req(self, cmd: str, timeout: Optional[float] = None) -> Dict[str, Any]:
+        resp = self.client.command_and_read(cmd, timeout=timeout)
+        if not isinstance(resp, dict):
+            raise CommandError('Invalid response type')
+        status = resp.get('status')
+        if status == 'error' or (isinstance(status, str) and status.lower() == 'error'):
+            raise CommandError(resp)
+        return resp.get('result') or {}
+
+    def snapshot(self) -> Dict[str, Any]:
+        cmd = "SNAPSHOT"
+        return self._req(cmd)
+
+    def tes_set_currents(self, targets: Dict[int, float], timeout: float = 5.0) -> Dict[str, Any]:
+        """Set several TES channels in one interleaved search (TESSET).
+
+        targets maps 1-based channel to current in mA. The search holds the
+        line for roughly 21 settle periods, hence the longer default timeout.
+        """
+        if not targets:
+            raise ValueError("targets must not be empty")
+        for ch, mA in targets.items():
+            assert 0 <= mA <= 20.0, "current_mA must be between 0 and 20.0"
+        pairs = ",".join(f"{ch}:{mA:.4f}" for ch, mA in targets.items())
+        cmd = f"TESSET {pairs}"
+        return self._req(cmd, timeout=timeout)
+
+    def tes_set_currents_async(self, targets: Dict[int, float]) -> int:
+        """Start a TESSET as a background job and return its job ID."""
+        if not targets:
+            raise ValueError("targets must not be empty")
+        pairs = ",".join(f"{ch}:{mA:.4f}" for ch, mA in targets.items())
+        cmd = f"TESSETASYNC {pairs}"
+        return self._req(cmd)['job_id']
+
+    def job_list(self) -> Dict[str, Any]:
+        cmd = "JOB LIST"
+        return self._req(cmd)
+
+    def job_status(self, job_id: int) -> Dict[str, Any]:
+        cmd = f"JOB STATUS {job_id}"
+        return self._req(cmd)
+
+    def job_cancel(self, job_id: int) -> Dict[str, Any]:
+        cmd = f"JOB CANCEL {job_id}"
+        return self._req(cmd)
+
+    def history(self, kind: str, channel: int) -> Dict[str, Any]:
+        """HISTORY for one series; kind is 'TES', 'DRAIN' or 'GATE'."""
+        cmd = f"HISTORY {kind.upper()}:{channel}"
+        return self._req(cmd)
+
+    def sub_add(self, source: str, deadband: float, heartbeat_ms: int = 0) -> Dict[str, Any]:
+        """SUB ADD; deadband in mA for currents, mV for voltages."""
+        cmd = f"SUB ADD {source.upper()} {deadband:.4f} {int(heartbeat_ms)}"
+        return self._req(cmd)
+
+    def sub_remove(self, sub_id: int) -> Dict[str, Any]:
+        cmd = f"SUB REMOVE {sub_id}"
+        return self._req(cmd)
+
+    def sub_list(self) -> Dict[str, Any]:
+        cmd = "SUB LIST"
+        return self._req(cmd)
+
+    def sub_clear(self) -> Dict[str, Any]:
+        cmd = "SUB CLEAR"
+        return self._req(cmd)
+
+    def stats(self) -> Dict[str, Any]:
+        cmd = "STATS"
+        return self._req(cmd)
+
+    def stats_reset(self) -> Dict[str, Any]:
+        cmd = "STATS RESET"
+        return self._req(cmd)
+
+    def mem(self) -> Dict[str, Any]:
+        """MEM: free RAM and its low-water mark (None where not measurable)."""
+        cmd = "MEM"
+        return self._req(cmd)
+
+    def mem_reset(self) -> Dict[str, Any]:
+        cmd = "MEM RESET"
+        return self._req(cmd)
+
+    def addr(self) -> Dict[str, Any]:
+        """ADDR: card addresses in use, and whether a stored map supplied them."""
+        cmd = "ADDR"
+        return self._req(cmd)
+
+    def addr_tes(self, channel: int, hub: int, ina: Optional[int] = None, tca: Optional[int] = None) -> Dict[str, Any]:
+        """ADDR TES; stores the card's addresses for the next reset. Parts left as None keep theirs."""
+        cmd = f"ADDR TES {channel} {_address_list(hub, ina, tca)}"
+        return self._req(cmd)
+
+    def addr_lna(self, channel: int, hub: int, dac: Optional[int] = None, ina_drain: Optional[int] = None,
+                 ina_gate: Optional[int] = None) -> Dict[str, Any]:
+        """ADDR LNA; stores the card's addresses for the next reset. Parts left as None keep theirs."""
+        cmd = f"ADDR LNA {channel} {_address_list(hub, dac, ina_drain, ina_gate)}"
+        return self._req(cmd)
+
+    def addr_clear(self) -> Dict[str, Any]:
+        cmd = "ADDR CLEAR"
+        return self._req(cmd)
+
+    def boot(self) -> Dict[str, Any]:
+        """BOOT: boot timing and empty card slots; ready_ms is None while cards are being set up."""
+        cmd = "BOOT"
+        return self._req(cmd)
+
+    def topology(self) -> Dict[str, Any]:
+        """TOPOLOGY: the I2C tree as last scanned, without touching the bus."""
+        cmd = "TOPOLOGY"
+        return self._req(cmd)
+
+    def topology_scan(self) -> Dict[str, Any]:
+        """TOPOLOGY SCAN: probe every card's hub and expected parts."""
+        cmd = "TOPOLOGY SCAN"
+        return self._req(cmd)
+
+    def topology_rescan(self, kind: str, channel: int, reset: bool = False) -> Dict[str, Any]:
+        """TOPOLOGY RESCAN; kind is "TES" or "LNA". Also sweeps the card for unlisted devices.
+
+        A present card keeps its state; reset=True sends TOPOLOGY RESET, which
+        sets the card up again as at boot (after a swap).
+        """
+        cmd = f"TOPOLOGY {'RESET' if reset else 'RESCAN'} {kind.upper()} {channel}"
+        return self._req(cmd)
+
 class TesController:
     """High-level wrapper for TES commands.
 
@@ -71,6 +227,12 @@ class TesController:
         cmd = f"TES {self.channel} SET {current_mA}"
         return self._req(cmd)
     
+    def set_current_async(self, current_mA: float) -> int:
+        """Start the SET search as a background job and return its job ID."""
+        assert 0 <= current_mA <= 20.0, "current_mA must be between 0 and 20.0"
+        cmd = f"TES {self.channel} SETASYNC {current_mA}"
+        return self._req(cmd)['job_id']
+
     def inc_current(self, delta_mA: int) -> Dict[str, Any]:
         cmd = f"TES {self.channel} INC {delta_mA}"
         return self._req(cmd)
@@ -108,6 +270,26 @@ class TesController:
         cmd = f"TES {self.channel} POWER"
         return self._req(cmd)
 
+    def calibrate(self) -> Dict[str, Any]:
+        """Measure per-bit weights so SET can use a single write."""
+        cmd = f"TES {self.channel} CAL"
+        return self._req(cmd)
+
+    def get_calibration(self) -> Dict[str, Any]:
+        cmd = f"TES {self.channel} CALGET"
+        return self._req(cmd)
+
+    def clear_calibration(self) -> Dict[str, Any]:
+        cmd = f"TES {self.channel} CALCLEAR"
+        return self._req(cmd)
+
+    def set_adc_profile(self, profile: str) -> Dict[str, Any]:
+        """INA219 profile: 'DEFAULT', 'MONITOR' (128-sample averaging) or 'FAST' (9-bit, triggered)."""
+        if profile.upper() not in ADC_PROFILES:
+            raise ValueError(f"profile must be one of {ADC_PROFILES}")
+        cmd = f"TES {self.channel} ADC {profile.upper()}"
+        return self._req(cmd)
+
 
 class LnaController:
     """Wrapper for LNA commands (gate/drain).
@@ -149,24 +331,50 @@ class LnaController:
         cmd = f"LNA {self.channel} {target} DISABLE"
         return self._req(cmd)
 
+    def set_adc_profile(self, target: str, profile: str) -> Dict[str, Any]:
+        """INA219 profile: 'DEFAULT', 'MONITOR' (128-sample averaging) or 'FAST' (9-bit, triggered)."""
+        self._check_target(target)
+        if profile.upper() not in ADC_PROFILES:
+            raise ValueError(f"profile must be one of {ADC_PROFILES}")
+        cmd = f"LNA {self.channel} {target} ADC {profile.upper()}"
+        return self._req(cmd)
+
     def set_dac(self, target: str, value: int) -> Dict[str, Any]:
         assert 0 <= value <= 0xFFFF, "value must be between 0 and 0xFFFF"
         self._check_target(target)
         cmd = f"LNA {self.channel} {target} SET {value}"
         return self._req(cmd)
     
-    def set_voltage(self, target: str, voltage_V: float) -> Dict[str, Any]:
+    def set_voltage(self, target: str, voltage_V: float, linear: bool = False) -> Dict[str, Any]:
+        """linear=True uses the original one-code-at-a-time sweep (SETVLIN)."""
         assert 0.0 <= voltage_V <= 5.0, "voltage must be between 0.0 and 5.0V"
         self._check_target(target)
-        cmd = f"LNA {self.channel} {target} SETV {voltage_V}"
+        verb = "SETVLIN" if linear else "SETV"
+        cmd = f"LNA {self.channel} {target} {verb} {voltage_V}"
         return self._req(cmd)
     
-    def set_current(self, target: str, current_mA: float) -> Dict[str, Any]:
+    def set_current(self, target: str, current_mA: float, linear: bool = False) -> Dict[str, Any]:
+        """linear=True uses the original one-code-at-a-time sweep (SETMALIN)."""
         assert 0.0 <= current_mA <= 64.0, "current must be between 0.0 and 64.0 mA"
         self._check_target(target)
-        cmd = f"LNA {self.channel} {target} SETMA {current_mA}"
+        verb = "SETMALIN" if linear else "SETMA"
+        cmd = f"LNA {self.channel} {target} {verb} {current_mA}"
         return self._req(cmd)
 
+    def set_voltage_async(self, target: str, voltage_V: float) -> int:
+        """Start the SETV search as a background job and return its job ID."""
+        assert 0.0 <= voltage_V <= 5.0, "voltage must be between 0.0 and 5.0V"
+        self._check_target(target)
+        cmd = f"LNA {self.channel} {target} SETVASYNC {voltage_V}"
+        return self._req(cmd)['job_id']
+
+    def set_current_async(self, target: str, current_mA: float) -> int:
+        """Start the SETMA search as a background job and return its job ID."""
+        assert 0.0 <= current_mA <= 64.0, "current must be between 0.0 and 64.0 mA"
+        self._check_target(target)
+        cmd = f"LNA {self.channel} {target} SETMAASYNC {current_mA}"
+        return self._req(cmd)['job_id']
+
     def get_all(self, target: str) -> Dict[str, Any]:
         self._check_target(target)
         cmd = f"LNA {self.channel} {target} GET"
@@ -0,0 +1,145 @@
+"""Incremental parser for the firmware's YAML responses.
+
+The firmware only emits a small subset of YAML:
+
+    ---
+    id: 42              (when the request carried one)
+    status: ok
+    result:
+      key: "string"
+      key: 12 / -3.5 / true / null
+      key: [1, 2.5, null]
+    <blank line>
+
+ResponseParser is fed one line at a time and builds the typed dict
+directly. A line outside that subset (a nested list or mapping, an
+escape other than \\\\ and \\") switches the block to yaml.safe_load once it
+is complete, so any response still parses exactly as before.
+"""
+import re
+import yaml
+from typing import Any, Dict, List, Optional
+
+_KEY_VALUE = re.compile(r'^( {0,2})([A-Za-z_][A-Za-z0-9_]*):(?: (.*))?$')
+_INT = re.compile(r'^-?(?:0|[1-9][0-9]*)$')
+_FLOAT = re.compile(r'^-?[0-9]+\.[0-9]+$')
+_NO_VALUE = object()
+
+
+def _scalar(text: str):
+    """The value PyYAML would give for a plain or double-quoted scalar, or
+    _NO_VALUE when the fast path does not cover it."""
+    if text.startswith('[') and text.endswith(']'):
+        # Flat flow list of plain scalars, e.g. weights_mA: [0.000019, ...]
+        body = text[1:-1].strip()
+        if any(c in body for c in '[]{}"\\\''):
+            return _NO_VALUE
+        items = [_scalar(item.strip()) for item in body.split(',')] if body else []
+        return _NO_VALUE if any(item is _NO_VALUE for item in items) else items
+    if text.startswith('"'):
+        if len(text) < 2 or not text.endswith('"'):
+            return _NO_VALUE
+        body = text[1:-1]
+        if '\\' in body:
+            body = body.replace('\\\\', '\x00').replace('\\"', '"')
+            if '\\' in body:
+                return _NO_VALUE
+            body = body.replace('\x00', '\\')
+        elif '"' in body:
+            return _NO_VALUE
+        return body
+    if _INT.match(text):
+        return int(text)
+    if _FLOAT.match(text):
+        return float(text)
+    if text == 'true':
+        return True
+    if text == 'false':
+        return False
+    if text in ('null', '~'):
+        return None
+    if text in ('ok', 'error'):  # status values
+        return text
+    return _NO_VALUE
+
+
+class ResponseParser:
+    """Feed lines from '---' to the terminating blank line.
+
+    Usage:
+        parser = ResponseParser()
+        while not parser.feed(next_line()):
+            pass
+        resp = parser.response()
+    """
+
+    def __init__(self):
+        self._lines: List[str] = []
+        self._top: Dict[str, Any] = {}
+        self._result: Optional[Dict[str, Any]] = None
+        self._slow = False
+        self.done = False
+
+    def feed(self, line: str) -> bool:
+        """Add one line (without its newline); True once the block is complete."""
+        self._lines.append(line)
+        if not line.strip():
+            if len(self._lines) > 1:
+                self.done = True
+            return self.done
+        if self._slow or line == '---':
+            return False
+        match = _KEY_VALUE.match(line)
+        if not match:
+            self._slow = True
+            return False
+        indent, key, text = match.groups()
+        if not indent:
+            if text is None or text == '':
+                if key != 'result':
+                    self._slow = True
+                    return False
+                self._result = {}
+                self._top['result'] = None  # As YAML has it until a key follows
+                return False
+            value = _scalar(text)
+            self._result = None
+        elif self._result is not None and text:
+            value = _scalar(text)
+        else:
+            self._slow = True
+            return False
+        if value is _NO_VALUE:
+            self._slow = True
+            return False
+        if indent:
+            self._result[key] = value
+            self._top['result'] = self._result
+        else:
+            self._top[key] = value
+        return False
+
+    def response(self) -> dict:
+        """The parsed block, in the same shape yaml.safe_load would return."""
+        if not self._slow:
+            return self._top
+        raw = '\n'.join(self._lines)
+        try:
+            parsed = yaml.safe_load(raw)
+        except Exception as e:
+            return {'status': 'parse_error', 'raw': raw, 'error': str(e)}
+        return parsed
+
+    @property
+    def raw(self) -> str:
+        return '\n'.join(self._lines)
+
+
+def parse_response(raw: str) -> dict:
+    """Parse a whole response block (e.g. one already read as text)."""
+    parser = ResponseParser()
+    for line in raw.split('\n'):
+        parser.feed(line.rstrip('\r'))
+    if not parser.done:
+        parser.feed('')
+    return parser.response()
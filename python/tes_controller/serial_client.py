@@ -1,19 +1,215 @@
+import collections
+import queue
 import serial
+import struct
+import threading
 import time
-import yaml
+from typing import List, Optional
+
+from .response import ResponseParser
+
+# ---------------------------------------------------------------------------
+# Binary framed protocol (see firmware/src/protocol/BinaryLink.h). Frames are
+# COBS-encoded and end in 0x00; decoded they are
+#   request:  opcode, seq, payload, crc16
+#   response: opcode, seq, status, payload, crc16
+# with little-endian fields and CRC-16/CCITT-FALSE.
+
+BIN_PROTOCOL_VERSION = 1
+BIN_OP_PING = 0x01
+BIN_OP_TEXT = 0x02
+
+BIN_ERRORS = {
+    40: 'UNKNOWN_OPCODE',
+    41: 'BAD_LENGTH',
+    42: 'BAD_FRAME',
+    43: 'CHANNEL_BUSY',
+}
+
+# Text command bytes the firmware queues (REQUEST_RX_BUFFER_SIZE); pipeline()
+# keeps no more than this in flight
+REQUEST_RX_BUFFER_SIZE = 512
+
+LNA_TARGETS = ('DRAIN', 'GATE')
+TES_SET_METHODS = ('search', 'model', 'model_fallback')
+
+# name: (opcode, request fields, response fields). Fields are (key, struct
+# code). Keys ending in _mV/_mA/_mW travel as micro-units and _V as
+# microvolts; they are scaled so results carry the same keys and units as
+# the YAML responses (tca_bits is an int rather than a hex string).
+BINARY_COMMANDS = {
+    'PING': (BIN_OP_PING, (), (('protocol_version', 'B'),)),
+    'TEXT': (BIN_OP_TEXT, (), ()),
+    'TES_GET': (0x10, (('channel', 'B'),),
+                (('enabled', 'B'), ('tca_bits', 'I'), ('shunt_mV', 'i'), ('bus_V', 'i'),
+                 ('current_mA', 'i'), ('power_mW', 'i'), ('timestamp_us', 'I'), ('duration_us', 'I'))),
+    'TES_SET': (0x11, (('channel', 'B'), ('current_mA', 'i')),
+                (('current_mA', 'i'), ('tca_bits', 'I'), ('method', 'B'), ('elapsed_ms', 'I'))),
+    'TES_SETINT': (0x12, (('channel', 'B'), ('tca_bits', 'I')), (('tca_bits', 'I'),)),
+    'TES_BITS': (0x13, (('channel', 'B'),), (('tca_bits', 'I'),)),
+    'TES_CURRENT': (0x14, (('channel', 'B'),), (('current_mA', 'i'),)),
+    'TES_ENABLE': (0x15, (('channel', 'B'), ('enabled', 'B')), (('enabled', 'B'),)),
+    'LNA_GET': (0x20, (('channel', 'B'), ('target', 'B')),
+                (('enabled', 'B'), ('dac_value', 'H'), ('shunt_mV', 'i'), ('bus_V', 'i'),
+                 ('current_mA', 'i'), ('power_mW', 'i'), ('timestamp_us', 'I'), ('duration_us', 'I'))),
+    'LNA_SETMA': (0x21, (('channel', 'B'), ('target', 'B'), ('current_mA', 'i')),
+                  (('current_mA', 'i'), ('dac_value', 'H'), ('iterations', 'H'), ('elapsed_ms', 'I'))),
+    'LNA_SETV': (0x22, (('channel', 'B'), ('target', 'B'), ('voltage_V', 'i')),
+                 (('voltage_V', 'i'), ('dac_value', 'H'), ('iterations', 'H'), ('elapsed_ms', 'I'))),
+    'LNA_SETDAC': (0x23, (('channel', 'B'), ('target', 'B'), ('value', 'H')), (('value', 'H'),)),
+    'LNA_CURRENT': (0x24, (('channel', 'B'), ('target', 'B')), (('current_mA', 'i'),)),
+    'LNA_ENABLE': (0x25, (('channel', 'B'), ('target', 'B'), ('enabled', 'B')), (('enabled', 'B'),)),
+    'DAC_SET': (0x30, (('value', 'H'),), (('value', 'H'),)),
+    'DAC_GET': (0x31, (), (('value', 'H'),)),
+}
+
+
+def crc16_ccitt(data: bytes) -> int:
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray([0])
+    code_pos = 0
+    for b in data:
+        if b == 0:
+            out[code_pos] = len(out) - code_pos
+            code_pos = len(out)
+            out.append(0)
+            continue
+        out.append(b)
+        if len(out) - code_pos == 0xFF:
+            out[code_pos] = 0xFF
+            code_pos = len(out)
+            out.append(0)
+    out[code_pos] = len(out) - code_pos
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError('malformed COBS frame')
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def _field_scale(key: str) -> float:
+    if key.endswith(('_mV', '_mA', '_mW')):
+        return 1e3
+    if key.endswith('_V'):
+        return 1e6
+    return 1
+
+
+def encode_payload(name: str, **args) -> bytes:
+    """Pack the request payload of a BINARY_COMMANDS entry."""
+    _, req_fields, _ = BINARY_COMMANDS[name]
+    values = []
+    for key, _code in req_fields:
+        value = args[key]
+        if key == 'target':
+            value = LNA_TARGETS.index(str(value).upper())
+        elif key == 'enabled':
+            value = 1 if value else 0
+        else:
+            scale = _field_scale(key)
+            value = int(round(value * scale)) if scale != 1 else int(value)
+        values.append(value)
+    return struct.pack('<' + ''.join(c for _, c in req_fields), *values)
+
+
+def encode_frame(body: bytes) -> bytes:
+    """CRC and COBS-encode a decoded frame, and add the delimiter."""
+    crc = crc16_ccitt(body)
+    return cobs_encode(body + struct.pack('<H', crc)) + b'\x00'
+
+
+def decode_frame(frame: bytes):
+    """Decode one response frame (without its delimiter) into
+    (opcode, seq, status, payload). Raises ValueError on a bad frame."""
+    body = cobs_decode(frame)
+    if len(body) < 5:
+        raise ValueError('short frame')
+    if crc16_ccitt(body[:-2]) != struct.unpack('<H', body[-2:])[0]:
+        raise ValueError('CRC mismatch')
+    return body[0], body[1], body[2], body[3:-2]
+
+
+def decode_response(name: str, status: int, payload: bytes, **args) -> dict:
+    """Turn a response into the same {'status', 'result'} envelope as the
+    YAML responses. The request's channel and target are echoed."""
+    _, req_fields, resp_fields = BINARY_COMMANDS[name]
+    result = {'command': name}
+    for key in ('channel', 'target'):
+        if key in args:
+            result[key] = str(args[key]).upper() if key == 'target' else args[key]
+    if status:
+        result['error'] = BIN_ERRORS.get(status, f'{name}_ERROR')
+        result['code'] = status
+        return {'status': 'error', 'result': result}
+    fmt = '<' + ''.join(c for _, c in resp_fields)
+    if struct.calcsize(fmt) != len(payload):
+        raise ValueError(f'{name}: expected {struct.calcsize(fmt)} payload bytes, got {len(payload)}')
+    for (key, _code), value in zip(resp_fields, struct.unpack(fmt, payload)):
+        if key == 'enabled':
+            value = bool(value)
+        elif key == 'method':
+            value = TES_SET_METHODS[value] if value < len(TES_SET_METHODS) else value
+        elif _field_scale(key) != 1:
+            value = value / _field_scale(key)
+        result[key] = value
+    return {'status': 'ok', 'result': result}
+
+
+def _command_error(line: str) -> dict:
+    """Envelope for a command rejected by the firmware's parser (unknown
+    command, bad argument), which answers with a bare 'ERROR: ...' line."""
+    return {'status': 'error', 'result': {'error': 'COMMAND_ERROR', 'message': line}}
+
 
 class SerialClient:
     """Simple serial client to send a single-line command and read a YAML block response.
 
     The sketch prints a YAML block beginning with '---' and ending with a blank line.
     This class sends the command followed by a CRLF and reads until a blank line is seen.
+
+    With request_ids (the default) each command is sent as '@<id> COMMAND'
+    and the firmware echoes 'id: <id>' in the response, so a late response
+    to a timed-out command is recognised and skipped. pipeline() uses the ids
+    to keep several commands in flight.
+
+    Unsolicited lines starting with '#' (e.g. '#SUB ...') go to the handler
+    registered for their tag with add_push_handler(). They are dispatched
+    while a response is being read, and, once start_listener() is called,
+    from a background thread that then reads every line.
     """
 
-    def __init__(self, port: str, baud: int = 115200, timeout: float = 1.0):
+    def __init__(self, port: str, baud: int = 115200, timeout: float = 1.0, request_ids: bool = True):
         self.port = port
         self.baud = baud
         self.timeout = timeout
+        self.request_ids = request_ids
+        self._request_id = 0
         self._serial = None
+        self.binary = False  # True between enter_binary() and exit_binary()
+        self._seq = 0
+        self._rx = bytearray()   # Received bytes not yet consumed
+        self._push_handlers = {}
+        self._blocks = queue.Queue()     # Response blocks read by the listener
+        self._listener = None
+        self._listener_stop = threading.Event()
 
     def open(self):
         if self._serial and self._serial.is_open:
@@ -23,12 +219,14 @@ class SerialClient:
         time.sleep(0.1)
 
     def close(self):
+        self.stop_listener()
         if self._serial:
             try:
                 self._serial.close()
             except Exception:
                 pass
             self._serial = None
+            self.binary = False
 
     def send_command(self, cmd: str):
         """Send a command line to the device. Newline is appended automatically."""
@@ -37,54 +235,252 @@ class SerialClient:
         line = cmd.strip() + "\r\n"
         self._serial.write(line.encode('utf-8'))
 
-    def _read_block(self, timeout: float = None) -> str:
-        """Read a YAML block from serial. Returns the raw string (including leading '---')."""
+    # ----- Unsolicited lines ---------------------------------------------------
+    def add_push_handler(self, tag: str, handler):
+        """Call handler(text) for each '<tag> text' line, e.g. tag '#SUB'.
+
+        Handlers run on the reading thread and must not send commands.
+        """
+        self._push_handlers[tag] = handler
+
+    def remove_push_handler(self, tag: str):
+        self._push_handlers.pop(tag, None)
+
+    def _dispatch_push(self, line: str) -> bool:
+        """Hand a '#' line to its handler; True if the line was a push line."""
+        if not line.startswith('#'):
+            return False
+        tag, _, text = line.partition(' ')
+        handler = self._push_handlers.get(tag)
+        if handler:
+            handler(text)
+        return True
+
+    @property
+    def listening(self) -> bool:
+        return self._listener is not None
+
+    def start_listener(self):
+        """Read the port from a background thread, so push lines are handled
+        between commands too. Responses are then passed to read_response()
+        through a queue."""
+        if self._listener:
+            return
         if not self._serial or not self._serial.is_open:
             self.open()
-        end_time = time.time() + (timeout if timeout is not None else self.timeout)
-        lines = []
-        saw_start = False
-        while True:
-            if time.time() > end_time:
-                break
-            raw = self._serial.readline()
-            if not raw:
+        self._listener_stop.clear()
+        self._listener = threading.Thread(target=self._listen, name='tes-listener', daemon=True)
+        self._listener.start()
+
+    def stop_listener(self):
+        if not self._listener:
+            return
+        self._listener_stop.set()
+        self._listener.join()
+        self._listener = None
+
+    def _listen(self):
+        parser = None
+        while not self._listener_stop.is_set():
+            line = self._readline()
+            if line is None:
+                continue
+            if parser is None:
+                if line.strip() == '---':
+                    parser = ResponseParser()
+                    parser.feed(line)
+                elif line.startswith('ERROR'):
+                    self._blocks.put(_command_error(line))
+                else:
+                    self._dispatch_push(line)
                 continue
+            if parser.feed(line):
+                self._blocks.put(parser.response())
+                parser = None
+
+    def _fill(self) -> bool:
+        """Append whatever the port has (at least one byte, or wait for the
+        port timeout) to the receive buffer; False if nothing came."""
+        chunk = self._serial.read(max(1, getattr(self._serial, 'in_waiting', 0)))
+        if not chunk:
+            return False
+        self._rx += chunk
+        return True
+
+    def _readline(self) -> Optional[str]:
+        """Next line from the receive buffer, or None if the port timed out
+        first (a partial line stays buffered)."""
+        while True:
+            end = self._rx.find(b'\n')
+            if end >= 0:
+                raw = bytes(self._rx[:end])
+                del self._rx[:end + 1]
+                return raw.decode('utf-8', errors='ignore').rstrip('\r')
+            if not self._fill():
+                return None
+
+    def read_response(self, timeout: float = None) -> dict:
+        """Read a response and return it parsed as a dict.
+
+        Returns a dict with at least a 'status' key and 'result' mapping (if present).
+        A command rejected by the firmware's parser ('ERROR: ...') comes back
+        as a COMMAND_ERROR envelope. If no response is received, raises RuntimeError.
+        """
+        if not self._serial or not self._serial.is_open:
+            self.open()
+        timeout = timeout if timeout is not None else self.timeout
+        if self._listener:
             try:
-                line = raw.decode('utf-8', errors='ignore').rstrip('\r\n')
-            except Exception:
-                line = raw.decode('latin-1', errors='ignore').rstrip('\r\n')
-            if not saw_start:
+                return self._blocks.get(timeout=timeout)
+            except queue.Empty:
+                raise RuntimeError('No response from device')
+        end_time = time.time() + timeout
+        parser = None
+        while time.time() <= end_time:
+            line = self._readline()
+            if line is None:
+                continue
+            if parser is None:
                 if line.strip() == '---':
-                    saw_start = True
-                    lines.append(line)
+                    parser = ResponseParser()
+                    parser.feed(line)
+                elif line.startswith('ERROR'):
+                    return _command_error(line)
                 else:
-                    # skip any startup noise until the YAML block
+                    # push lines go to their handlers; skip any startup noise until the YAML block
+                    self._dispatch_push(line)
+            elif parser.feed(line):
+                return parser.response()
+        raise RuntimeError('No response from device')
+
+    def _send_request(self, cmd: str) -> int:
+        """Send cmd with a fresh '@<id>' prefix and return the id."""
+        self._request_id = self._request_id % 999999999 + 1
+        self.send_command(f'@{self._request_id} {cmd.strip()}')
+        return self._request_id
+
+    def command_and_read(self, cmd: str, timeout: float = None) -> dict:
+        if not self.request_ids:
+            self.send_command(cmd)
+            return self.read_response(timeout=timeout)
+        request_id = self._send_request(cmd)
+        end_time = time.time() + (timeout if timeout is not None else self.timeout)
+        while True:
+            resp = self.read_response(timeout=max(0.0, end_time - time.time()))
+            if not isinstance(resp, dict):
+                continue
+            # Parser errors carry no id; responses are in order, so one
+            # arriving now belongs to this command
+            if resp.get('id') == request_id or 'id' not in resp and resp.get('status') == 'error':
+                return resp
+            # Otherwise a late response to an earlier, timed-out command
+
+    def pipeline(self, cmds: List[str], window: int = 4, timeout: float = None) -> List[dict]:
+        """Run several commands with up to window of them in flight.
+
+        Commands are sent ahead of their responses (never more than
+        REQUEST_RX_BUFFER_SIZE bytes unanswered), so the round trip is paid
+        once per window instead of once per command. Responses are returned
+        in command order; one that never arrived is an error envelope with
+        'NO_RESPONSE'. timeout applies to each response. Without request_ids
+        the commands run one at a time.
+        """
+        if not self.request_ids:
+            return [self.command_and_read(cmd, timeout=timeout) for cmd in cmds]
+        responses: List[Optional[dict]] = [None] * len(cmds)
+        in_flight = collections.deque()   # (id, index, bytes)
+        sent_bytes = 0
+        next_cmd = 0
+        while next_cmd < len(cmds) or in_flight:
+            while next_cmd < len(cmds) and len(in_flight) < window:
+                size = len(cmds[next_cmd]) + 14   # '@<id> ' and CRLF
+                if in_flight and sent_bytes + size > REQUEST_RX_BUFFER_SIZE:
+                    break
+                in_flight.append((self._send_request(cmds[next_cmd]), next_cmd, size))
+                sent_bytes += size
+                next_cmd += 1
+            try:
+                resp = self.read_response(timeout=timeout)
+            except RuntimeError:
+                # Nothing within timeout: give up on the oldest command only,
+                # so the responses already collected are kept
+                _, index, size = in_flight.popleft()
+                sent_bytes -= size
+                responses[index] = {'status': 'error', 'result': {'error': 'NO_RESPONSE'}}
+                continue
+            if not isinstance(resp, dict):
+                continue
+            if 'id' not in resp:
+                if resp.get('status') != 'error':
                     continue
+                match = in_flight[0][0]     # Parser error: the oldest command
             else:
-                lines.append(line)
-                # blank line ends the block
-                if line.strip() == '':
+                match = resp['id']
+                if all(request_id != match for request_id, _, _ in in_flight):
+                    continue                # Stale response from before this call
+            while in_flight:
+                request_id, index, size = in_flight.popleft()
+                sent_bytes -= size
+                if request_id == match:
+                    responses[index] = resp
                     break
-        return '\n'.join(lines)
+                responses[index] = {'status': 'error', 'result': {'error': 'NO_RESPONSE'}}
+        return responses
 
-    def read_response(self, timeout: float = None) -> dict:
-        """Read a response and return parsed YAML as a dict.
+    # ----- Binary protocol ---------------------------------------------------
+    def enter_binary(self) -> dict:
+        """Switch the device to the binary protocol with the BINARY command."""
+        if self._listener:
+            raise RuntimeError('stop_listener() before entering binary mode')
+        resp = self.command_and_read('BINARY')
+        if not isinstance(resp, dict) or resp.get('status') != 'ok':
+            raise RuntimeError(f'Device refused binary mode: {resp}')
+        self.binary = True
+        return resp
 
-        Returns a dict with at least a 'status' key and 'result' mapping (if present).
-        If no YAML block is received, raises RuntimeError.
+    def exit_binary(self) -> dict:
+        """Return the device to YAML text mode."""
+        resp = self.binary_command('TEXT')
+        self.binary = False
+        return resp
+
+    def _read_frame(self, end_time: float) -> bytes:
+        while time.time() < end_time:
+            end = self._rx.find(b'\x00')
+            if end < 0:
+                self._fill()
+                continue
+            frame = bytes(self._rx[:end])
+            del self._rx[:end + 1]
+            if frame:
+                return frame
+        raise RuntimeError('No response from device')
+
+    def binary_request(self, opcode: int, payload: bytes = b'', timeout: float = None):
+        """Send one raw request and return (status, payload) of its response.
+
+        Responses to earlier, timed-out requests are skipped by their seq.
         """
-        raw = self._read_block(timeout=timeout)
-        if not raw:
-            raise RuntimeError('No response from device')
-        # Parse YAML safely
-        try:
-            parsed = yaml.safe_load(raw)
-        except Exception as e:
-            # If YAML parse fails, return raw text in an envelope
-            return {'status': 'parse_error', 'raw': raw, 'error': str(e)}
-        return parsed
+        if not self._serial or not self._serial.is_open:
+            self.open()
+        self._seq = (self._seq + 1) & 0xFF
+        self._serial.write(encode_frame(bytes([opcode, self._seq]) + payload))
+        end_time = time.time() + (timeout if timeout is not None else self.timeout)
+        while True:
+            try:
+                r_opcode, r_seq, status, r_payload = decode_frame(self._read_frame(end_time))
+            except ValueError:
+                continue  # Line noise; the next delimiter resynchronises
+            if r_opcode == 0 and status == 42:
+                raise RuntimeError('Device rejected the frame (BAD_FRAME)')
+            if r_seq == self._seq and r_opcode == opcode:
+                return status, r_payload
 
-    def command_and_read(self, cmd: str, timeout: float = None) -> dict:
-        self.send_command(cmd)
-        return self.read_response(timeout=timeout)
+    def binary_command(self, name: str, timeout: float = None, **args) -> dict:
+        """Run a BINARY_COMMANDS entry, e.g. binary_command('TES_GET', channel=1).
+
+        Returns the same {'status', 'result'} envelope as read_response().
+        """
+        opcode = BINARY_COMMANDS[name][0]
+        status, r_payload = self.binary_request(opcode, encode_payload(name, **args), timeout=timeout)
+        return decode_response(name, status, r_payload, **args)
@@ -0,0 +1,168 @@
+import threading
+from array import array
+from typing import Dict, List, NamedTuple, Optional
+
+from .response import ResponseParser
+
+# Sampler kinds as reported by STREAM START, mapped to the STREAM CONFIG
+# keyword and the scale from the streamed micro-units to mA or V
+STREAM_KINDS = {
+    'tes_current_uA': ('TES', 1e-3),
+    'drain_current_uA': ('DRAIN', 1e-3),
+    'gate_current_uA': ('GATE', 1e-3),
+    'drain_voltage_uV': ('DRAINV', 1e-6),
+    'gate_voltage_uV': ('GATEV', 1e-6),
+}
+
+
+class StreamReader:
+    """Background reader for the firmware's STREAM output.
+
+    While streaming, the reader thread owns the serial port: do not send
+    other commands until stop() returns. Rows are accumulated into
+    array.array columns, which numpy.asarray() can take without copying.
+
+    Usage:
+        reader = StreamReader(client)
+        reader.configure(20, ['TES:1', 'TES:2', 'DRAIN:1'])
+        reader.start()
+        ...
+        reader.stop()
+        data = reader.arrays()   # {'t_s': ..., 'TES:1': ..., ...}
+    """
+
+    def __init__(self, client):
+        self.client = client
+        self.columns: List[str] = []
+        self._scales: List[float] = []
+        self._t_us = array('d')
+        self._values: List[array] = []
+        self._lock = threading.Lock()
+        self._thread: Optional[threading.Thread] = None
+        self._stop_result: Optional[dict] = None
+        self._stopped = threading.Event()
+        self._last_seq = None
+        self._last_us = None
+        self._wrap_us = 0
+        self.dropped = 0     # Rows missing from the sequence (device ring overflow)
+        self.error = None    # Exception that ended the reader thread, if any
+
+    def configure(self, period_ms: int, sources: List[str]) -> Dict:
+        """STREAM CONFIG, with sources such as 'TES:1', 'DRAIN:2', 'GATEV:2'."""
+        resp = self.client.command_and_read(f"STREAM CONFIG {int(period_ms)} {','.join(sources)}")
+        if resp.get('status') != 'ok':
+            raise RuntimeError(f'STREAM CONFIG failed: {resp}')
+        return resp.get('result') or {}
+
+    def start(self) -> Dict:
+        """STREAM START, then collect rows in a background thread."""
+        if self.client.listening:
+            raise RuntimeError('STREAM needs the port; unsubscribe everything first')
+        resp = self.client.command_and_read('STREAM START')
+        if resp.get('status') != 'ok':
+            raise RuntimeError(f'STREAM START failed: {resp}')
+        result = resp.get('result') or {}
+        self.columns = []
+        self._scales = []
+        for source in result.get('sources') or []:
+            keyword, scale = STREAM_KINDS[source['kind']]
+            self.columns.append(f"{keyword}:{source['channel']}")
+            self._scales.append(scale)
+        with self._lock:
+            self._t_us = array('d')
+            self._values = [array('d') for _ in self.columns]
+        self._last_seq = None
+        self._last_us = None
+        self._wrap_us = 0
+        self.dropped = 0
+        self.error = None
+        self._stop_result = None
+        self._stopped.clear()
+        self._thread = threading.Thread(target=self._run, name='tes-stream', daemon=True)
+        self._thread.start()
+        return result
+
+    def stop(self, timeout: float = 2.0) -> Dict:
+        """STREAM STOP; waits for the rows still buffered on the device."""
+        self.client.send_command('STREAM STOP')
+        if not self._stopped.wait(timeout):
+            raise RuntimeError('No STREAM STOP response from device')
+        self._thread.join()
+        if self.error:
+            raise self.error
+        return self._stop_result or {}
+
+    def arrays(self) -> Dict[str, array]:
+        """Copy of the columns so far: 't_s' (device time, seconds) and one
+        column per source in mA or V. Failed reads are NaN."""
+        with self._lock:
+            data = {'t_s': array('d', (t * 1e-6 for t in self._t_us))}
+            for name, values in zip(self.columns, self._values):
+                data[name] = array('d', values)
+        return data
+
+    def __len__(self):
+        return len(self._t_us)
+
+    def _run(self):
+        parser = None
+        try:
+            while True:
+                line = self.client._readline()
+                if line is None:
+                    continue
+                if parser is not None:
+                    if parser.feed(line):
+                        resp = parser.response() or {}
+                        parser = None
+                        result = resp.get('result') or {}
+                        if result.get('command') == 'STREAM_STOP':
+                            self._stop_result = result
+                            return
+                elif line.startswith('#STREAM '):
+                    self._add_row(line[8:])
+                elif line.strip() == '---':
+                    parser = ResponseParser()
+                    parser.feed(line)
+        except Exception as e:
+            self.error = e
+        finally:
+            self._stopped.set()
+
+    def _add_row(self, text: str):
+        fields = text.split(',')
+        if len(fields) != 2 + len(self.columns):
+            return
+        seq, t_us = int(fields[0]), int(fields[1])
+        if self._last_seq is not None and seq > self._last_seq + 1:
+            self.dropped += seq - self._last_seq - 1
+        self._last_seq = seq
+        # micros() wraps every 71.6 minutes
+        if self._last_us is not None and t_us < self._last_us:
+            self._wrap_us += 1 << 32
+        self._last_us = t_us
+        with self._lock:
+            self._t_us.append(float(t_us + self._wrap_us))
+            for column, scale, field in zip(self._values, self._scales, fields[2:]):
+                column.append(int(field) * scale if field else float('nan'))
+
+
+class SubReport(NamedTuple):
+    """One '#SUB id,time_ms,value,reason' line from a SUB ADD subscription."""
+    id: int
+    source: str             # e.g. 'DRAIN:2'
+    t_s: float              # Device time of the read (millis(), wraps after 49.7 days)
+    value: Optional[float]  # mA or V; None when reason is 'error'
+    reason: str             # 'initial', 'change', 'heartbeat' or 'error'
+
+
+def parse_sub_report(text: str, source: str, scale: float) -> SubReport:
+    """Parse the text after '#SUB ', scaling the micro-unit value by scale."""
+    sub_id, t_ms, value, reason = text.split(',')
+    return SubReport(int(sub_id), source, int(t_ms) * 1e-3,
+                     int(value) * scale if value else None, reason)
+
+
+def sub_report_id(text: str) -> int:
+    """Subscription id of the text after '#SUB ', without parsing the rest."""
+    return int(text.split(',', 1)[0])